@@ -1,12 +1,124 @@
 // std.gc
 
+// Information about a full garbage collection, times are in seconds
+class GCCollectionInfo
+{
+	double	startTime;
+	double	pauseTime;
+	double	markTime;
+	double	sweepTime;
+	double	finalizeTime;
+
+	long	bytesBefore;
+	long	bytesAfter;
+	long	objectsFreed;
+	long	rootsScanned;
+	long	objectsMoved;
+}
+
 class NamespaceGC
 {
 	void	CollectMemory();
+	void	Compact();
 
 	int		UsedMemory();
+	long	UsedMemoryLong();
 
 	double	MarkTime();
 	double	CollectTime();
+
+	int		Collections();
+	double	CollectionsPerSecond();
+
+	void	SetPolicy(double growthFactor, long minimumHeap, long maximumHeap);
+
+	bool	LastCollection(GCCollectionInfo ref info);
+	long	PauseHistogram(int bucket);
+	double	MaxPauseTime();
+	double	TotalPauseTime();
 }
 NamespaceGC GC;
+
+// Weak reference doesn't keep the object alive, it returns nullptr after the object is freed by the garbage collector
+class weak_ref<T>
+{
+	long	handle;
+}
+
+long		__weak_ref_create(auto ref target);
+auto ref	__weak_ref_get(long handle);
+
+void weak_ref:weak_ref(T ref target)
+{
+	handle = __weak_ref_create(target);
+}
+auto weak_ref:get()
+{
+	T ref result = nullptr;
+	auto ref target = __weak_ref_get(handle);
+	if(target)
+		result = target;
+	return result;
+}
+bool weak_ref:alive()
+{
+	return !!__weak_ref_get(handle);
+}
+
+// Entries of a weak hashmap are kept by the garbage collector and are released together with this object
+class weak_table
+{
+	int		id;
+}
+
+int			__weak_table_create(weak_table ref owner);
+auto ref	__weak_table_find(int id, auto ref key);
+void		__weak_table_set(int id, auto ref key, auto ref value);
+void		__weak_table_remove(int id, auto ref key);
+int			__weak_table_size(int id);
+void		__weak_table_clear(int id);
+
+// Hashmap with keys that are compared by address and don't keep the key objects alive
+// Entry is removed by the garbage collector when its key object is freed, value of an entry doesn't keep its key alive
+class weak_hashmap<Key, Value>
+{
+	weak_table ref	table;
+}
+
+void weak_hashmap:weak_hashmap()
+{
+	table = new weak_table;
+	table.id = __weak_table_create(table);
+}
+
+auto weak_hashmap:find(Key ref key)
+{
+	Value ref result = nullptr;
+	auto ref value = __weak_table_find(table.id, key);
+	if(value)
+		result = value;
+	return result;
+}
+auto operator[](weak_hashmap<@K, @V> ref m, typeof(m).target.Key ref key)
+{
+	auto x = m.find(key);
+	if(x) // if a key-value exists, return it
+		return x;
+
+	// otherwise, add
+	x = new typeof(m).target.Value;
+	__weak_table_set(m.table.id, key, x);
+	return x;
+}
+void weak_hashmap:remove(Key ref key)
+{
+	__weak_table_remove(table.id, key);
+}
+int weak_hashmap:size()
+{
+	return __weak_table_size(table.id);
+}
+void weak_hashmap:clear()
+{
+	__weak_table_clear(table.id);
+}
@@ -56,4 +56,24 @@ namespace memory
 	double	as_double(long value);
 	int		as_int(float value);
 	long	as_long(double value);
+
+	// Objects created with 'new' while an arena is active are placed into it and are released together with it
+	// Arena memory is not traced or freed by the garbage collector, but objects in it keep the objects they reference alive
+	class arena
+	{
+		int id;
+	}
+
+	// In debug mode, arena release checks that there are no reachable pointers to arena memory left
+	arena	arena_create();
+	arena	arena_create(bool debug);
+
+	// Arena scopes can be nested, the arena that was entered last receives the objects
+	void	arena_enter(arena a);
+	void	arena_leave();
+
+	void	arena_release(arena a);
+
+	// Memory used by the arena objects in bytes
+	long	arena_size(arena a);
 }
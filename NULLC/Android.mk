@@ -26,6 +26,7 @@ LOCAL_SRC_FILES += NULLC/InstructionTreeVm.cpp
 LOCAL_SRC_FILES += NULLC/InstructionTreeVmCommon.cpp
 LOCAL_SRC_FILES += NULLC/InstructionTreeVmEval.cpp
 LOCAL_SRC_FILES += NULLC/InstructionTreeVmGraph.cpp
+LOCAL_SRC_FILES += NULLC/JitDebugInfo.cpp
 LOCAL_SRC_FILES += NULLC/Lexer.cpp
 LOCAL_SRC_FILES += NULLC/Linker.cpp
 LOCAL_SRC_FILES += NULLC/nullc.cpp
@@ -2139,6 +2139,452 @@ void GetCodeCmdCallEpilogue(CodeGenRegVmContext &ctx, unsigned *microcode, unsig
 #endif
 }
 
+#if defined(_M_X64) && defined(__linux)
+// Argument of a direct call to an external function: a part of the call argument buffer placed in a single register
+struct ExternalCallArgument
+{
+	unsigned offset;
+	unsigned size;
+
+	bool isFloat;
+};
+
+struct ExternalCallLayout
+{
+	ExternalCallLayout(): argumentCount(0), resultCode(0)
+	{
+	}
+
+	ExternalCallArgument arguments[14];
+	unsigned argumentCount;
+
+	char resultCode;
+};
+
+// Location of the argument data provided by the call microcode
+struct ExternalCallSource
+{
+	unsigned instruction;
+
+	unsigned reg;
+	unsigned offset;
+
+	unsigned value;
+};
+
+const x86Reg rExternalCallArgs[] = { rRDI, rRSI, rRDX, rRCX, rR8, rR9 };
+const x86XmmReg rExternalCallXmmArgs[] = { rXMM0, rXMM1, rXMM2, rXMM3, rXMM4, rXMM5, rXMM6, rXMM7 };
+
+bool AddExternalCallArgument(ExternalCallLayout &layout, unsigned offset, unsigned size, bool isFloat)
+{
+	unsigned intCount = 0;
+	unsigned xmmCount = 0;
+
+	for(unsigned i = 0; i < layout.argumentCount; i++)
+	{
+		if(layout.arguments[i].isFloat)
+			xmmCount++;
+		else
+			intCount++;
+	}
+
+	// Arguments passed on stack are not supported
+	if(isFloat ? xmmCount == sizeof(rExternalCallXmmArgs) / sizeof(rExternalCallXmmArgs[0]) : intCount == sizeof(rExternalCallArgs) / sizeof(rExternalCallArgs[0]))
+		return false;
+
+	ExternalCallArgument &argument = layout.arguments[layout.argumentCount++];
+
+	argument.offset = offset;
+	argument.size = size;
+	argument.isFloat = isFloat;
+
+	return true;
+}
+
+// Match nullbind.h signature of a wrapped function against its type and place arguments into System V registers
+bool GetExternalCallLayout(CodeGenRegVmContext &ctx, unsigned functionId, ExternalCallLayout &layout)
+{
+	ExternFuncInfo &function = ctx.exFunctions[functionId];
+
+	if(function.regVmAddress != -1 || !function.funcPtrWrap || !function.funcPtrWrapTarget)
+		return false;
+
+	const char *signature = nullcGetModuleFunctionWrapperSignature(function.funcPtrWrap);
+
+	if(!signature)
+		return false;
+
+	ExternTypeInfo &functionType = ctx.exTypes[function.funcType];
+	ExternTypeInfo &returnType = ctx.exTypes[ctx.exTypeExtra[functionType.memberOffset].type];
+
+	layout.resultCode = *signature++;
+
+	switch(function.retType)
+	{
+	case ExternFuncInfo::RETURN_VOID:
+		if(layout.resultCode != 'v')
+			return false;
+		break;
+	case ExternFuncInfo::RETURN_INT:
+		if(returnType.size == 1 && (layout.resultCode == 'b' || layout.resultCode == 'c'))
+			break;
+		if(returnType.size == 2 && layout.resultCode == 's')
+			break;
+		if(returnType.size == 4 && layout.resultCode == 'i')
+			break;
+		return false;
+	case ExternFuncInfo::RETURN_LONG:
+		if(layout.resultCode != 'l' && layout.resultCode != 'p')
+			return false;
+		break;
+	case ExternFuncInfo::RETURN_DOUBLE:
+		if(layout.resultCode != (function.returnShift == 1 ? 'f' : 'd'))
+			return false;
+		break;
+	default:
+		return false;
+	}
+
+	unsigned offset = 0;
+
+	for(unsigned i = 0; i < function.paramCount; i++)
+	{
+		ExternTypeInfo &type = ctx.exTypes[ctx.exLocals[function.offsetToFirstLocal + i].type];
+
+		char code = *signature++;
+
+		if(!code)
+			return false;
+
+		if(type.subCat == ExternTypeInfo::CAT_POINTER)
+		{
+			if(code != 'p' || !AddExternalCallArgument(layout, offset, 8, false))
+				return false;
+
+			offset += 8;
+			continue;
+		}
+
+		switch(type.type)
+		{
+		case ExternTypeInfo::TYPE_CHAR:
+			if((code != 'b' && code != 'c') || !AddExternalCallArgument(layout, offset, 4, false))
+				return false;
+			offset += 4;
+			break;
+		case ExternTypeInfo::TYPE_SHORT:
+			if(code != 's' || !AddExternalCallArgument(layout, offset, 4, false))
+				return false;
+			offset += 4;
+			break;
+		case ExternTypeInfo::TYPE_INT:
+			if(code != 'i' || !AddExternalCallArgument(layout, offset, 4, false))
+				return false;
+			offset += 4;
+			break;
+		case ExternTypeInfo::TYPE_LONG:
+			if((code != 'l' && code != 'p') || !AddExternalCallArgument(layout, offset, 8, false))
+				return false;
+			offset += 8;
+			break;
+		case ExternTypeInfo::TYPE_DOUBLE:
+			if(code != 'd' || !AddExternalCallArgument(layout, offset, 8, true))
+				return false;
+			offset += 8;
+			break;
+		case ExternTypeInfo::TYPE_COMPLEX:
+			// Unsized arrays and function pointers are passed in two integer registers
+			if(type.size != 12)
+				return false;
+
+			if(!(type.subCat == ExternTypeInfo::CAT_ARRAY && type.arrSize == ~0u && code == 'a') && !(type.subCat == ExternTypeInfo::CAT_FUNCTION && code == 'F'))
+				return false;
+
+			if(!AddExternalCallArgument(layout, offset, 8, false) || !AddExternalCallArgument(layout, offset + 8, 4, false))
+				return false;
+
+			offset += 12;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	// Context argument of member functions follows the arguments
+	if(*signature == 'p' && signature[1] == 0)
+	{
+		if(!AddExternalCallArgument(layout, offset, 8, false))
+			return false;
+	}
+	else if(*signature)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+unsigned* SkipCallMicrocodePushes(unsigned *microcode)
+{
+	while(*microcode != rvmiCall)
+	{
+		switch(*microcode++)
+		{
+		case rvmiPush:
+		case rvmiPushQword:
+		case rvmiPushImm:
+		case rvmiPushImmq:
+			microcode++;
+			break;
+		case rvmiPushMem:
+			microcode += 3;
+			break;
+		}
+	}
+
+	return microcode + 1;
+}
+
+bool FindExternalCallArgumentSource(unsigned *microcode, ExternalCallArgument &argument, ExternalCallSource &source)
+{
+	unsigned position = 0;
+
+	while(*microcode != rvmiCall)
+	{
+		source.instruction = *microcode++;
+		source.reg = 0;
+		source.offset = 0;
+		source.value = 0;
+
+		unsigned size = 0;
+
+		switch(source.instruction)
+		{
+		case rvmiPush:
+			source.reg = *microcode++;
+			size = 4;
+			break;
+		case rvmiPushQword:
+			source.reg = *microcode++;
+			size = 8;
+			break;
+		case rvmiPushImm:
+			source.value = *microcode++;
+			size = 4;
+			break;
+		case rvmiPushImmq:
+			source.value = *microcode++;
+			size = 8;
+			break;
+		case rvmiPushMem:
+			source.reg = *microcode++;
+			source.offset = *microcode++;
+			size = *microcode++;
+			break;
+		default:
+			return false;
+		}
+
+		if(argument.offset >= position && argument.offset + argument.size <= position + size)
+		{
+			unsigned delta = argument.offset - position;
+
+			// Immediate values can only be placed in general purpose registers
+			if(source.instruction == rvmiPushImm || source.instruction == rvmiPushImmq)
+			{
+				if(argument.isFloat)
+					return false;
+
+				// Upper half of a qword immediate is zero
+				if(delta != 0)
+					source.value = 0;
+
+				return true;
+			}
+
+			source.offset += delta;
+
+			return true;
+		}
+
+		position += size;
+	}
+
+	return false;
+}
+
+void ErrorExternalCallWrap(CodeGenRegVmStateContext *vmState)
+{
+	longjmp(vmState->errorHandler, 1);
+}
+
+// Call external function without passing the arguments through the temporary stack and a wrapper
+bool GenCodeCmdCallExternal(CodeGenRegVmContext &ctx, RegVmCmd cmd, unsigned &endLabel)
+{
+	ExternalCallLayout layout;
+
+	if(!GetExternalCallLayout(ctx, cmd.argument, layout))
+		return false;
+
+	unsigned *microcode = ctx.exRegVmConstants + ((cmd.rA << 16) | (cmd.rB << 8) | cmd.rC);
+
+	ExternalCallSource sources[sizeof(layout.arguments) / sizeof(layout.arguments[0])];
+
+	for(unsigned i = 0; i < layout.argumentCount; i++)
+	{
+		if(!FindExternalCallArgumentSource(microcode, layout.arguments[i], sources[i]))
+			return false;
+	}
+
+	unsigned *resultInfo = SkipCallMicrocodePushes(microcode);
+
+	unsigned char resultReg = resultInfo[0] & 0xff;
+	unsigned char resultType = resultInfo[1] & 0xff;
+
+	// Results that are copied to memory are not supported
+	if(resultInfo[2] != rvmiReturn)
+		return false;
+
+	ctx.vmState->errorExternalCallWrap = ErrorExternalCallWrap;
+
+	unsigned genericLabel = ctx.labelCount++;
+	unsigned okLabel = ctx.labelCount++;
+
+	endLabel = ctx.labelCount++;
+
+	// Function might have been redirected since code generation
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rRAX, sQWORD, rR13, nullcOffsetOf(ctx.vmState, externalAddress));
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rRAX, sQWORD, rRAX, cmd.argument * sizeof(void*));
+	EMIT_OP_REG_NUM(ctx.ctx, o_cmp64, rRAX, 0);
+	EMIT_OP_LABEL(ctx.ctx, o_je, JUMP_NEAR | genericLabel, true);
+
+	// Add call stack frame
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rR11, sQWORD, rR13, nullcOffsetOf(ctx.vmState, callStackTop));
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_mov, sDWORD, rR11, nullcOffsetOf(ctx.vmState->callStackBase, instruction), ctx.currInstructionPos + 1);
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_add64, sQWORD, rR13, nullcOffsetOf(ctx.vmState, callStackTop), sizeof(CodeGenRegVmCallStackEntry));
+
+	unsigned intCount = 0;
+	unsigned xmmCount = 0;
+
+	for(unsigned i = 0; i < layout.argumentCount; i++)
+	{
+		ExternalCallArgument &argument = layout.arguments[i];
+		ExternalCallSource &source = sources[i];
+
+		if(source.instruction == rvmiPushImm || source.instruction == rvmiPushImmq)
+		{
+			// 32 bit move clears the upper half
+			EMIT_OP_REG_NUM(ctx.ctx, o_mov, rExternalCallArgs[intCount++], source.value);
+			continue;
+		}
+
+		x86Reg base = rREG;
+		unsigned offset = source.reg * 8 + source.offset;
+
+		if(source.instruction == rvmiPushMem)
+		{
+			offset = source.offset;
+
+			if(source.reg == rvrrFrame)
+			{
+				base = rR15;
+			}
+			else if(source.reg == rvrrConstants)
+			{
+				base = rR14;
+			}
+			else if(source.reg != rvrrRegisters)
+			{
+				base = rR10;
+
+				EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rR10, sQWORD, rREG, source.reg * 8);
+			}
+		}
+
+		if(argument.isFloat)
+			EMIT_OP_REG_RPTR(ctx.ctx, o_movsd, rExternalCallXmmArgs[xmmCount++], sQWORD, base, offset);
+		else if(argument.size == 8)
+			EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rExternalCallArgs[intCount++], sQWORD, base, offset);
+		else
+			EMIT_OP_REG_RPTR(ctx.ctx, o_mov, rExternalCallArgs[intCount++], sDWORD, base, offset);
+	}
+
+	for(unsigned i = 0; i < intCount; i++)
+		EMIT_REG_READ(ctx.ctx, rExternalCallArgs[i]);
+
+	for(unsigned i = 0; i < xmmCount; i++)
+		EMIT_REG_READ(ctx.ctx, rExternalCallXmmArgs[i]);
+
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_mov, sBYTE, rR13, nullcOffsetOf(ctx.vmState, jitCodeActive), 0);
+	EMIT_OP_REG(ctx.ctx, o_call, rRAX);
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_mov, sBYTE, rR13, nullcOffsetOf(ctx.vmState, jitCodeActive), 1);
+
+	// Check if function has reported an error
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rR11, sQWORD, rR13, nullcOffsetOf(ctx.vmState, callContinue));
+	EMIT_OP_REG_RPTR(ctx.ctx, o_movsx, rR11, sBYTE, rR11, 0);
+	EMIT_OP_REG_REG(ctx.ctx, o_test, rR11, rR11);
+	EMIT_OP_LABEL(ctx.ctx, o_jne, okLabel, true);
+
+	EMIT_OP_NUM(ctx.ctx, o_set_tracking, 0);
+
+	EMIT_OP_REG_REG(ctx.ctx, o_mov64, rArg1, rR13);
+	EMIT_REG_READ(ctx.ctx, rArg1);
+	EMIT_OP_RPTR(ctx.ctx, o_call, sQWORD, rArg1, nullcOffsetOf(ctx.vmState, errorExternalCallWrap));
+
+	EMIT_OP_NUM(ctx.ctx, o_set_tracking, 1);
+
+	EMIT_LABEL(ctx.ctx, okLabel);
+
+	switch(resultType)
+	{
+	case rvrInt:
+		EMIT_OP_RPTR_REG(ctx.ctx, o_mov, sDWORD, rREG, resultReg * 8, rEAX);
+
+		// Only the low part of small integers is returned
+		if(layout.resultCode == 'b' || layout.resultCode == 'c' || layout.resultCode == 's')
+		{
+			EMIT_OP_REG_RPTR(ctx.ctx, o_movsx, rEAX, layout.resultCode == 's' ? sWORD : sBYTE, rREG, resultReg * 8);
+			EMIT_OP_RPTR_REG(ctx.ctx, o_mov, sDWORD, rREG, resultReg * 8, rEAX);
+		}
+		break;
+	case rvrLong:
+		EMIT_OP_RPTR_REG(ctx.ctx, o_mov64, sQWORD, rREG, resultReg * 8, rRAX);
+		break;
+	case rvrDouble:
+		if(layout.resultCode == 'f')
+			EMIT_OP_REG_REG(ctx.ctx, o_cvtss2sd, rXMM0, rXMM0);
+
+		EMIT_OP_RPTR_REG(ctx.ctx, o_movsd, sQWORD, rREG, resultReg * 8, rXMM0);
+		break;
+	default:
+		break;
+	}
+
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_sub64, sQWORD, rR13, nullcOffsetOf(ctx.vmState, callStackTop), sizeof(CodeGenRegVmCallStackEntry)); // vmState->callStackTop--;
+
+	EMIT_OP_LABEL(ctx.ctx, o_jmp, JUMP_NEAR | endLabel, true);
+
+	EMIT_LABEL(ctx.ctx, genericLabel);
+
+	return true;
+}
+#endif
+
+void* GetExternalCallTarget(CodeGenRegVmContext &ctx, unsigned functionId)
+{
+#if defined(_M_X64) && defined(__linux)
+	ExternalCallLayout layout;
+
+	if(GetExternalCallLayout(ctx, functionId, layout))
+		return ctx.exFunctions[functionId].funcPtrWrapTarget;
+#else
+	(void)ctx;
+	(void)functionId;
+#endif
+
+	return NULL;
+}
+
 void GenCodeCmdCall(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 {
 	if(cmd.argument != ~0u && ctx.exFunctions[cmd.argument].builtinIndex == NULLC_BUILTIN_SQRT)
@@ -2185,6 +2631,11 @@ void GenCodeCmdCall(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 
 	ctx.vmState->callWrap = CallWrap;
 
+#if defined(_M_X64) && defined(__linux)
+	unsigned externalCallEndLabel = 0;
+	bool externalCall = cmd.argument != ~0u && ctx.vmState->externalAddress && ctx.vmState->externalAddress[cmd.argument] && GenCodeCmdCallExternal(ctx, cmd, externalCallEndLabel);
+#endif
+
 	unsigned *microcode = GetCodeCmdCallPrologue(ctx, (cmd.rA << 16) | (cmd.rB << 8) | cmd.rC);
 
 	unsigned char resultReg = *microcode++ & 0xff;
@@ -2233,6 +2684,11 @@ void GenCodeCmdCall(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 #endif
 
 	GetCodeCmdCallEpilogue(ctx, microcode, resultReg, resultType);
+
+#if defined(_M_X64) && defined(__linux)
+	if(externalCall)
+		EMIT_LABEL(ctx.ctx, externalCallEndLabel);
+#endif
 }
 
 void ErrorInvalidFunctionPointer(CodeGenRegVmStateContext *vmState)
@@ -2356,6 +2812,7 @@ void CheckedReturnWrap(CodeGenRegVmStateContext *vmState, uintptr_t frameBase, u
 
 			char *copy = (char*)NULLC::AllocObject(ctx.exTypes[type.subType].size * length, type.subType);
 			memcpy(copy, ptr, unsigned(ctx.exTypes[type.subType].size * length));
+			NULLC::WriteBarrier(copy);
 			memcpy(returnValuePtr, &copy, sizeof(copy));
 		}
 		else
@@ -2364,6 +2821,7 @@ void CheckedReturnWrap(CodeGenRegVmStateContext *vmState, uintptr_t frameBase, u
 
 			char *copy = (char*)NULLC::AllocObject(objSize, typeId);
 			memcpy(copy, ptr, objSize);
+			NULLC::WriteBarrier(copy);
 			memcpy(returnValuePtr, &copy, sizeof(copy));
 		}
 
@@ -2426,7 +2884,7 @@ void GenCodeCmdReturn(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 		x86Reg rTempStack = rRBP;
 
 		if(*microcode != rvmiReturn)
-			EMIT_OP_REG_NUM64(ctx.ctx, o_mov64, rTempStack, (uintptr_t)ctx.vmState->tempStackArrayBase);
+			EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rTempStack, sQWORD, rR13, nullcOffsetOf(ctx.vmState, tempStackArrayBase));
 
 		unsigned tempStackPtrOffset = 0;
 
@@ -2482,9 +2940,10 @@ void GenCodeCmdReturn(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 		// Checked return value
 		if(cmd.rC)
 		{
-			EMIT_OP_REG_NUM64(ctx.ctx, o_mov64, rArg1, uintptr_t(ctx.vmState));
+			EMIT_OP_REG_REG(ctx.ctx, o_mov64, rArg1, rR13);
 			EMIT_OP_REG_REG(ctx.ctx, o_mov64, rArg2, rR15);
 			EMIT_OP_REG_NUM(ctx.ctx, o_mov, rArg3, typeId);
+			EMIT_REG_READ(ctx.ctx, rArg1);
 			EMIT_REG_READ(ctx.ctx, rArg2);
 			EMIT_REG_READ(ctx.ctx, rArg3);
 			EMIT_OP_RPTR(ctx.ctx, o_call, sQWORD, rArg1, unsigned(uintptr_t(&ctx.vmState->checkedReturnWrap) - uintptr_t(ctx.vmState)));
@@ -4362,10 +4821,11 @@ void GenCodeCmdConvertPtr(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 	ctx.vmState->convertPtrWrap = ConvertPtrWrap;
 
 #if defined(_M_X64)
-	EMIT_OP_REG_NUM64(ctx.ctx, o_mov64, rArg1, uintptr_t(ctx.vmState));
+	EMIT_OP_REG_REG(ctx.ctx, o_mov64, rArg1, rR13);
 	EMIT_OP_RPTR_NUM(ctx.ctx, o_mov, sDWORD, rArg1, unsigned(uintptr_t(&ctx.vmState->callInstructionPos) - uintptr_t(ctx.vmState)), ctx.currInstructionPos);
 	EMIT_OP_REG_NUM(ctx.ctx, o_mov, rArg2, cmd.argument);
 	EMIT_OP_REG_RPTR(ctx.ctx, o_mov, rArg3, sDWORD, rREG, cmd.rB * 8); // Load typeid
+	EMIT_REG_READ(ctx.ctx, rArg1);
 	EMIT_REG_READ(ctx.ctx, rArg2);
 	EMIT_REG_READ(ctx.ctx, rArg3);
 	EMIT_OP_RPTR(ctx.ctx, o_call, sQWORD, rArg1, unsigned(uintptr_t(&ctx.vmState->convertPtrWrap) - uintptr_t(ctx.vmState)));
@@ -4384,3 +4844,73 @@ void GenCodeCmdConvertPtr(CodeGenRegVmContext &ctx, RegVmCmd cmd)
 	EMIT_OP_RPTR_REG(ctx.ctx, o_mov, sDWORD, rREG, cmd.rA * 8, rEAX); // Move to target
 #endif
 }
+
+void GenCodeCmdWriteBarrier(CodeGenRegVmContext &ctx, RegVmCmd cmd)
+{
+	ctx.vmState->writeBarrierWrap = NULLC::WriteBarrier;
+	ctx.vmState->writeBarrierActive = &NULLC::writeBarrierActive;
+
+	// Call is skipped while generational collection is disabled and incremental marking is not in progress
+#if defined(_M_X64)
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rRAX, sQWORD, rR13, nullcOffsetOf(ctx.vmState, writeBarrierActive));
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_cmp, sDWORD, rRAX, 0, 0);
+	EMIT_OP_LABEL(ctx.ctx, o_je, ctx.labelCount, true);
+
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov64, rArg1, sQWORD, rREG, cmd.rC * 8); // Load target pointer
+
+	if(cmd.argument)
+		EMIT_OP_REG_NUM(ctx.ctx, o_add64, rArg1, cmd.argument); // Add offset
+
+	EMIT_REG_READ(ctx.ctx, rArg1);
+	EMIT_OP_RPTR(ctx.ctx, o_call, sQWORD, rR13, unsigned(uintptr_t(&ctx.vmState->writeBarrierWrap) - uintptr_t(ctx.vmState)));
+#else
+	EMIT_OP_RPTR_NUM(ctx.ctx, o_cmp, sDWORD, unsigned(uintptr_t(&NULLC::writeBarrierActive)), 0);
+	EMIT_OP_LABEL(ctx.ctx, o_je, ctx.labelCount, true);
+
+	EMIT_OP_REG_RPTR(ctx.ctx, o_mov, rEAX, sDWORD, rREG, cmd.rC * 8); // Load target pointer
+
+	if(cmd.argument)
+		EMIT_OP_REG_NUM(ctx.ctx, o_add, rEAX, cmd.argument); // Add offset
+
+	EMIT_OP_REG(ctx.ctx, o_push, rEAX);
+	EMIT_OP_ADDR(ctx.ctx, o_call, sDWORD, uintptr_t(&ctx.vmState->writeBarrierWrap));
+	EMIT_OP_REG_NUM(ctx.ctx, o_add, rESP, 4);
+#endif
+
+	EMIT_LABEL(ctx.ctx, ctx.labelCount);
+	ctx.labelCount++;
+}
+
+void GenCodeSetupWrappers(CodeGenRegVmStateContext *vmState)
+{
+	// Code generation installs these as it goes, but code restored from the native code cache skips it
+	vmState->callWrap = CallWrap;
+	vmState->checkedReturnWrap = CheckedReturnWrap;
+	vmState->convertPtrWrap = ConvertPtrWrap;
+	vmState->writeBarrierWrap = NULLC::WriteBarrier;
+	vmState->writeBarrierActive = &NULLC::writeBarrierActive;
+
+	vmState->errorOutOfBoundsWrap = ErrorOutOfBoundsWrap;
+	vmState->errorNoReturnWrap = ErrorNoReturnWrap;
+	vmState->errorInvalidFunctionPointer = ErrorInvalidFunctionPointer;
+#if defined(_M_X64) && defined(__linux)
+	vmState->errorExternalCallWrap = ErrorExternalCallWrap;
+#endif
+
+	vmState->x64PowWrap = VmIntPow;
+	vmState->x64PowdWrap = pow;
+	vmState->x64ModdWrap = fmod;
+	vmState->x64PowlWrap = VmLongPow;
+
+	vmState->x86PowWrap = x86PowWrap;
+	vmState->x86PowdWrap = x86PowdWrap;
+	vmState->x86ModdWrap = x86ModdWrap;
+	vmState->x86MullWrap = x86MullWrap;
+	vmState->x86DivlWrap = x86DivlWrap;
+	vmState->x86PowlWrap = VmLongPow;
+	vmState->x86ModlWrap = x86ModlWrap;
+	vmState->x86LtodWrap = x86LtodWrap;
+	vmState->x86DtolWrap = x86DtolWrap;
+	vmState->x86ShllWrap = x86ShllWrap;
+	vmState->x86ShrlWrap = x86ShrlWrap;
+}
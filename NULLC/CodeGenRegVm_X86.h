@@ -26,10 +26,13 @@ struct CodeGenRegVmStateContext
 		callWrap = NULL;
 		checkedReturnWrap = NULL;
 		convertPtrWrap = NULL;
+		writeBarrierWrap = NULL;
+		writeBarrierActive = NULL;
 
 		errorOutOfBoundsWrap = NULL;
 		errorNoReturnWrap = NULL;
 		errorInvalidFunctionPointer = NULL;
+		errorExternalCallWrap = NULL;
 
 		dataStackBase = NULL;
 		dataStackTop = NULL;
@@ -52,6 +55,7 @@ struct CodeGenRegVmStateContext
 
 		instAddress = NULL;
 		functionAddress = NULL;
+		externalAddress = NULL;
 
 		exRegVmConstants = NULL;
 
@@ -77,6 +81,7 @@ struct CodeGenRegVmStateContext
 		vsAsmStyle = false;
 
 		jitCodeActive = false;
+		callContinue = NULL;
 	}
 
 	jmp_buf errorHandler;
@@ -86,10 +91,13 @@ struct CodeGenRegVmStateContext
 	void (*callWrap)(CodeGenRegVmStateContext *vmState, unsigned functionId);
 	void (*checkedReturnWrap)(CodeGenRegVmStateContext *vmState, uintptr_t frameBase, unsigned typeId);
 	void (*convertPtrWrap)(CodeGenRegVmStateContext *vmState, unsigned targetTypeId, unsigned sourceTypeId);
+	void (*writeBarrierWrap)(void *address);
+	unsigned *writeBarrierActive;
 
 	void (*errorOutOfBoundsWrap)(CodeGenRegVmStateContext *vmState);
 	void (*errorNoReturnWrap)(CodeGenRegVmStateContext *vmState);
 	void (*errorInvalidFunctionPointer)(CodeGenRegVmStateContext *vmState);
+	void (*errorExternalCallWrap)(CodeGenRegVmStateContext *vmState);
 
 	// Placement and layout of dataStack*** and callStack*** members is used in nullc_debugger_component
 	char *dataStackBase;
@@ -114,6 +122,9 @@ struct CodeGenRegVmStateContext
 	unsigned char **instAddress;
 	unsigned char **functionAddress;
 
+	// Native addresses of external functions that can be called directly, NULL if the call has to go through callWrap
+	void **externalAddress;
+
 	unsigned *exRegVmConstants;
 
 	unsigned char *codeLaunchHeader;
@@ -138,6 +149,8 @@ struct CodeGenRegVmStateContext
 	bool vsAsmStyle;
 
 	bool jitCodeActive;
+
+	bool *callContinue;
 };
 
 class ExecutorX86;
@@ -283,3 +296,8 @@ void GenCodeCmdBitNotl(CodeGenRegVmContext &ctx, RegVmCmd cmd);
 void GenCodeCmdLogNot(CodeGenRegVmContext &ctx, RegVmCmd cmd);
 void GenCodeCmdLogNotl(CodeGenRegVmContext &ctx, RegVmCmd cmd);
 void GenCodeCmdConvertPtr(CodeGenRegVmContext &ctx, RegVmCmd cmd);
+void GenCodeCmdWriteBarrier(CodeGenRegVmContext &ctx, RegVmCmd cmd);
+
+void GenCodeSetupWrappers(CodeGenRegVmStateContext *vmState);
+
+void* GetExternalCallTarget(CodeGenRegVmContext &ctx, unsigned functionId);
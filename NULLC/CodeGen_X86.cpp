@@ -7,6 +7,17 @@
 #include "Executor_Common.h"
 #include "StdLib.h"
 
+unsigned GetCodeGenOptions()
+{
+	unsigned options = 0;
+
+#if defined(NULLC_OPTIMIZE_X86)
+	options |= 1u << 0;
+#endif
+
+	return options;
+}
+
 unsigned CodeGenGenericContext::MemFind(const x86Argument &address)
 {
 	for(unsigned i = 0; i < memoryStateSize; i++)
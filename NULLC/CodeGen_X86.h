@@ -195,3 +195,6 @@ void EMIT_REG_KILL(CodeGenGenericContext &ctx, x86Reg reg);
 void EMIT_REG_KILL(CodeGenGenericContext &ctx, x86XmmReg reg);
 
 void SetOptimizationLookBehind(CodeGenGenericContext &ctx, bool allow);
+
+// Returns a mask of compile-time options that change the generated code
+unsigned GetCodeGenOptions();
@@ -222,8 +222,8 @@ bool BuildBaseModule(Allocator *allocator, int optimizationLevel)
 	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::StrToDouble, "double", 1);
 	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::DoubleToStr, "double::str", 0);
 
-	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::AllocObject, "__newS", 0);
-	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::AllocArray, "__newA", 0);
+	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::NewObject, "__newS", 0);
+	nullcBindModuleFunctionHelperNoMemWrite("$base$", NULLC::NewArray, "__newA", 0);
 	nullcBindModuleFunctionHelper("$base$", NULLC::CopyObject, "duplicate", 0);
 	nullcBindModuleFunctionHelper("$base$", NULLC::CopyArray, "__duplicate_array", 0);
 	nullcBindModuleFunctionHelper("$base$", NULLC::ReplaceObject, "replace", 0);
@@ -8,6 +8,17 @@
 #include "Executor_RegVm.h"
 #include "Linker.h"
 
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <intrin.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
 #if !defined(NULLC_NO_RAW_EXTERNAL_CALL)
 #define dcAllocMem NULLC::alloc
 #define dcFreeMem  NULLC::dealloc
@@ -41,6 +52,12 @@ namespace GC
 	// Range of memory that is not checked. Used to exclude pointers to stack from marking and GC
 	char	*unmanageableBase = NULL;
 	char	*unmanageableTop = NULL;
+
+	// Number of global variables, locals and temporary stack slots checked by root marking
+	unsigned long long rootsScanned = 0;
+
+	// Heap snapshot receives locations of all pointers, including the ones to global variables
+	void (*snapshotRecorder)(char *location) = NULL;
 }
 
 unsigned ConvertFromAutoRef(unsigned int target, unsigned int source)
@@ -710,6 +727,12 @@ void nullcDumpStackData()
 #define GC_DEBUG_PRINT(...) (void)0
 //#define GC_DEBUG_PRINT printf
 
+#if defined(_MSC_VER)
+	#define GC_THREAD_LOCAL __declspec(thread)
+#else
+	#define GC_THREAD_LOCAL __thread
+#endif
+
 namespace GC
 {
 	unsigned int	objectName = NULLC::GetStringHash("auto ref");
@@ -728,6 +751,140 @@ namespace GC
 
 	HashMap<int> functionIDs;
 
+	// Parallel marking
+	const unsigned maxMarkerThreads = 64;
+
+	// Pending roots of a marker thread. Owner takes roots from the back, other marker threads steal them from the front
+	struct MarkWorker
+	{
+		MarkWorker(): lock(0), pending(0), head(0)
+		{
+		}
+
+		volatile long lock;
+		volatile unsigned pending;
+
+		unsigned head;
+		FastVector<RootInfo> roots;
+	};
+
+	MarkWorker markWorkers[maxMarkerThreads];
+
+	// Number of marker threads including the thread that runs the collection, parallel marking is disabled when it's 1
+	unsigned markerThreadCount = 1;
+
+	bool parallelMarking = false;
+
+	volatile long markJobIndex = 0;
+	volatile long markIdleWorkers = 0;
+	volatile long markFinishedWorkers = 0;
+	volatile long markStopThreads = 0;
+
+#if defined(_WIN32)
+	HANDLE markThreads[maxMarkerThreads];
+
+	bool markJobInitialized = false;
+	CRITICAL_SECTION markJobLock;
+	CONDITION_VARIABLE markJobReady;
+#else
+	pthread_t markThreads[maxMarkerThreads];
+
+	pthread_mutex_t markJobLock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t markJobReady = PTHREAD_COND_INITIALIZER;
+#endif
+
+	// Worker of the current thread during parallel marking
+	GC_THREAD_LOCAL MarkWorker *currentWorker = NULL;
+
+	uintptr_t AtomicFetchOr(uintptr_t *target, uintptr_t value)
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		return uintptr_t(_InterlockedOr64((volatile __int64*)target, __int64(value)));
+#elif defined(_MSC_VER)
+		return uintptr_t(_InterlockedOr((volatile long*)target, long(value)));
+#else
+		return __atomic_fetch_or(target, value, __ATOMIC_RELAXED);
+#endif
+	}
+
+	long AtomicIncrement(volatile long *target)
+	{
+#if defined(_MSC_VER)
+		return _InterlockedIncrement(target);
+#else
+		return __atomic_add_fetch(target, 1, __ATOMIC_ACQ_REL);
+#endif
+	}
+
+	long AtomicDecrement(volatile long *target)
+	{
+#if defined(_MSC_VER)
+		return _InterlockedDecrement(target);
+#else
+		return __atomic_sub_fetch(target, 1, __ATOMIC_ACQ_REL);
+#endif
+	}
+
+	void YieldThread()
+	{
+#if defined(_WIN32)
+		SwitchToThread();
+#else
+		sched_yield();
+#endif
+	}
+
+	void LockWorker(MarkWorker &worker)
+	{
+#if defined(_MSC_VER)
+		while(_InterlockedExchange(&worker.lock, 1))
+			YieldThread();
+#else
+		while(__atomic_exchange_n(&worker.lock, 1, __ATOMIC_ACQUIRE))
+			YieldThread();
+#endif
+	}
+
+	void UnlockWorker(MarkWorker &worker)
+	{
+#if defined(_MSC_VER)
+		_InterlockedExchange(&worker.lock, 0);
+#else
+		__atomic_store_n(&worker.lock, 0, __ATOMIC_RELEASE);
+#endif
+	}
+
+	// Sets the mark bit of an object, returns false if the object was already marked
+	bool SetMark(NULLC::ObjectMark &mark)
+	{
+		if(*mark.word & mark.bit)
+			return false;
+
+		// Mark words of pool pages are shared by objects that can be reached from different marker threads
+		if(parallelMarking)
+			return !(AtomicFetchOr(mark.word, mark.bit) & mark.bit);
+
+		*mark.word |= mark.bit;
+
+		return true;
+	}
+
+	void PushRoot(const RootInfo &root)
+	{
+		if(MarkWorker *worker = currentWorker)
+		{
+			LockWorker(*worker);
+
+			worker->roots.push_back(root);
+			worker->pending = worker->roots.size() - worker->head;
+
+			UnlockWorker(*worker);
+			return;
+		}
+
+		next->push_back(root);
+	}
+
 	void PrintMarker(markerType marker)
 	{
 		GC_DEBUG_PRINT("\tMarker is 0x%2x [", unsigned(marker));
@@ -774,6 +931,9 @@ namespace GC
 		// We have pointer to stack that has a pointer inside, so 'ptr' is really a pointer to pointer
 		char *target = ReadVmMemoryPointer(ptr);
 
+		if(snapshotRecorder && target)
+			snapshotRecorder(ptr);
+
 		// Check for unmanageable ranges. Range of 0x00000000-0x00010000 is unmanageable by default due to upvalues with offsets inside closures.
 		if(target > (char*)0x00010000 && (target < unmanageableBase || target > unmanageableTop))
 		{
@@ -781,7 +941,8 @@ namespace GC
 			GC_DEBUG_PRINT("\tGlobal pointer [ref] %s %p (at %p)\r\n", NULLC::commonLinker->exSymbols.data + type.offsetToName, target, ptr);
 
 			// Get pointer to the start of memory block. Some pointers may point to the middle of memory blocks
-			unsigned int *basePtr = (unsigned int*)NULLC::GetBasePointer(target);
+			NULLC::ObjectMark mark;
+			unsigned int *basePtr = (unsigned int*)NULLC::GetTracedBasePointer(target, ptr, mark);
 
 			// If there is no base, this pointer points to memory that is not GCs memory
 			if(!basePtr)
@@ -793,12 +954,9 @@ namespace GC
 			markerType *marker = (markerType*)((char*)basePtr - sizeof(markerType));
 			PrintMarker(*marker);
 
-			// If block is unmarked
-			if(!(*marker & OBJECT_VISIBLE))
+			// If block is unmarked, mark it as used
+			if(SetMark(mark))
 			{
-				// Mark block as used
-				*marker |= OBJECT_VISIBLE;
-
 				GC_DEBUG_PRINT("\tMarked as used\r\n");
 
 				unsigned targetSubType = type.subType;
@@ -811,7 +969,7 @@ namespace GC
 				{
 					GC_DEBUG_PRINT("\tPointer %p scheduled on next loop\r\n", target);
 
-					next->push_back(RootInfo(target, takeSubtype ? &NULLC::commonLinker->exTypes[targetSubType] : &type));
+					PushRoot(RootInfo(target, takeSubtype ? &NULLC::commonLinker->exTypes[targetSubType] : &type));
 				}
 			}
 		}
@@ -862,8 +1020,12 @@ namespace GC
 			size = *(int*)(ptr + NULLC_PTR_SIZE);
 
 			// Switch pointer to array data
+			char *slot = ptr;
 			ptr = ReadVmMemoryPointer(ptr);
 
+			if(snapshotRecorder && ptr)
+				snapshotRecorder(slot);
+
 			// If uninitialized or points to stack memory, return
 			if(!ptr || ptr <= (char*)0x00010000 || (ptr >= unmanageableBase && ptr <= unmanageableTop))
 			{
@@ -876,7 +1038,8 @@ namespace GC
 			GC_DEBUG_PRINT("\tGlobal pointer [array] %p\r\n", ptr);
 
 			// Get base pointer
-			unsigned int *basePtr = (unsigned int*)NULLC::GetBasePointer(ptr);
+			NULLC::ObjectMark mark;
+			unsigned int *basePtr = (unsigned int*)NULLC::GetTracedBasePointer(ptr, slot, mark);
 
 			// If there is no base, this pointer points to memory that is not GCs memory
 			if(!basePtr)
@@ -887,13 +1050,10 @@ namespace GC
 			markerType	*marker = (markerType*)((char*)basePtr - sizeof(markerType));
 			PrintMarker(*marker);
 
-			// If there is no base pointer or memory already marked, exit
-			if((*marker & OBJECT_VISIBLE))
+			// Mark memory as used, exit if it's already marked
+			if(!SetMark(mark))
 				return;
 
-			// Mark memory as used
-			*marker |= OBJECT_VISIBLE;
-
 			GC_DEBUG_PRINT("\tMarked as used\r\n");
 		}
 		else if(type.nameHash == autoArrayName)
@@ -932,6 +1092,9 @@ namespace GC
 			// Switch pointer to target
 			char *target = ReadVmMemoryPointer(ptr + 4);
 
+			if(snapshotRecorder && target)
+				snapshotRecorder(ptr + 4);
+
 			// If uninitialized or points to stack memory, return
 			if(!target || target <= (char*)0x00010000 || (target >= unmanageableBase && target <= unmanageableTop))
 			{
@@ -944,7 +1107,8 @@ namespace GC
 			GC_DEBUG_PRINT("\tGlobal pointer [class] %p\r\n", target);
 
 			// Get base pointer
-			unsigned int *basePtr = (unsigned int*)NULLC::GetBasePointer(target);
+			NULLC::ObjectMark mark;
+			unsigned int *basePtr = (unsigned int*)NULLC::GetTracedBasePointer(target, ptr + 4, mark);
 
 			// If there is no base, this pointer points to memory that is not GCs memory
 			if(!basePtr)
@@ -955,13 +1119,10 @@ namespace GC
 			markerType	*marker = (markerType*)((char*)basePtr - sizeof(markerType));
 			PrintMarker(*marker);
 
-			// If there is no base pointer or memory already marked, exit
-			if((*marker & OBJECT_VISIBLE))
+			// Mark memory as used, exit if it's already marked
+			if(!SetMark(mark))
 				return;
 
-			// Mark memory as used
-			*marker |= OBJECT_VISIBLE;
-
 			GC_DEBUG_PRINT("\tMarked as used, fixing up target\r\n");
 
 			// Fixup target
@@ -1043,6 +1204,249 @@ namespace GC
 			break;
 		}
 	}
+
+	bool PopRoot(MarkWorker &worker, RootInfo &root)
+	{
+		bool found = false;
+
+		LockWorker(worker);
+
+		if(worker.roots.size() != worker.head)
+		{
+			root = worker.roots.back();
+			worker.roots.pop_back();
+
+			found = true;
+		}
+
+		if(worker.roots.size() == worker.head)
+		{
+			worker.roots.clear();
+			worker.head = 0;
+		}
+
+		worker.pending = worker.roots.size() - worker.head;
+
+		UnlockWorker(worker);
+
+		return found;
+	}
+
+	bool StealRoot(unsigned thief, RootInfo &root)
+	{
+		for(unsigned i = 1; i < markerThreadCount; i++)
+		{
+			MarkWorker &victim = markWorkers[(thief + i) % markerThreadCount];
+
+			if(!victim.pending)
+				continue;
+
+			bool found = false;
+
+			LockWorker(victim);
+
+			if(victim.roots.size() != victim.head)
+			{
+				root = victim.roots[victim.head++];
+
+				found = true;
+			}
+
+			victim.pending = victim.roots.size() - victim.head;
+
+			UnlockWorker(victim);
+
+			if(found)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool HasStealableRoots()
+	{
+		for(unsigned i = 0; i < markerThreadCount; i++)
+		{
+			if(markWorkers[i].pending)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Checks roots of the worker and roots stolen from other workers until all marker threads run out of roots
+	void RunMarkWorker(unsigned index)
+	{
+		MarkWorker &worker = markWorkers[index];
+
+		currentWorker = &worker;
+
+		RootInfo root;
+
+		for(;;)
+		{
+			if(PopRoot(worker, root) || StealRoot(index, root))
+			{
+				GC_DEBUG_PRINT("Root %s %p\r\n", NULLC::commonLinker->exSymbols.data + root.type->offsetToName, root.ptr);
+
+				CheckVariable(root.ptr, *root.type);
+				continue;
+			}
+
+			// Only the workers that are checking roots can add new ones, so marking is complete when every worker is idle
+			AtomicIncrement(&markIdleWorkers);
+
+			while(markIdleWorkers != long(markerThreadCount) && !HasStealableRoots())
+				YieldThread();
+
+			if(markIdleWorkers == long(markerThreadCount))
+				break;
+
+			AtomicDecrement(&markIdleWorkers);
+		}
+
+		currentWorker = NULL;
+	}
+
+	void MarkThreadLoop(unsigned index)
+	{
+		long lastJob = 0;
+
+		for(;;)
+		{
+#if defined(_WIN32)
+			EnterCriticalSection(&markJobLock);
+
+			while(markJobIndex == lastJob && !markStopThreads)
+				SleepConditionVariableCS(&markJobReady, &markJobLock, INFINITE);
+
+			lastJob = markJobIndex;
+			bool stop = markStopThreads != 0;
+
+			LeaveCriticalSection(&markJobLock);
+#else
+			pthread_mutex_lock(&markJobLock);
+
+			while(markJobIndex == lastJob && !markStopThreads)
+				pthread_cond_wait(&markJobReady, &markJobLock);
+
+			lastJob = markJobIndex;
+			bool stop = markStopThreads != 0;
+
+			pthread_mutex_unlock(&markJobLock);
+#endif
+
+			if(stop)
+				return;
+
+			RunMarkWorker(index);
+
+			AtomicIncrement(&markFinishedWorkers);
+		}
+	}
+
+#if defined(_WIN32)
+	DWORD WINAPI MarkThreadEntry(LPVOID context)
+	{
+		MarkThreadLoop(unsigned(uintptr_t(context)));
+
+		return 0;
+	}
+#else
+	void* MarkThreadEntry(void* context)
+	{
+		MarkThreadLoop(unsigned(uintptr_t(context)));
+
+		return NULL;
+	}
+#endif
+
+	void SignalMarkerThreads()
+	{
+#if defined(_WIN32)
+		EnterCriticalSection(&markJobLock);
+
+		markJobIndex++;
+
+		WakeAllConditionVariable(&markJobReady);
+		LeaveCriticalSection(&markJobLock);
+#else
+		pthread_mutex_lock(&markJobLock);
+
+		markJobIndex++;
+
+		pthread_cond_broadcast(&markJobReady);
+		pthread_mutex_unlock(&markJobLock);
+#endif
+	}
+
+	void StopMarkerThreads()
+	{
+		if(markerThreadCount <= 1)
+			return;
+
+#if defined(_WIN32)
+		EnterCriticalSection(&markJobLock);
+
+		markStopThreads = 1;
+
+		WakeAllConditionVariable(&markJobReady);
+		LeaveCriticalSection(&markJobLock);
+
+		for(unsigned i = 1; i < markerThreadCount; i++)
+		{
+			WaitForSingleObject(markThreads[i], INFINITE);
+			CloseHandle(markThreads[i]);
+		}
+#else
+		pthread_mutex_lock(&markJobLock);
+
+		markStopThreads = 1;
+
+		pthread_cond_broadcast(&markJobReady);
+		pthread_mutex_unlock(&markJobLock);
+
+		for(unsigned i = 1; i < markerThreadCount; i++)
+			pthread_join(markThreads[i], NULL);
+#endif
+
+		for(unsigned i = 0; i < markerThreadCount; i++)
+			markWorkers[i].roots.reset();
+
+		markerThreadCount = 1;
+
+		markJobIndex = 0;
+		markStopThreads = 0;
+	}
+
+	// Pending roots are partitioned between marker threads that trace the object graph together
+	void MarkPendingRootsParallel()
+	{
+		for(unsigned i = 0; i < next->size(); i++)
+			markWorkers[i % markerThreadCount].roots.push_back(next->data[i]);
+
+		for(unsigned i = 0; i < markerThreadCount; i++)
+		{
+			markWorkers[i].head = 0;
+			markWorkers[i].pending = markWorkers[i].roots.size();
+		}
+
+		next->clear();
+
+		markIdleWorkers = 0;
+		markFinishedWorkers = 0;
+
+		parallelMarking = true;
+
+		SignalMarkerThreads();
+
+		RunMarkWorker(0);
+
+		while(markFinishedWorkers != long(markerThreadCount - 1))
+			YieldThread();
+
+		parallelMarking = false;
+	}
 }
 
 // Set range of memory that is not checked. Used to exclude pointers to stack from marking and GC
@@ -1052,6 +1456,11 @@ void GC::SetUnmanagableRange(char* base, unsigned int size)
 	GC::unmanageableTop = base + size;
 }
 
+void GC::SetSnapshotRecorder(void (*recorder)(char *location))
+{
+	GC::snapshotRecorder = recorder;
+}
+
 int GC::IsPointerUnmanaged(NULLCRef ptr)
 {
 	return ptr.ptr >= GC::unmanageableBase && ptr.ptr <= GC::unmanageableTop;
@@ -1059,6 +1468,14 @@ int GC::IsPointerUnmanaged(NULLCRef ptr)
 
 // Main function for marking all pointers in a program
 void GC::MarkUsedBlocks()
+{
+	GC::MarkRoots();
+
+	GC::MarkPendingRoots();
+}
+
+// Marks objects referenced from globals, stack frames and the temporary stack, their contents are left in the pending root list
+void GC::MarkRoots()
 {
 	GC_DEBUG_PRINT("Unmanageable range: %p-%p\r\n", GC::unmanageableBase, GC::unmanageableTop);
 
@@ -1081,6 +1498,8 @@ void GC::MarkUsedBlocks()
 	void *unknownExec = NULL;
 	unsigned int execID = nullcGetCurrentExecutor(&unknownExec);
 
+	GC::rootsScanned += NULLC::commonLinker->exVariables.size();
+
 	if(execID != NULLC_LLVM)
 	{
 		// Mark global variables
@@ -1176,6 +1595,8 @@ void GC::MarkUsedBlocks()
 
 			unsigned stackSize = (function.stackSize + 0xf) & ~0xf;
 
+			GC::rootsScanned += function.localCount + (function.contextType != ~0u ? 1 : 0);
+
 			// Check every function local
 			for(unsigned i = 0; i < function.localCount; i++)
 			{
@@ -1236,13 +1657,16 @@ void GC::MarkUsedBlocks()
 	// Check temporary stack for pointers
 	while(tempStackBase + sizeof(void*) <= tempStackTop)
 	{
+		GC::rootsScanned++;
+
 		char *ptr = GC::ReadVmMemoryPointer(tempStackBase);
 
 		// Check for unmanageable ranges. Range of 0x00000000-0x00010000 is unmanageable by default due to upvalues with offsets inside closures.
 		if(ptr > (char*)0x00010000 && (ptr < GC::unmanageableBase || ptr > GC::unmanageableTop))
 		{
-			// Get pointer base
-			unsigned int *basePtr = (unsigned int*)NULLC::GetBasePointer(ptr);
+			// Get pointer base, objects referenced from the stack are pinned in place
+			NULLC::ObjectMark mark;
+			unsigned int *basePtr = (unsigned int*)NULLC::GetTracedBasePointer(ptr, NULL, mark);
 			// If there is no base, this pointer points to memory that is not GCs memory
 			if(basePtr)
 			{
@@ -1262,12 +1686,12 @@ void GC::MarkUsedBlocks()
 				GC::PrintMarker(*marker);
 
 				// If block is unmarked, mark it as used
-				if(!(*marker & OBJECT_VISIBLE))
+				if(!(*mark.word & mark.bit))
 				{
 					unsigned typeID = unsigned(*marker >> 8);
 					ExternTypeInfo &type = types[typeID];
 
-					*marker |= OBJECT_VISIBLE;
+					*mark.word |= mark.bit;
 
 					GC_DEBUG_PRINT("\tMarked as used, checking content\r\n");
 
@@ -1294,7 +1718,11 @@ void GC::MarkUsedBlocks()
 		tempStackBase += 4;
 	}
 
-	GC::MarkPendingRoots();
+	// Arena objects are not collected, but they keep the objects they reference alive
+	GC::rootsScanned += NULLC::MarkArenaRoots();
+
+	// Objects in the deferred finalization queue are kept alive until their finalizers are run
+	GC::rootsScanned += NULLC::MarkFinalizerRoots();
 }
 
 void GC::MarkPendingRoots()
@@ -1305,6 +1733,13 @@ void GC::MarkPendingRoots()
 	if(GC::next->empty())
 		return;
 
+	// Moving collections record pointer locations while tracing, so they are always marked by a single thread
+	if(GC::markerThreadCount > 1 && !NULLC::IsMovingCollection())
+	{
+		GC::MarkPendingRootsParallel();
+		return;
+	}
+
 	while(GC::next->size())
 	{
 		GC_DEBUG_PRINT("Checking new roots\r\n");
@@ -1326,6 +1761,80 @@ void GC::MarkPendingRoots()
 	GC_DEBUG_PRINT("\r\n");
 }
 
+// Checks up to 'count' pending roots, returns true when there are no pending roots left
+bool GC::MarkPendingRootsStep(unsigned count)
+{
+	if(!GC::next)
+		return true;
+
+	while(count && !GC::next->empty())
+	{
+		GC::RootInfo root = GC::next->back();
+		GC::next->pop_back();
+
+		GC_DEBUG_PRINT("Root %s %p\r\n", NULLC::commonLinker->exSymbols.data + root.type->offsetToName, root.ptr);
+
+		GC::CheckVariable(root.ptr, *root.type);
+
+		count--;
+	}
+
+	return GC::next->empty();
+}
+
+// Set the number of threads that mark the object graph, including the thread that runs the collection
+void GC::SetMarkerThreads(unsigned count)
+{
+	if(count < 1)
+		count = 1;
+
+	if(count > GC::maxMarkerThreads)
+		count = GC::maxMarkerThreads;
+
+	if(count == GC::markerThreadCount)
+		return;
+
+	GC::StopMarkerThreads();
+
+	if(count == 1)
+		return;
+
+#if defined(_WIN32)
+	if(!GC::markJobInitialized)
+	{
+		InitializeCriticalSection(&GC::markJobLock);
+		InitializeConditionVariable(&GC::markJobReady);
+
+		GC::markJobInitialized = true;
+	}
+#endif
+
+	// Marking continues with fewer threads if some of them couldn't be started
+	unsigned started = 1;
+
+	while(started < count)
+	{
+#if defined(_WIN32)
+		GC::markThreads[started] = CreateThread(NULL, 0, GC::MarkThreadEntry, (LPVOID)uintptr_t(started), 0, NULL);
+
+		if(!GC::markThreads[started])
+			break;
+#else
+		if(pthread_create(&GC::markThreads[started], NULL, GC::MarkThreadEntry, (void*)uintptr_t(started)) != 0)
+			break;
+#endif
+
+		started++;
+	}
+
+	GC::markerThreadCount = started;
+}
+
+unsigned long long GC::RootsScanned()
+{
+	return GC::rootsScanned;
+}
+
 void GC::ResetGC()
 {
 	GC::rootsA.reset();
@@ -35,8 +35,16 @@ namespace GC
 	void SetUnmanagableRange(char* base, unsigned int size);
 	int IsPointerUnmanaged(NULLCRef ptr);
 	void MarkUsedBlocks();
+	void MarkRoots();
 	void MarkPendingRoots();
+	bool MarkPendingRootsStep(unsigned count);
+	void SetMarkerThreads(unsigned count);
+	long AtomicIncrement(volatile long *target);
+	unsigned long long RootsScanned();
 	void ResetGC();
+
+	// Every checked pointer location is passed to the recorder while it is set
+	void SetSnapshotRecorder(void (*recorder)(char *location));
 }
 
 #if !defined(NULLC_NO_RAW_EXTERNAL_CALL)
@@ -524,6 +524,7 @@ RegVmReturnType ExecutorRegVm::RunCode(RegVmCmd *instruction, RegVmRegister * co
 		&&case_rviLogNot,
 		&&case_rviLogNotl,
 		&&case_rviConvertPtr,
+		&&case_rviWriteBarrier,
 	};
 
 #define SWITCH goto *switchTable[instruction->code];
@@ -1206,6 +1207,11 @@ RegVmReturnType ExecutorRegVm::RunCode(RegVmCmd *instruction, RegVmRegister * co
 
 			instruction++;
 			BREAK;
+		CASE(rviWriteBarrier)
+			if(NULLC::writeBarrierActive)
+				NULLC::WriteBarrier((char*)(uintptr_t)(regFilePtr[cmd.rC].ptrValue + cmd.argument));
+			instruction++;
+			BREAK;
 #if !defined(USE_COMPUTED_GOTO)
 		default:
 #if defined(_MSC_VER)
@@ -1665,6 +1671,7 @@ void ExecutorRegVm::ExecCheckedReturn(unsigned typeId, RegVmRegister * const reg
 
 			char *copy = (char*)NULLC::AllocObject(exLinker->exTypes[type.subType].size * length, type.subType);
 			memcpy(copy, ptr, unsigned(exLinker->exTypes[type.subType].size * length));
+			NULLC::WriteBarrier(copy);
 			vmStorePointer(returnValuePtr, copy);
 		}
 		else
@@ -1673,6 +1680,7 @@ void ExecutorRegVm::ExecCheckedReturn(unsigned typeId, RegVmRegister * const reg
 
 			char *copy = (char*)NULLC::AllocObject(objSize, typeId);
 			memcpy(copy, ptr, objSize);
+			NULLC::WriteBarrier(copy);
 			vmStorePointer(returnValuePtr, copy);
 		}
 
@@ -1737,6 +1745,25 @@ char* ExecutorRegVm::GetVariableData(unsigned *count)
 	return dataStack.data;
 }
 
+char* ExecutorRegVm::PrepareGlobalData()
+{
+	if(codeRunning)
+		return NULL;
+
+	CommonSetLinker(exLinker);
+
+	// Storage is reserved the same way as in InitExecution, so that the contents are kept when a function is called
+	dataStack.reserve(minStackSize);
+	dataStack.clear();
+	dataStack.resize((exLinker->globalVarSize + 0xf) & ~0xf);
+
+	memset(dataStack.data, 0, dataStack.size());
+
+	GC::SetUnmanagableRange(dataStack.data, dataStack.max);
+
+	return dataStack.data;
+}
+
 unsigned ExecutorRegVm::GetCallStackAddress(unsigned frame)
 {
 	if(frame >= callStack.size())
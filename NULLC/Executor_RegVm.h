@@ -36,6 +36,9 @@ public:
 
 	char*		GetVariableData(unsigned *count);
 
+	// Reset global variable storage of the linked program without running global code
+	char*		PrepareGlobalData();
+
 	unsigned	GetCallStackAddress(unsigned frame);
 
 	void*		GetStackStart();
@@ -6,6 +6,7 @@
 
 #include "nullc.h"
 #include "nullc_debug.h"
+#include "nullc_internal.h"
 #include "Executor_X86.h"
 #include "CodeGen_X86.h"
 #include "CodeGenRegVm_X86.h"
@@ -13,6 +14,7 @@
 #include "Linker.h"
 #include "StdLib.h"
 #include "InstructionTreeRegVmLowerGraph.h"
+#include "JitDebugInfo.h"
 
 #if !defined(NULLC_NO_RAW_EXTERNAL_CALL)
 #define dcAllocMem NULLC::alloc
@@ -82,6 +84,7 @@ struct UNWIND_INFO_FUNCTION
 #else
 
 #include <sys/mman.h>
+#include <unistd.h>
 #ifndef PAGESIZE
 	// $ sysconf()
 	#define PAGESIZE 4096
@@ -267,12 +270,53 @@ namespace NULLC
 #define EXCEPTION_INVALID_POINTER 4
 
 	sigjmp_buf errorHandler;
+
+	// Previous signal handlers and signal mask of the host while a call session is active
+	struct sigaction sessionSigFPE;
+	struct sigaction sessionSigTRAP;
+	struct sigaction sessionSigSEGV;
+
+	bool sessionSignalsInstalled = false;
+
+	sigset_t sessionSignalMask;
 	
 	struct JmpBufData
 	{
 		char data[sizeof(sigjmp_buf)];
 	};
 
+	// Signals that didn't come from NULLC code are passed to the handler that was installed before the call session
+	void ForwardSignal(int signum, siginfo_t *info, void *ucontext)
+	{
+		struct sigaction *previous = NULL;
+
+		if(sessionSignalsInstalled)
+		{
+			if(signum == SIGFPE)
+				previous = &sessionSigFPE;
+			else if(signum == SIGTRAP)
+				previous = &sessionSigTRAP;
+			else if(signum == SIGSEGV)
+				previous = &sessionSigSEGV;
+		}
+
+		if(previous && (previous->sa_flags & SA_SIGINFO) && previous->sa_sigaction)
+		{
+			previous->sa_sigaction(signum, info, ucontext);
+			return;
+		}
+
+		// Ignored fault would be raised again by the same instruction, so default action is taken instead
+		if(previous && !(previous->sa_flags & SA_SIGINFO) && previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+		{
+			previous->sa_handler(signum);
+			return;
+		}
+
+		signal(signum, SIG_DFL);
+		raise(signum);
+	}
+
 	void HandleError(int signum, siginfo_t *info, void *ucontext)
 	{
 		if(signum == SIGSEGV && uintptr_t(info->si_addr) >= uintptr_t(currExecutor->vmState.callStackEnd) && uintptr_t(info->si_addr) <= uintptr_t(currExecutor->vmState.callStackEnd) + 8192)
@@ -318,8 +362,7 @@ namespace NULLC
 
 		if(!isInternal)
 		{
-			signal(signum, SIG_DFL);
-			raise(signum);
+			ForwardSignal(signum, info, ucontext);
 			return;
 		}
 
@@ -341,8 +384,7 @@ namespace NULLC
 			siglongjmp(errorHandler, 1);
 		}
 
-		signal(signum, SIG_DFL);
-		raise(signum);
+		ForwardSignal(signum, info, ucontext);
 	}
 
 	int MemProtect(void *addr, unsigned size, int type)
@@ -381,7 +423,7 @@ namespace NULLC
 	}
 
 	typedef void (*codegenCallback)(CodeGenRegVmContext &ctx, RegVmCmd);
-	codegenCallback cgFuncs[rviConvertPtr + 1];
+	codegenCallback cgFuncs[rviWriteBarrier + 1];
 }
 
 ExecutorX86::ExecutorX86(Linker *linker): exLinker(linker), exTypes(linker->exTypes), exFunctions(linker->exFunctions), exRegVmCode(linker->exRegVmCode), exRegVmConstants(linker->exRegVmConstants), exRegVmRegKillInfo(linker->exRegVmRegKillInfo)
@@ -395,6 +437,8 @@ ExecutorX86::ExecutorX86(Linker *linker): exLinker(linker), exTypes(linker->exTy
 
 	codeRunning = false;
 
+	callSessionActive = false;
+
 	minStackSize = 1 * 1024 * 1024;
 
 	lastFinalReturn = 0;
@@ -427,11 +471,18 @@ ExecutorX86::ExecutorX86(Linker *linker): exLinker(linker), exTypes(linker->exTy
 	oldFunctionSize = 0;
 	oldCodeBodyProtect = 0;
 
+	nativeCodeCachePath = NULL;
+	nativeCodeCacheHits = 0;
+
 	NULLC::currExecutor = this;
 }
 
 ExecutorX86::~ExecutorX86()
 {
+	codeRunning = false;
+
+	EndCallSession();
+
 	NULLC::dealloc(execErrorBuffer);
 
 	NULLC::AllowMemoryPageRead(vmState.callStackEnd);
@@ -469,6 +520,8 @@ ExecutorX86::~ExecutorX86()
 
 	NULLC::dealloc(binCode);
 
+	NULLC::dealloc(nativeCodeCachePath);
+
 	NULLC::currExecutor = NULL;
 
 	x86ResetLabels();
@@ -575,6 +628,7 @@ bool ExecutorX86::Initialize()
 	cgFuncs[rviLogNot] = GenCodeCmdLogNot;
 	cgFuncs[rviLogNotl] = GenCodeCmdLogNotl;
 	cgFuncs[rviConvertPtr] = GenCodeCmdConvertPtr;
+	cgFuncs[rviWriteBarrier] = GenCodeCmdWriteBarrier;
 
 	// Create code launch header
 	unsigned char *pos = codeLaunchHeader;
@@ -986,7 +1040,7 @@ bool ExecutorX86::Run(unsigned int functionID, const char *arguments)
 		struct sigaction sigTRAP;
 		struct sigaction sigSEGV;
 
-		if(firstRun)
+		if(firstRun && !callSessionActive)
 		{
 			sa.sa_sigaction = NULLC::HandleError;
 			sigemptyset(&sa.sa_mask);
@@ -1002,7 +1056,8 @@ bool ExecutorX86::Run(unsigned int functionID, const char *arguments)
 		NULLC::JmpBufData data;
 		memcpy(data.data, NULLC::errorHandler, sizeof(sigjmp_buf));
 
-		if(!(errorCode = sigsetjmp(NULLC::errorHandler, 1)))
+		// Signal mask is restored manually in a call session to skip a system call on each entry
+		if(!(errorCode = sigsetjmp(NULLC::errorHandler, !callSessionActive)))
 		{
 			unsigned char *codeStart = instAddress[instructionPos];
 
@@ -1024,11 +1079,14 @@ bool ExecutorX86::Run(unsigned int functionID, const char *arguments)
 		}
 		else
 		{
+			if(callSessionActive)
+				sigprocmask(SIG_SETMASK, &NULLC::sessionSignalMask, NULL);
+
 			resultType = rvrError;
 		}
 
 		// Disable signal handlers only from top-level Run
-		if(lastFinalReturn == 0)
+		if(lastFinalReturn == 0 && !callSessionActive)
 		{
 			sigaction(SIGFPE, &sigFPE, NULL);
 			sigaction(SIGTRAP, &sigTRAP, NULL);
@@ -1188,6 +1246,54 @@ void ExecutorX86::Resume()
 	execErrorObject.ptr = NULL;
 }
 
+bool ExecutorX86::BeginCallSession()
+{
+	if(codeRunning)
+	{
+		Stop("ERROR: can't begin call session while code is running");
+		return false;
+	}
+
+	if(callSessionActive)
+		return true;
+
+#ifdef __linux
+	struct sigaction sa;
+
+	sa.sa_sigaction = NULLC::HandleError;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART | SA_SIGINFO;
+
+	sigaction(SIGFPE, &sa, &NULLC::sessionSigFPE);
+	sigaction(SIGTRAP, &sa, &NULLC::sessionSigTRAP);
+	sigaction(SIGSEGV, &sa, &NULLC::sessionSigSEGV);
+
+	sigprocmask(SIG_SETMASK, NULL, &NULLC::sessionSignalMask);
+
+	NULLC::sessionSignalsInstalled = true;
+#endif
+
+	callSessionActive = true;
+
+	return true;
+}
+
+void ExecutorX86::EndCallSession()
+{
+	if(!callSessionActive || codeRunning)
+		return;
+
+#ifdef __linux
+	sigaction(SIGFPE, &NULLC::sessionSigFPE, NULL);
+	sigaction(SIGTRAP, &NULLC::sessionSigTRAP, NULL);
+	sigaction(SIGSEGV, &NULLC::sessionSigSEGV, NULL);
+
+	NULLC::sessionSignalsInstalled = false;
+#endif
+
+	callSessionActive = false;
+}
+
 bool ExecutorX86::SetStackSize(unsigned bytes)
 {
 	if(codeRunning || !instList.empty())
@@ -1208,6 +1314,25 @@ bool ExecutorX86::SetStackSize(unsigned bytes)
 	return true;
 }
 
+void ExecutorX86::SetNativeCodeCachePath(const char *path)
+{
+	NULLC::dealloc(nativeCodeCachePath);
+	nativeCodeCachePath = NULL;
+
+	if(path && *path)
+	{
+		unsigned length = unsigned(strlen(path));
+
+		nativeCodeCachePath = (char*)NULLC::alloc(length + 1);
+		memcpy(nativeCodeCachePath, path, length + 1);
+	}
+}
+
+unsigned ExecutorX86::GetNativeCodeCacheHits()
+{
+	return nativeCodeCacheHits;
+}
+
 void ExecutorX86::ClearNative()
 {
 	if (instList.size())
@@ -1219,6 +1344,10 @@ void ExecutorX86::ClearNative()
 
 	globalCodeRanges.clear();
 
+	externalAddress.clear();
+
+	NULLC::JitGdbUnregisterCode();
+
 	for(unsigned i = 0; i < expiredCodeBlocks.size(); i++)
 	{
 		ExpiredCodeBlock &block = expiredCodeBlocks[i];
@@ -1363,8 +1492,57 @@ bool ExecutorX86::TranslateToNative(bool enableLogFiles, OutputContext &output)
 
 	vmState.functionAddress = functionAddress.data;
 
+	// Find external functions that can be called without a wrapper
+	unsigned oldExternalAddressCount = externalAddress.size();
+
+	externalAddress.resize(exFunctions.size());
+
+	for(unsigned i = oldExternalAddressCount; i < exFunctions.size(); i++)
+		externalAddress[i] = GetExternalCallTarget(*codeGenCtx, i);
+
+	vmState.externalAddress = externalAddress.data;
+	vmState.callContinue = &callContinue;
+
+	// Native code cache can only provide the whole program
+	bool useNativeCodeCache = nativeCodeCachePath && binCodeSize == 0 && !codeRunning;
+
+	FastVector<char> nativeCodeKey;
+
+	if(useNativeCodeCache)
+		GetNativeCodeKey(nativeCodeKey);
+
+	unsigned nativeCodeHash = useNativeCodeCache ? NULLC::GetStringHash(nativeCodeKey.data, nativeCodeKey.data + nativeCodeKey.size()) : 0;
+
+	if(useNativeCodeCache && LoadNativeCode(nativeCodeKey, nativeCodeHash))
+	{
+		nativeCodeCacheHits++;
+
+		// Remove extra global return mirror
+		codeJumpTargets.pop_back();
+
+		for(unsigned int i = 0; i < exFunctions.size(); i++)
+		{
+			if(exFunctions[i].regVmAddress != -1)
+				functionAddress[i] = instAddress[exFunctions[i].regVmAddress];
+			else
+				functionAddress[i] = 0;
+		}
+
+		lastInstructionCount = exRegVmCode.size();
+
+		oldJumpTargetCount = exLinker->regVmJumpTargets.size();
+		oldRegKillInfoCount = exRegVmRegKillInfo.size();
+		oldFunctionSize = exFunctions.size();
+
+		RegisterNativeCode(0, 0);
+
+		return true;
+	}
+
 	SetOptimizationLookBehind(codeGenCtx->ctx, false);
 
+	unsigned oldGlobalCodeRangeCount = globalCodeRanges.size();
+
 	unsigned activeGlobalCodeStart = 0;
 
 	unsigned int pos = lastInstructionCount;
@@ -1972,17 +2150,358 @@ bool ExecutorX86::TranslateToNative(bool enableLogFiles, OutputContext &output)
 
 	lastInstructionCount = exRegVmCode.size();
 
+	RegisterNativeCode(codeRelocated ? 0 : oldFunctionSize, codeRelocated ? 0 : oldGlobalCodeRangeCount);
+
 	oldJumpTargetCount = exLinker->regVmJumpTargets.size();
 	oldRegKillInfoCount = exRegVmRegKillInfo.size();
 	oldFunctionSize = exFunctions.size();
 
+	if(useNativeCodeCache)
+		SaveNativeCode(nativeCodeKey, nativeCodeHash);
+
+	return true;
+}
+
+namespace
+{
+	const unsigned nativeCodeCacheMagic = 0x544a4e4e; // 'NNJT'
+
+	// Has to be increased with every change to the code generator or to the file layout
+	const unsigned nativeCodeCacheVersion = 3;
+
+	// Code generated for x86-64 is position-independent: vmState is addressed through r13, constants through r14, calls go through vmState->functionAddress and jumps are relative
+	// Relocation records are instruction offsets from the code start which are rebased on load, function addresses are then restored from instruction addresses
+	struct NativeCodeCacheHeader
+	{
+		unsigned magic;
+		unsigned version;
+		unsigned hash;
+
+		// Complete key the hash was computed from follows the header
+		unsigned keySize;
+
+		unsigned instructionCount;
+		unsigned functionCount;
+		unsigned constantCount;
+
+		unsigned labelCount;
+		unsigned globalCodeRangeCount;
+		unsigned codeSize;
+	};
+
+	void GetNativeCodeCacheFileName(char *buf, unsigned bufSize, const char *path, unsigned hash)
+	{
+		unsigned length = unsigned(strlen(path));
+
+		bool hasSeparator = path[length - 1] == '/' || path[length - 1] == '\\';
+
+		NULLC::SafeSprintf(buf, bufSize, "%s%snullc_x64_%08x.bin", path, hasSeparator ? "" : "/", hash);
+	}
+}
+
+// Cache key contains everything native code generation depends on, hash of the key only selects the file
+void ExecutorX86::GetNativeCodeKey(FastVector<char> &key)
+{
+	unsigned layout[] = { nativeCodeCacheVersion, GetCodeGenOptions(), NULLC_PTR_SIZE, unsigned(sizeof(CodeGenRegVmStateContext)), exRegVmCode.size(), exRegVmConstants.size(), exRegVmRegKillInfo.size(), exLinker->regVmJumpTargets.size(), exFunctions.size() };
+	key.push_back((char*)layout, sizeof(layout));
+
+	if(!exRegVmCode.empty())
+		key.push_back((char*)exRegVmCode.data, exRegVmCode.size() * sizeof(exRegVmCode[0]));
+
+	if(!exRegVmConstants.empty())
+		key.push_back((char*)exRegVmConstants.data, exRegVmConstants.size() * sizeof(exRegVmConstants[0]));
+
+	if(!exRegVmRegKillInfo.empty())
+		key.push_back((char*)exRegVmRegKillInfo.data, exRegVmRegKillInfo.size() * sizeof(exRegVmRegKillInfo[0]));
+
+	if(!exLinker->regVmJumpTargets.empty())
+		key.push_back((char*)exLinker->regVmJumpTargets.data, exLinker->regVmJumpTargets.size() * sizeof(exLinker->regVmJumpTargets[0]));
+
+	// External function info contains host pointers, so only the parts that affect code generation are included
+	for(unsigned i = 0; i < exFunctions.size(); i++)
+	{
+		ExternFuncInfo &function = exFunctions[i];
+
+		unsigned info[] = { unsigned(function.regVmAddress), unsigned(function.regVmCodeSize), unsigned(function.regVmRegisters), unsigned(function.builtinIndex), function.stackSize, function.bytesToPop, function.retType, function.funcType, function.contextType, unsigned(externalAddress[i] != NULL) };
+		key.push_back((char*)info, sizeof(info));
+
+		// Direct external calls place arguments according to the wrapper signature and argument types
+		if(externalAddress[i])
+		{
+			const char *signature = nullcGetModuleFunctionWrapperSignature(function.funcPtrWrap);
+
+			key.push_back(signature, unsigned(strlen(signature)) + 1);
+
+			unsigned shape[] = { function.paramCount, unsigned(function.returnShift) };
+			key.push_back((char*)shape, sizeof(shape));
+
+			for(unsigned k = 0; k < function.paramCount; k++)
+			{
+				ExternTypeInfo &type = exTypes[exLinker->exLocals[function.offsetToFirstLocal + k].type];
+
+				unsigned typeInfo[] = { unsigned(type.type), unsigned(type.subCat), type.size, type.subCat == ExternTypeInfo::CAT_ARRAY ? type.arrSize : 0 };
+				key.push_back((char*)typeInfo, sizeof(typeInfo));
+			}
+		}
+	}
+}
+
+bool ExecutorX86::LoadNativeCode(const FastVector<char> &key, unsigned hash)
+{
+#if defined(_M_X64) && defined(__linux)
+	char fileName[1024];
+	GetNativeCodeCacheFileName(fileName, 1024, nativeCodeCachePath, hash);
+
+	FILE *file = fopen(fileName, "rb");
+
+	if(!file)
+		return false;
+
+	NativeCodeCacheHeader header;
+
+	if(fread(&header, sizeof(header), 1, file) != 1)
+	{
+		fclose(file);
+		return false;
+	}
+
+	if(header.magic != nativeCodeCacheMagic || header.version != nativeCodeCacheVersion || header.hash != hash || header.keySize != key.size())
+	{
+		fclose(file);
+		return false;
+	}
+
+	// Files of different programs can share the hash
+	FastVector<char> storedKey;
+	storedKey.resize(header.keySize);
+
+	if(fread(storedKey.data, 1, header.keySize, file) != header.keySize || memcmp(storedKey.data, key.data, header.keySize) != 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	if(header.instructionCount != exRegVmCode.size() || header.functionCount != exFunctions.size() || header.constantCount != exRegVmConstants.size() || header.codeSize == 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	FastVector<unsigned> instOffsets;
+	instOffsets.resize(header.instructionCount + 1);
+
+	FastVector<unsigned> codeRanges;
+	codeRanges.resize(header.globalCodeRangeCount);
+
+	bool valid = fread(instOffsets.data, sizeof(unsigned), instOffsets.size(), file) == instOffsets.size();
+
+	if(valid && !codeRanges.empty())
+		valid = fread(codeRanges.data, sizeof(unsigned), codeRanges.size(), file) == codeRanges.size();
+
+	for(unsigned i = 0; valid && i < instOffsets.size(); i++)
+	{
+		if(instOffsets[i] != ~0u && instOffsets[i] >= header.codeSize)
+			valid = false;
+	}
+
+	for(unsigned i = 0; valid && i < codeRanges.size(); i++)
+	{
+		if(codeRanges[i] > header.instructionCount)
+			valid = false;
+	}
+
+	if(!valid)
+	{
+		fclose(file);
+		return false;
+	}
+
+	if(header.codeSize > binCodeReserved)
+	{
+		unsigned int oldBinCodeReserved = binCodeReserved;
+		binCodeReserved = header.codeSize + 4096;
+		unsigned char *binCodeNew = (unsigned char*)NULLC::alloc(binCodeReserved);
+
+		if(binCode)
+			NULLC::MemProtect((void*)binCode, oldBinCodeReserved, PROT_READ | PROT_WRITE);
+		NULLC::MemProtect((void*)binCodeNew, binCodeReserved, PROT_READ | PROT_WRITE | PROT_EXEC);
+
+		NULLC::dealloc(binCode);
+
+		binCode = binCodeNew;
+	}
+
+	valid = fread(binCode, 1, header.codeSize, file) == header.codeSize;
+
+	fclose(file);
+
+	if(!valid)
+		return false;
+
+	binCodeSize = header.codeSize;
+
+	// Apply relocations
+	instAddress.resize(header.instructionCount + 1);
+
+	for(unsigned i = 0; i < instOffsets.size(); i++)
+		instAddress[i] = instOffsets[i] != ~0u ? binCode + instOffsets[i] : NULL;
+
+	vmState.instAddress = instAddress.data;
+
+	globalCodeRanges.clear();
+
+	for(unsigned i = 0; i < codeRanges.size(); i++)
+		globalCodeRanges.push_back(codeRanges[i]);
+
+	// Labels of the restored code are already resolved, but new code has to continue the numbering
+	codeGenCtx->labelCount = header.labelCount;
+
+	GenCodeSetupWrappers(&vmState);
+
 	return true;
+#else
+	(void)key;
+	(void)hash;
+
+	return false;
+#endif
+}
+
+void ExecutorX86::SaveNativeCode(const FastVector<char> &key, unsigned hash)
+{
+#if defined(_M_X64) && defined(__linux)
+	char fileName[1024];
+	GetNativeCodeCacheFileName(fileName, 1024, nativeCodeCachePath, hash);
+
+	// File is written under a temporary name and renamed over the target, so that readers never see a partial file
+	char tempFileName[1024 + 32];
+	NULLC::SafeSprintf(tempFileName, 1024 + 32, "%s.%d.tmp", fileName, int(getpid()));
+
+	FILE *file = fopen(tempFileName, "wb");
+
+	if(!file)
+		return;
+
+	NativeCodeCacheHeader header;
+
+	header.magic = nativeCodeCacheMagic;
+	header.version = nativeCodeCacheVersion;
+	header.hash = hash;
+	header.keySize = key.size();
+
+	header.instructionCount = exRegVmCode.size();
+	header.functionCount = exFunctions.size();
+	header.constantCount = exRegVmConstants.size();
+
+	header.labelCount = codeGenCtx->labelCount;
+	header.globalCodeRangeCount = globalCodeRanges.size();
+	header.codeSize = binCodeSize;
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	if(success && !key.empty())
+		success = fwrite(key.data, 1, key.size(), file) == key.size();
+
+	for(unsigned i = 0; success && i < instAddress.size(); i++)
+	{
+		unsigned offset = instAddress[i] ? unsigned(instAddress[i] - binCode) : ~0u;
+
+		success = fwrite(&offset, sizeof(offset), 1, file) == 1;
+	}
+
+	if(success && !globalCodeRanges.empty())
+		success = fwrite(globalCodeRanges.data, sizeof(unsigned), globalCodeRanges.size(), file) == globalCodeRanges.size();
+
+	if(success && binCodeSize)
+		success = fwrite(binCode, 1, binCodeSize, file) == binCodeSize;
+
+	// Buffered data is only written out on close
+	if(fclose(file) != 0)
+		success = false;
+
+	if(!success || rename(tempFileName, fileName) != 0)
+		unlink(tempFileName);
+#else
+	(void)key;
+	(void)hash;
+#endif
+}
+
+unsigned char* ExecutorX86::GetCodeRangeEnd(unsigned instruction)
+{
+	// Instructions that didn't generate any code have no address
+	for(unsigned i = instruction; i < instAddress.size(); i++)
+	{
+		if(instAddress[i])
+			return instAddress[i];
+	}
+
+	return binCode + binCodeSize;
+}
+
+void ExecutorX86::RegisterNativeCode(unsigned firstFunction, unsigned firstGlobalCodeRange)
+{
+	if(!NULLC::JitPerfIsEnabled() && !NULLC::JitGdbIsEnabled())
+		return;
+
+	// Code was relocated and all of it is registered again
+	if(firstFunction == 0 && firstGlobalCodeRange == 0)
+		NULLC::JitGdbUnregisterCode();
+
+	FastVector<JitCodeSymbol> symbols;
+
+	for(unsigned i = firstFunction; i < exFunctions.size(); i++)
+	{
+		ExternFuncInfo &funcInfo = exFunctions[i];
+
+		if(funcInfo.regVmAddress == -1 || !instAddress[funcInfo.regVmAddress])
+			continue;
+
+		JitCodeSymbol symbol;
+
+		symbol.name = exLinker->exSymbols.data + funcInfo.offsetToName;
+
+		symbol.codeStart = instAddress[funcInfo.regVmAddress];
+		symbol.codeEnd = GetCodeRangeEnd(funcInfo.regVmAddress + funcInfo.regVmCodeSize);
+
+		symbol.instStart = funcInfo.regVmAddress;
+		symbol.instEnd = funcInfo.regVmAddress + funcInfo.regVmCodeSize;
+
+		if(symbol.codeEnd > symbol.codeStart)
+			symbols.push_back(symbol);
+	}
+
+	for(unsigned i = firstGlobalCodeRange & ~1u; i + 1 < globalCodeRanges.size(); i += 2)
+	{
+		if(!instAddress[globalCodeRanges[i]])
+			continue;
+
+		JitCodeSymbol symbol;
+
+		symbol.name = "global code";
+
+		symbol.codeStart = instAddress[globalCodeRanges[i]];
+		symbol.codeEnd = GetCodeRangeEnd(globalCodeRanges[i + 1]);
+
+		symbol.instStart = globalCodeRanges[i];
+		symbol.instEnd = globalCodeRanges[i + 1];
+
+		if(symbol.codeEnd > symbol.codeStart)
+			symbols.push_back(symbol);
+	}
+
+	NULLC::JitPerfRegisterCode(exLinker, instAddress.data, symbols.data, symbols.size());
+	NULLC::JitGdbRegisterCode(exLinker, instAddress.data, symbols.data, symbols.size());
 }
 
 void ExecutorX86::UpdateFunctionPointer(unsigned source, unsigned target)
 {
 	functionAddress[source] = functionAddress[target];
 
+	// Direct call to the previous external function is no longer valid
+	if(source < externalAddress.size())
+		externalAddress[source] = NULL;
+
 	for(unsigned i = 0; i < expiredFunctionAddressLists.size(); i++)
 	{
 		ExpiredFunctionAddressList &info = expiredFunctionAddressLists[i];
@@ -2130,6 +2649,28 @@ char* ExecutorX86::GetVariableData(unsigned int *count)
 	return vmState.dataStackBase;
 }
 
+char* ExecutorX86::PrepareGlobalData()
+{
+	if(codeRunning || !vmState.dataStackBase)
+		return NULL;
+
+	CommonSetLinker(exLinker);
+
+	vmState.dataStackTop = vmState.dataStackBase + ((exLinker->globalVarSize + 0xf) & ~0xf);
+
+	if(vmState.dataStackTop >= vmState.dataStackEnd)
+	{
+		vmState.dataStackTop = vmState.dataStackBase;
+		return NULL;
+	}
+
+	memset(vmState.dataStackBase, 0, exLinker->globalVarSize);
+
+	GC::SetUnmanagableRange(vmState.dataStackBase, unsigned(vmState.dataStackEnd - vmState.dataStackBase));
+
+	return vmState.dataStackBase;
+}
+
 unsigned int ExecutorX86::GetCallStackAddress(unsigned frame)
 {
 	return frame >= unsigned(vmState.callStackTop - vmState.callStackBase) ? 0 : vmState.callStackBase[frame].instruction;
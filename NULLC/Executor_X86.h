@@ -41,8 +41,14 @@ public:
 	void	Stop(NULLCRef error);
 	void	Resume();
 
+	bool	BeginCallSession();
+	void	EndCallSession();
+
 	bool	SetStackSize(unsigned bytes);
 
+	void	SetNativeCodeCachePath(const char *path);
+	unsigned	GetNativeCodeCacheHits();
+
 	unsigned	GetResultType();
 	NULLCRef	GetResultObject();
 	const char*	GetResult();
@@ -55,6 +61,9 @@ public:
 
 	char*		GetVariableData(unsigned int *count);
 
+	// Reset global variable storage of the linked program without running global code
+	char*		PrepareGlobalData();
+
 	unsigned	GetCallStackAddress(unsigned frame);
 
 	void*		GetStackStart();
@@ -71,10 +80,20 @@ public:
 private:
 	bool	InitExecution();
 
+	void		GetNativeCodeKey(FastVector<char> &key);
+	bool		LoadNativeCode(const FastVector<char> &key, unsigned hash);
+	void		SaveNativeCode(const FastVector<char> &key, unsigned hash);
+
+	unsigned char*	GetCodeRangeEnd(unsigned instruction);
+	void			RegisterNativeCode(unsigned firstFunction, unsigned firstGlobalCodeRange);
+
 	CodeGenRegVmContext *codeGenCtx;
 
 	bool	codeRunning;
 
+	// Signal handlers stay installed between top-level calls
+	bool	callSessionActive;
+
 	static const unsigned execResultSize = 512;
 	char	execResult[execResultSize];
 
@@ -139,6 +158,9 @@ private:
 	unsigned int	oldFunctionSize;
 	unsigned int	oldCodeBodyProtect;
 
+	char	*nativeCodeCachePath;
+	unsigned	nativeCodeCacheHits;
+
 public:
 	bool			callContinue;
 
@@ -156,6 +178,8 @@ public:
 	};
 	FastVector<ExpiredFunctionAddressList> expiredFunctionAddressLists;
 
+	FastVector<void*> externalAddress;
+
 	FastVector<unsigned> globalCodeRanges;
 
 #ifdef _M_X64
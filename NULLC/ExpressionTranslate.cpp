@@ -317,11 +317,28 @@ void TranslateTypeDefinition(ExpressionTranslateContext &ctx, TypeBase *type)
 		PrintIndentedLine(ctx, "{");
 		ctx.depth++;
 
+		// Members of 'align(auto)' classes are listed in declaration order, structure has to follow their offsets
+		SmallArray<MemberHandle*, 32> layout(ctx.allocator);
+
+		for(MemberHandle *curr = typeClass->members.head; curr; curr = curr->next)
+		{
+			layout.push_back(curr);
+
+			for(unsigned i = layout.size() - 1; i > 0 && layout[i - 1]->variable->offset > layout[i]->variable->offset; i--)
+			{
+				MemberHandle *tmp = layout[i - 1];
+				layout[i - 1] = layout[i];
+				layout[i] = tmp;
+			}
+		}
+
 		unsigned offset = 0;
 		unsigned index = 0;
 
-		for(MemberHandle *curr = typeClass->members.head; curr; curr = curr->next)
+		for(unsigned i = 0; i < layout.size(); i++)
 		{
+			MemberHandle *curr = layout[i];
+
 			if(curr->variable->offset > offset)
 				PrintIndentedLine(ctx, "char pad_%d[%d];", index, int(curr->variable->offset - offset));
 
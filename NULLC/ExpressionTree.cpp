@@ -657,6 +657,56 @@ namespace
 		return variable;
 	}
 
+	void ReorderClassMembers(TypeClass *type, MemberHandle *lastFixed, long long start)
+	{
+		MemberHandle *first = lastFixed ? lastFixed->next : type->members.head;
+
+		if(!first)
+			return;
+
+		// Member list stays in declaration order for initialization and reflection, only the offsets change
+		unsigned pending = 0;
+
+		for(MemberHandle *curr = first; curr; curr = curr->next)
+		{
+			curr->variable->offset = ~0u;
+			pending++;
+		}
+
+		long long offset = start;
+
+		// Next member is the one with the largest alignment that can be placed without padding, so that the gaps after fixed members are filled with smaller ones
+		for(; pending; pending--)
+		{
+			MemberHandle *best = NULL;
+			bool bestFits = false;
+
+			for(MemberHandle *curr = first; curr; curr = curr->next)
+			{
+				if(curr->variable->offset != ~0u)
+					continue;
+
+				unsigned alignment = curr->variable->alignment;
+				bool fits = GetAlignmentOffset(offset, alignment) == 0;
+
+				if(!best || (fits && !bestFits) || (fits == bestFits && alignment > best->variable->alignment))
+				{
+					best = curr;
+					bestFits = fits;
+				}
+			}
+
+			offset += GetAlignmentOffset(offset, best->variable->alignment);
+
+			best->variable->offset = unsigned(offset);
+
+			offset += best->variable->type->size;
+		}
+
+		type->size = offset;
+		type->typeScope->dataSize = offset;
+	}
+
 	void FinalizeAlignment(TypeStruct *type)
 	{
 		unsigned maximumAlignment = 0;
@@ -3594,6 +3644,10 @@ unsigned AnalyzeAlignment(ExpressionContext &ctx, SynAlign *syntax)
 	if(!syntax->value)
 		return 1;
 
+	// align(auto)
+	if(isType<SynTypeAuto>(syntax->value))
+		return 0;
+
 	ExprBase *align = AnalyzeExpression(ctx, syntax->value);
 
 	// Some info about aignment expression tree is lost
@@ -8395,6 +8449,10 @@ ExprBase* AnalyzeVariableDefinition(ExpressionContext &ctx, SynVariableDefinitio
 
 ExprVariableDefinitions* AnalyzeVariableDefinitions(ExpressionContext &ctx, SynVariableDefinitions *syntax)
 {
+	// Member order can only be changed for a whole class
+	if(syntax->align && syntax->align->value && isType<SynTypeAuto>(syntax->align->value))
+		Report(ctx, syntax->align, "ERROR: align(auto) is only allowed on class definitions");
+
 	unsigned alignment = syntax->align ? AnalyzeAlignment(ctx, syntax->align) : 0;
 
 	TypeBase *parentType = ctx.scope->ownerType;
@@ -10324,8 +10382,15 @@ void AnalyzeClassFunctionElements(ExpressionContext &ctx, ExprClassDefinition *c
 
 void AnalyzeClassElements(ExpressionContext &ctx, ExprClassDefinition *classDefinition, SynClassElements *syntax)
 {
+	// Type id and base class members keep their locations
+	MemberHandle *lastFixed = classDefinition->classType->members.tail;
+	long long fixedSize = classDefinition->classType->typeScope->dataSize;
+
 	AnalyzeClassBaseElements(ctx, classDefinition, syntax);
 
+	if(classDefinition->classType->reorderMembers)
+		ReorderClassMembers(classDefinition->classType, lastFixed, fixedSize);
+
 	FinalizeAlignment(classDefinition->classType);
 
 	assert(!classDefinition->classType->completed);
@@ -10364,9 +10429,14 @@ unsigned AddBaseClassMemberVariables(ExpressionContext &ctx, SynBase *syntax, Ty
 
 		bool conflict = CheckVariableConflict(ctx, syntax, el->variable->name->name);
 
-		unsigned offset = AllocateVariableInScope(ctx, syntax, el->variable->alignment, el->variable->type);
+		// Members of an 'align(auto)' base class are not listed in the order of their offsets
+		unsigned offset = el->variable->offset;
 
-		assert(offset == el->variable->offset);
+		if(offset + el->variable->type->size > newClass->typeScope->dataSize)
+		{
+			newClass->typeScope->dataSize = offset + el->variable->type->size;
+			newClass->size = newClass->typeScope->dataSize;
+		}
 
 		VariableData *member = new (ctx.get<VariableData>()) VariableData(ctx.allocator, syntax, ctx.scope, el->variable->alignment, el->variable->type, el->variable->name, offset, ctx.uniqueVariableId++);
 
@@ -10564,8 +10634,12 @@ ExprBase* AnalyzeClassDefinition(ExpressionContext &ctx, SynClassDefinition *syn
 	}
 
 	if(syntax->align)
+	{
 		classType->alignment = alignment;
 
+		classType->reorderMembers = syntax->align->value && isType<SynTypeAuto>(syntax->align->value);
+	}
+
 	AnalyzeClassElements(ctx, classDefinition, syntax->elements);
 
 	ctx.PopScope(SCOPE_TYPE);
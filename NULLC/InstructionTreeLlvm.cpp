@@ -335,6 +335,22 @@ char* CreateLlvmFunctionName(LlvmCompilationContext &ctx, FunctionData *function
 	return name;
 }
 
+// Members of 'align(auto)' classes are listed in declaration order, structure body has to follow their offsets
+void GetLlvmClassMemberLayout(TypeClass *typeClass, SmallArray<MemberHandle*, 32> &layout)
+{
+	for(MemberHandle *curr = typeClass->members.head; curr; curr = curr->next)
+	{
+		layout.push_back(curr);
+
+		for(unsigned i = layout.size() - 1; i > 0 && layout[i - 1]->variable->offset > layout[i]->variable->offset; i--)
+		{
+			MemberHandle *tmp = layout[i - 1];
+			layout[i - 1] = layout[i];
+			layout[i] = tmp;
+		}
+	}
+}
+
 LLVMTypeRef CompileLlvmType(LlvmCompilationContext &ctx, TypeBase *type)
 {
 	if(LLVMTypeRef llvmType = ctx.types[type->typeIndex])
@@ -425,10 +441,14 @@ LLVMTypeRef CompileLlvmType(LlvmCompilationContext &ctx, TypeBase *type)
 	{
 		ctx.types[type->typeIndex] = LLVMStructCreateNamed(ctx.context, CreateLlvmName(ctx, typeClass->name));
 
+		SmallArray<MemberHandle*, 32> layout(ctx.allocator);
+
+		GetLlvmClassMemberLayout(typeClass, layout);
+
 		SmallArray<LLVMTypeRef, 32> members(ctx.allocator);
 
-		for(MemberHandle *curr = typeClass->members.head; curr; curr = curr->next)
-			members.push_back(CompileLlvmType(ctx, curr->variable->type));
+		for(unsigned i = 0; i < layout.size(); i++)
+			members.push_back(CompileLlvmType(ctx, layout[i]->variable->type));
 
 		// TODO: create packed type with custom padding
 		LLVMStructSetBody(ctx.types[type->typeIndex], members.data, members.count, false);
@@ -1403,15 +1423,34 @@ LLVMValueRef CompileLlvmMemberAccess(LlvmCompilationContext &ctx, ExprMemberAcce
 	if(isType<TypeUnsizedArray>(typeStruct))
 		currMember++;
 
-	for(MemberHandle *curr = typeStruct->members.head; curr; curr = curr->next)
+	if(TypeClass *typeClass = getType<TypeClass>(typeStruct))
 	{
-		if(curr->variable == node->member->variable)
+		// Class structure body is created in the order of member offsets
+		SmallArray<MemberHandle*, 32> layout(ctx.allocator);
+
+		GetLlvmClassMemberLayout(typeClass, layout);
+
+		for(unsigned i = 0; i < layout.size(); i++)
 		{
-			memberIndex = currMember;
-			break;
+			if(layout[i]->variable == node->member->variable)
+			{
+				memberIndex = currMember + i;
+				break;
+			}
 		}
+	}
+	else
+	{
+		for(MemberHandle *curr = typeStruct->members.head; curr; curr = curr->next)
+		{
+			if(curr->variable == node->member->variable)
+			{
+				memberIndex = currMember;
+				break;
+			}
 
-		currMember++;
+			currMember++;
+		}
 	}
 
 	assert(memberIndex != ~0u);
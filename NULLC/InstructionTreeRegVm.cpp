@@ -196,6 +196,8 @@ const char* GetInstructionName(RegVmInstructionCode code)
 		return "lognotl";
 	case rviConvertPtr:
 		return "convertptr";
+	case rviWriteBarrier:
+		return "writebarrier";
 	case rviFuncAddr:
 		return "funcaddr";
 	case rviTypeid:
@@ -133,6 +133,8 @@ enum RegVmInstructionCode
 
 	rviConvertPtr,
 
+	rviWriteBarrier,
+
 	// Temporary instructions, no execution
 	rviFuncAddr,
 	rviTypeid,
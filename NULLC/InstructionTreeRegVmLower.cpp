@@ -572,6 +572,25 @@ unsigned TryLowerConstantToMemory(RegVmLoweredBlock *lowBlock, VmValue *value)
 	return 0;
 }
 
+bool HasPointers(VmType type)
+{
+	switch(type.type)
+	{
+	case VM_TYPE_POINTER:
+	case VM_TYPE_FUNCTION_REF:
+	case VM_TYPE_ARRAY_REF:
+	case VM_TYPE_AUTO_REF:
+	case VM_TYPE_AUTO_ARRAY:
+		return true;
+	case VM_TYPE_STRUCT:
+		return !type.structType || type.structType->hasPointers;
+	default:
+		break;
+	}
+
+	return false;
+}
+
 unsigned char GetArgumentRegister(ExpressionContext &ctx, RegVmLoweredFunction *lowFunction, RegVmLoweredBlock *lowBlock, VmValue *value)
 {
 	if(isType<VmConstant>(value))
@@ -1096,6 +1115,10 @@ void LowerInstructionIntoBlock(ExpressionContext &ctx, RegVmLoweredFunction *low
 			unsigned char addressReg = GetArgumentRegister(ctx, lowFunction, lowBlock, inst->arguments[0]);
 
 			lowBlock->AddInstruction(ctx, inst->source, rviStoreDword, sourceReg, 0, addressReg, offset);
+
+			// Generational collector has to know about pointers stored into heap objects
+			if(HasPointers(inst->arguments[2]->type))
+				lowBlock->AddInstruction(ctx, inst->source, rviWriteBarrier, 0, 0, addressReg, offset);
 		}
 		break;
 	case VM_INST_STORE_FLOAT:
@@ -1142,6 +1165,10 @@ void LowerInstructionIntoBlock(ExpressionContext &ctx, RegVmLoweredFunction *low
 			unsigned char addressReg = GetArgumentRegister(ctx, lowFunction, lowBlock, inst->arguments[0]);
 
 			lowBlock->AddInstruction(ctx, inst->source, rviStoreLong, sourceReg, 0, addressReg, offset);
+
+			// Generational collector has to know about pointers stored into heap objects
+			if(HasPointers(inst->arguments[2]->type))
+				lowBlock->AddInstruction(ctx, inst->source, rviWriteBarrier, 0, 0, addressReg, offset);
 		}
 		break;
 	case VM_INST_STORE_DOUBLE:
@@ -1416,6 +1443,9 @@ void LowerInstructionIntoBlock(ExpressionContext &ctx, RegVmLoweredFunction *low
 					}
 				}
 			}
+
+			if(HasPointers(inst->arguments[2]->type))
+				lowBlock->AddInstruction(ctx, inst->source, rviWriteBarrier, 0, 0, addressReg, offset);
 		}
 		break;
 	case VM_INST_DOUBLE_TO_INT:
@@ -1647,6 +1677,10 @@ void LowerInstructionIntoBlock(ExpressionContext &ctx, RegVmLoweredFunction *low
 		VmConstant *size = getType<VmConstant>(inst->arguments[4]);
 
 		lowBlock->AddInstruction(ctx, inst->source, rviMemCopy, dstAddressReg, 0, srcAddressReg, size->iValue);
+
+		// Copied memory might contain pointers
+		if(!dstConstant->container)
+			lowBlock->AddInstruction(ctx, inst->source, rviWriteBarrier, 0, 0, dstAddressReg, 0u);
 	}
 	break;
 	case VM_INST_JUMP:
@@ -678,6 +678,9 @@ void PrintInstruction(OutputContext &ctx, char *constantData, ExternFuncInfo *fu
 		Print(ctx, ", ");
 		PrintConstant(ctx, argument, constant);
 		break;
+	case rviWriteBarrier:
+		PrintAddress(ctx, constantData, rC, argument, constant, VM_TYPE_VOID);
+		break;
 	case rviFuncAddr:
 	case rviTypeid:
 		PrintRegister(ctx, rA);
@@ -0,0 +1,1133 @@
+#include "JitDebugInfo.h"
+
+#include "Array.h"
+#include "Bytecode.h"
+#include "Linker.h"
+#include "StrAlgo.h"
+
+#if defined(__linux)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	struct JitLineInfo
+	{
+		unsigned char *address;
+
+		const char *fileName;
+		unsigned fileNameLength;
+
+		unsigned line;
+	};
+
+	// Number of line breaks in linker source before the offset
+	unsigned GetLineBreakCount(FastVector<unsigned> &lineBreaks, unsigned offset)
+	{
+		unsigned lowerBound = 0;
+		unsigned upperBound = lineBreaks.size();
+
+		while(lowerBound < upperBound)
+		{
+			unsigned pivot = (lowerBound + upperBound) / 2;
+
+			if(lineBreaks[pivot] < offset)
+				lowerBound = pivot + 1;
+			else
+				upperBound = pivot;
+		}
+
+		return lowerBound;
+	}
+
+	void CollectLineBreaks(Linker *linker, FastVector<unsigned> &lineBreaks)
+	{
+		lineBreaks.clear();
+
+		for(unsigned i = 0; i < linker->exSource.size(); i++)
+		{
+			if(linker->exSource[i] == '\n')
+				lineBreaks.push_back(i);
+		}
+	}
+
+	void GetSourceLocation(Linker *linker, FastVector<unsigned> &lineBreaks, unsigned sourceOffset, JitLineInfo &info)
+	{
+		// Main module source is placed after the modules it imports
+		unsigned moduleStart = 0;
+
+		info.fileName = NULL;
+		info.fileNameLength = 0;
+
+		for(unsigned i = 0; i < linker->exModules.size(); i++)
+		{
+			ExternModuleInfo &moduleInfo = linker->exModules[i];
+
+			unsigned moduleEnd = moduleInfo.sourceOffset + moduleInfo.sourceSize;
+
+			if(sourceOffset >= moduleInfo.sourceOffset && sourceOffset < moduleEnd)
+			{
+				moduleStart = moduleInfo.sourceOffset;
+
+				info.fileName = linker->exSymbols.data + moduleInfo.nameOffset;
+				info.fileNameLength = unsigned(strlen(info.fileName));
+				break;
+			}
+
+			if(moduleEnd <= sourceOffset && moduleEnd > moduleStart)
+				moduleStart = moduleEnd;
+		}
+
+		if(!info.fileName)
+		{
+			if(!linker->exMainModuleName.empty())
+			{
+				info.fileName = linker->exMainModuleName.data;
+				info.fileNameLength = linker->exMainModuleName.size();
+			}
+			else
+			{
+				info.fileName = "main.nc";
+				info.fileNameLength = unsigned(strlen(info.fileName));
+			}
+		}
+
+		info.line = GetLineBreakCount(lineBreaks, sourceOffset) - GetLineBreakCount(lineBreaks, moduleStart) + 1;
+	}
+
+	void CollectLineInfo(Linker *linker, unsigned char **instAddress, FastVector<unsigned> &lineBreaks, JitCodeSymbol &symbol, FastVector<JitLineInfo> &result)
+	{
+		result.clear();
+
+		FastVector<ExternSourceInfo> &sourceInfo = linker->exRegVmSourceInfo;
+
+		if(sourceInfo.empty())
+			return;
+
+		// Find source location that covers the start of the range
+		unsigned lowerBound = 0;
+		unsigned upperBound = sourceInfo.size();
+
+		while(lowerBound + 1 < upperBound)
+		{
+			unsigned pivot = (lowerBound + upperBound) / 2;
+
+			if(sourceInfo[pivot].instruction <= symbol.instStart)
+				lowerBound = pivot;
+			else
+				upperBound = pivot;
+		}
+
+		for(unsigned i = lowerBound; i < sourceInfo.size() && sourceInfo[i].instruction < symbol.instEnd; i++)
+		{
+			unsigned instruction = sourceInfo[i].instruction < symbol.instStart ? symbol.instStart : sourceInfo[i].instruction;
+
+			unsigned char *address = instAddress[instruction];
+
+			if(!address || address < symbol.codeStart || address >= symbol.codeEnd)
+				continue;
+
+			JitLineInfo info;
+
+			info.address = address;
+
+			GetSourceLocation(linker, lineBreaks, sourceInfo[i].sourceOffset, info);
+
+			if(!result.empty())
+			{
+				JitLineInfo &last = result.back();
+
+				// Instructions without generated code share the address with the next one
+				if(last.address == info.address)
+				{
+					last = info;
+					continue;
+				}
+
+				if(last.line == info.line && last.fileName == info.fileName)
+					continue;
+			}
+
+			result.push_back(info);
+		}
+	}
+}
+
+#if defined(__linux)
+
+namespace
+{
+	const unsigned jitDumpMagic = 0x4A695444; // 'JiTD'
+	const unsigned jitDumpVersion = 1;
+
+	const unsigned jitDumpCodeLoad = 0;
+	const unsigned jitDumpCodeDebugInfo = 2;
+
+	struct JitDumpFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t totalSize;
+		uint32_t elfMachine;
+		uint32_t padding;
+		uint32_t pid;
+		uint64_t timestamp;
+		uint64_t flags;
+	};
+
+	struct JitDumpRecordHeader
+	{
+		uint32_t id;
+		uint32_t totalSize;
+		uint64_t timestamp;
+	};
+
+	struct JitDumpCodeLoadRecord
+	{
+		JitDumpRecordHeader header;
+
+		uint32_t pid;
+		uint32_t tid;
+		uint64_t vma;
+		uint64_t codeAddress;
+		uint64_t codeSize;
+		uint64_t codeIndex;
+	};
+
+	struct JitDumpDebugInfoRecord
+	{
+		JitDumpRecordHeader header;
+
+		uint64_t codeAddress;
+		uint64_t entryCount;
+	};
+
+	struct JitDumpDebugEntry
+	{
+		uint64_t address;
+		uint32_t line;
+		uint32_t discriminator;
+	};
+
+	bool perfMapEnabled = false;
+	bool jitDumpEnabled = false;
+
+	FILE *perfMapFile = NULL;
+
+	int jitDumpFile = -1;
+	void *jitDumpMarker = NULL;
+	uint64_t jitDumpCodeIndex = 0;
+
+	FastVector<char> jitDumpBuffer;
+
+	FastVector<unsigned> sourceLineBreaks;
+	FastVector<JitLineInfo> symbolLineInfo;
+
+	uint64_t GetJitDumpTimestamp()
+	{
+		// Has to match the 'perf record -k mono' clock
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+	}
+
+	bool OpenJitDump()
+	{
+		char fileName[64];
+		NULLC::SafeSprintf(fileName, 64, "/tmp/jit-%d.dump", int(getpid()));
+
+		jitDumpFile = open(fileName, O_CREAT | O_TRUNC | O_RDWR, 0666);
+
+		if(jitDumpFile == -1)
+			return false;
+
+		JitDumpFileHeader header;
+
+		header.magic = jitDumpMagic;
+		header.version = jitDumpVersion;
+		header.totalSize = sizeof(header);
+#if defined(_M_X64)
+		header.elfMachine = 62; // EM_X86_64
+#else
+		header.elfMachine = 3; // EM_386
+#endif
+		header.padding = 0;
+		header.pid = uint32_t(getpid());
+		header.timestamp = GetJitDumpTimestamp();
+		header.flags = 0;
+
+		if(write(jitDumpFile, &header, sizeof(header)) != sizeof(header))
+		{
+			close(jitDumpFile);
+			jitDumpFile = -1;
+			return false;
+		}
+
+		// perf finds the dump file through an executable mapping of it
+		jitDumpMarker = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, jitDumpFile, 0);
+
+		if(jitDumpMarker == MAP_FAILED)
+			jitDumpMarker = NULL;
+
+		return true;
+	}
+
+	void WriteJitDumpRecords(Linker *linker, unsigned char **instAddress, JitCodeSymbol &symbol)
+	{
+		uint64_t timestamp = GetJitDumpTimestamp();
+
+		CollectLineInfo(linker, instAddress, sourceLineBreaks, symbol, symbolLineInfo);
+
+		jitDumpBuffer.clear();
+
+		// Debug info has to precede the code load record
+		if(!symbolLineInfo.empty())
+		{
+			JitDumpDebugInfoRecord record;
+
+			record.header.id = jitDumpCodeDebugInfo;
+			record.header.totalSize = 0;
+			record.header.timestamp = timestamp;
+
+			record.codeAddress = uint64_t(uintptr_t(symbol.codeStart));
+			record.entryCount = symbolLineInfo.size();
+
+			jitDumpBuffer.push_back((char*)&record, sizeof(record));
+
+			for(unsigned i = 0; i < symbolLineInfo.size(); i++)
+			{
+				JitLineInfo &info = symbolLineInfo[i];
+
+				JitDumpDebugEntry entry;
+
+				entry.address = uint64_t(uintptr_t(info.address));
+				entry.line = info.line;
+				entry.discriminator = 0;
+
+				jitDumpBuffer.push_back((char*)&entry, sizeof(entry));
+				jitDumpBuffer.push_back(info.fileName, info.fileNameLength);
+				jitDumpBuffer.push_back(0);
+			}
+
+			((JitDumpDebugInfoRecord*)jitDumpBuffer.data)->header.totalSize = jitDumpBuffer.size();
+		}
+
+		unsigned codeLoadStart = jitDumpBuffer.size();
+
+		JitDumpCodeLoadRecord record;
+
+		record.header.id = jitDumpCodeLoad;
+		record.header.totalSize = 0;
+		record.header.timestamp = timestamp;
+
+		record.pid = uint32_t(getpid());
+		record.tid = uint32_t(syscall(SYS_gettid));
+		record.vma = uint64_t(uintptr_t(symbol.codeStart));
+		record.codeAddress = uint64_t(uintptr_t(symbol.codeStart));
+		record.codeSize = uint64_t(symbol.codeEnd - symbol.codeStart);
+		record.codeIndex = jitDumpCodeIndex++;
+
+		jitDumpBuffer.push_back((char*)&record, sizeof(record));
+		jitDumpBuffer.push_back(symbol.name, unsigned(strlen(symbol.name)) + 1);
+		jitDumpBuffer.push_back((char*)symbol.codeStart, unsigned(symbol.codeEnd - symbol.codeStart));
+
+		((JitDumpCodeLoadRecord*)(jitDumpBuffer.data + codeLoadStart))->header.totalSize = jitDumpBuffer.size() - codeLoadStart;
+
+		if(write(jitDumpFile, jitDumpBuffer.data, jitDumpBuffer.size()) != int(jitDumpBuffer.size()))
+			assert(!"failed to write jitdump record");
+	}
+}
+
+void NULLC::JitPerfSetEnabled(bool perfMap, bool jitDump)
+{
+	perfMapEnabled = perfMap;
+	jitDumpEnabled = jitDump;
+}
+
+bool NULLC::JitPerfIsEnabled()
+{
+	return perfMapEnabled || jitDumpEnabled;
+}
+
+void NULLC::JitPerfRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count)
+{
+	if(perfMapEnabled)
+	{
+		if(!perfMapFile)
+		{
+			char fileName[64];
+			NULLC::SafeSprintf(fileName, 64, "/tmp/perf-%d.map", int(getpid()));
+
+			perfMapFile = fopen(fileName, "a");
+		}
+
+		if(perfMapFile)
+		{
+			// Entries for relocated code simply follow the old ones, perf uses the latest mapping for an address
+			for(unsigned i = 0; i < count; i++)
+				fprintf(perfMapFile, "%llx %x %s\n", (unsigned long long)uintptr_t(symbols[i].codeStart), unsigned(symbols[i].codeEnd - symbols[i].codeStart), symbols[i].name);
+
+			fflush(perfMapFile);
+		}
+	}
+
+	if(jitDumpEnabled)
+	{
+		if(jitDumpFile == -1 && !OpenJitDump())
+			return;
+
+		CollectLineBreaks(linker, sourceLineBreaks);
+
+		for(unsigned i = 0; i < count; i++)
+			WriteJitDumpRecords(linker, instAddress, symbols[i]);
+	}
+}
+
+void NULLC::JitPerfTerminate()
+{
+	if(perfMapFile)
+		fclose(perfMapFile);
+	perfMapFile = NULL;
+
+	if(jitDumpMarker)
+		munmap(jitDumpMarker, sysconf(_SC_PAGESIZE));
+	jitDumpMarker = NULL;
+
+	if(jitDumpFile != -1)
+		close(jitDumpFile);
+	jitDumpFile = -1;
+
+	jitDumpCodeIndex = 0;
+
+	jitDumpBuffer.reset();
+
+	sourceLineBreaks.reset();
+	symbolLineInfo.reset();
+}
+
+#else
+
+void NULLC::JitPerfSetEnabled(bool perfMap, bool jitDump)
+{
+	(void)perfMap;
+	(void)jitDump;
+}
+
+bool NULLC::JitPerfIsEnabled()
+{
+	return false;
+}
+
+void NULLC::JitPerfRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count)
+{
+	(void)linker;
+	(void)instAddress;
+	(void)symbols;
+	(void)count;
+}
+
+void NULLC::JitPerfTerminate()
+{
+}
+
+#endif
+
+#if defined(__linux) && defined(_M_X64) && !defined(NULLC_LLVM_SUPPORT)
+
+// GDB JIT interface, names and layout are defined by the debugger (LLVM provides its own definitions, so this is disabled together with LLVM support)
+extern "C"
+{
+	enum JitActions
+	{
+		JIT_NOACTION = 0,
+		JIT_REGISTER_FN,
+		JIT_UNREGISTER_FN
+	};
+
+	struct jit_code_entry
+	{
+		jit_code_entry *next_entry;
+		jit_code_entry *prev_entry;
+		const char *symfile_addr;
+		uint64_t symfile_size;
+	};
+
+	struct jit_descriptor
+	{
+		uint32_t version;
+		uint32_t action_flag;
+		jit_code_entry *relevant_entry;
+		jit_code_entry *first_entry;
+	};
+
+	NULLC_DEBUG_EXPORT void __attribute__((noinline)) __jit_debug_register_code()
+	{
+		// Debugger puts a breakpoint here
+		__asm__ __volatile__("");
+	}
+
+	NULLC_DEBUG_EXPORT jit_descriptor __jit_debug_descriptor = { 1, JIT_NOACTION, NULL, NULL };
+}
+
+namespace
+{
+	bool gdbInterfaceEnabled = false;
+
+	FastVector<jit_code_entry*> gdbCodeEntries;
+
+	FastVector<unsigned> gdbSourceLineBreaks;
+	FastVector<JitLineInfo> gdbSymbolLineInfo;
+
+	// ELF and DWARF constants
+	const unsigned char ELFCLASS64 = 2;
+	const unsigned char ELFDATA2LSB = 1;
+	const unsigned short ET_REL = 1;
+	const unsigned short EM_X86_64 = 62;
+
+	const unsigned SHT_PROGBITS = 1;
+	const unsigned SHT_SYMTAB = 2;
+	const unsigned SHT_STRTAB = 3;
+	const unsigned SHT_NOBITS = 8;
+
+	const unsigned SHF_ALLOC = 2;
+	const unsigned SHF_EXECINSTR = 4;
+
+	const unsigned char STT_FUNC = 2;
+	const unsigned char STB_GLOBAL = 1;
+
+	const unsigned DW_TAG_compile_unit = 0x11;
+	const unsigned DW_TAG_subprogram = 0x2e;
+
+	const unsigned DW_AT_name = 0x03;
+	const unsigned DW_AT_stmt_list = 0x10;
+	const unsigned DW_AT_low_pc = 0x11;
+	const unsigned DW_AT_high_pc = 0x12;
+
+	const unsigned DW_FORM_addr = 0x01;
+	const unsigned DW_FORM_data4 = 0x06;
+	const unsigned DW_FORM_string = 0x08;
+
+	const unsigned char DW_LNS_copy = 1;
+	const unsigned char DW_LNS_advance_pc = 2;
+	const unsigned char DW_LNS_advance_line = 3;
+	const unsigned char DW_LNS_set_file = 4;
+	const unsigned char DW_LNE_end_sequence = 1;
+	const unsigned char DW_LNE_set_address = 2;
+
+	const unsigned char DW_CFA_advance_loc = 0x40;
+	const unsigned char DW_CFA_offset = 0x80;
+	const unsigned char DW_CFA_def_cfa = 0x0c;
+	const unsigned char DW_CFA_def_cfa_offset = 0x0e;
+
+	const unsigned char DWARF_REG_RBX = 3;
+	const unsigned char DWARF_REG_RSP = 7;
+	const unsigned char DWARF_REG_R15 = 15;
+	const unsigned char DWARF_REG_RA = 16;
+
+	struct ElfHeader
+	{
+		unsigned char ident[16];
+		uint16_t type;
+		uint16_t machine;
+		uint32_t version;
+		uint64_t entry;
+		uint64_t phoff;
+		uint64_t shoff;
+		uint32_t flags;
+		uint16_t ehsize;
+		uint16_t phentsize;
+		uint16_t phnum;
+		uint16_t shentsize;
+		uint16_t shnum;
+		uint16_t shstrndx;
+	};
+
+	struct ElfSectionHeader
+	{
+		uint32_t name;
+		uint32_t type;
+		uint64_t flags;
+		uint64_t addr;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t link;
+		uint32_t info;
+		uint64_t addralign;
+		uint64_t entsize;
+	};
+
+	struct ElfSymbol
+	{
+		uint32_t name;
+		unsigned char info;
+		unsigned char other;
+		uint16_t shndx;
+		uint64_t value;
+		uint64_t size;
+	};
+
+	enum ElfSection
+	{
+		ELF_SECTION_NULL,
+		ELF_SECTION_TEXT,
+		ELF_SECTION_SYMTAB,
+		ELF_SECTION_STRTAB,
+		ELF_SECTION_DEBUG_INFO,
+		ELF_SECTION_DEBUG_ABBREV,
+		ELF_SECTION_DEBUG_LINE,
+		ELF_SECTION_DEBUG_FRAME,
+		ELF_SECTION_SHSTRTAB,
+
+		ELF_SECTION_COUNT
+	};
+
+	template<typename T>
+	void WriteValue(FastVector<char> &buf, T value)
+	{
+		buf.push_back((char*)&value, sizeof(value));
+	}
+
+	template<typename T>
+	void PatchValue(FastVector<char> &buf, unsigned offset, T value)
+	{
+		memcpy(buf.data + offset, &value, sizeof(value));
+	}
+
+	void WriteString(FastVector<char> &buf, const char *str, unsigned length)
+	{
+		buf.push_back(str, length);
+		buf.push_back(0);
+	}
+
+	void WriteString(FastVector<char> &buf, const char *str)
+	{
+		WriteString(buf, str, unsigned(strlen(str)));
+	}
+
+	void WriteULEB128(FastVector<char> &buf, uint64_t value)
+	{
+		do
+		{
+			unsigned char byte = value & 0x7f;
+
+			value >>= 7;
+
+			if(value)
+				byte |= 0x80;
+
+			buf.push_back(char(byte));
+		}
+		while(value);
+	}
+
+	void WriteSLEB128(FastVector<char> &buf, int64_t value)
+	{
+		bool more = true;
+
+		while(more)
+		{
+			unsigned char byte = value & 0x7f;
+
+			value >>= 7;
+
+			if((value == 0 && (byte & 0x40) == 0) || (value == -1 && (byte & 0x40) != 0))
+				more = false;
+			else
+				byte |= 0x80;
+
+			buf.push_back(char(byte));
+		}
+	}
+
+	void AlignBuffer(FastVector<char> &buf, unsigned alignment, char filler)
+	{
+		while(buf.size() % alignment != 0)
+			buf.push_back(filler);
+	}
+
+	unsigned GetFileIndex(FastVector<JitLineInfo> &files, JitLineInfo &info)
+	{
+		for(unsigned i = 0; i < files.size(); i++)
+		{
+			if(files[i].fileNameLength == info.fileNameLength && memcmp(files[i].fileName, info.fileName, info.fileNameLength) == 0)
+				return i + 1;
+		}
+
+		files.push_back(info);
+
+		return files.size();
+	}
+
+	void WriteDebugLine(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count, FastVector<char> &debugLine)
+	{
+		FastVector<JitLineInfo> files;
+
+		// Line programs are collected first to fill the file table
+		FastVector<char> program;
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			JitCodeSymbol &symbol = symbols[i];
+
+			CollectLineInfo(linker, instAddress, gdbSourceLineBreaks, symbol, gdbSymbolLineInfo);
+
+			program.push_back(0);
+			WriteULEB128(program, 1 + sizeof(uint64_t));
+			program.push_back(DW_LNE_set_address);
+			WriteValue(program, uint64_t(uintptr_t(symbol.codeStart)));
+
+			unsigned char *address = symbol.codeStart;
+			unsigned line = 1;
+			unsigned file = 1;
+
+			for(unsigned k = 0; k < gdbSymbolLineInfo.size(); k++)
+			{
+				JitLineInfo &info = gdbSymbolLineInfo[k];
+
+				unsigned fileIndex = GetFileIndex(files, info);
+
+				if(fileIndex != file)
+				{
+					program.push_back(DW_LNS_set_file);
+					WriteULEB128(program, fileIndex);
+					file = fileIndex;
+				}
+
+				if(info.address != address)
+				{
+					program.push_back(DW_LNS_advance_pc);
+					WriteULEB128(program, uint64_t(info.address - address));
+					address = info.address;
+				}
+
+				if(info.line != line)
+				{
+					program.push_back(DW_LNS_advance_line);
+					WriteSLEB128(program, int64_t(info.line) - int64_t(line));
+					line = info.line;
+				}
+
+				program.push_back(DW_LNS_copy);
+			}
+
+			program.push_back(DW_LNS_advance_pc);
+			WriteULEB128(program, uint64_t(symbol.codeEnd - address));
+
+			program.push_back(0);
+			WriteULEB128(program, 1);
+			program.push_back(DW_LNE_end_sequence);
+		}
+
+		unsigned unitStart = debugLine.size();
+
+		WriteValue(debugLine, uint32_t(0)); // unit_length
+		WriteValue(debugLine, uint16_t(2)); // version
+
+		unsigned headerLengthPos = debugLine.size();
+		WriteValue(debugLine, uint32_t(0)); // header_length
+
+		unsigned headerStart = debugLine.size();
+
+		debugLine.push_back(1); // minimum_instruction_length
+		debugLine.push_back(1); // default_is_stmt
+		debugLine.push_back(char(-5)); // line_base
+		debugLine.push_back(14); // line_range
+		debugLine.push_back(13); // opcode_base
+
+		static const char standardOpcodeLengths[12] = { 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1 };
+		debugLine.push_back(standardOpcodeLengths, 12);
+
+		// No include directories
+		debugLine.push_back(0);
+
+		for(unsigned i = 0; i < files.size(); i++)
+		{
+			WriteString(debugLine, files[i].fileName, files[i].fileNameLength);
+			WriteULEB128(debugLine, 0); // Directory
+			WriteULEB128(debugLine, 0); // Modification time
+			WriteULEB128(debugLine, 0); // File size
+		}
+
+		debugLine.push_back(0);
+
+		PatchValue(debugLine, headerLengthPos, uint32_t(debugLine.size() - headerStart));
+
+		debugLine.push_back(program.data, program.size());
+
+		PatchValue(debugLine, unitStart, uint32_t(debugLine.size() - unitStart - sizeof(uint32_t)));
+	}
+
+	void WriteDebugInfo(JitCodeSymbol *symbols, unsigned count, unsigned char *codeStart, unsigned char *codeEnd, FastVector<char> &debugInfo, FastVector<char> &debugAbbrev)
+	{
+		// Compile unit
+		WriteULEB128(debugAbbrev, 1);
+		WriteULEB128(debugAbbrev, DW_TAG_compile_unit);
+		debugAbbrev.push_back(1); // Has children
+		WriteULEB128(debugAbbrev, DW_AT_name);
+		WriteULEB128(debugAbbrev, DW_FORM_string);
+		WriteULEB128(debugAbbrev, DW_AT_low_pc);
+		WriteULEB128(debugAbbrev, DW_FORM_addr);
+		WriteULEB128(debugAbbrev, DW_AT_high_pc);
+		WriteULEB128(debugAbbrev, DW_FORM_addr);
+		WriteULEB128(debugAbbrev, DW_AT_stmt_list);
+		WriteULEB128(debugAbbrev, DW_FORM_data4);
+		WriteULEB128(debugAbbrev, 0);
+		WriteULEB128(debugAbbrev, 0);
+
+		// Function
+		WriteULEB128(debugAbbrev, 2);
+		WriteULEB128(debugAbbrev, DW_TAG_subprogram);
+		debugAbbrev.push_back(0); // No children
+		WriteULEB128(debugAbbrev, DW_AT_name);
+		WriteULEB128(debugAbbrev, DW_FORM_string);
+		WriteULEB128(debugAbbrev, DW_AT_low_pc);
+		WriteULEB128(debugAbbrev, DW_FORM_addr);
+		WriteULEB128(debugAbbrev, DW_AT_high_pc);
+		WriteULEB128(debugAbbrev, DW_FORM_addr);
+		WriteULEB128(debugAbbrev, 0);
+		WriteULEB128(debugAbbrev, 0);
+
+		WriteULEB128(debugAbbrev, 0);
+
+		WriteValue(debugInfo, uint32_t(0)); // unit_length
+		WriteValue(debugInfo, uint16_t(2)); // version
+		WriteValue(debugInfo, uint32_t(0)); // debug_abbrev_offset
+		debugInfo.push_back(sizeof(uint64_t)); // address_size
+
+		WriteULEB128(debugInfo, 1);
+		WriteString(debugInfo, "nullc");
+		WriteValue(debugInfo, uint64_t(uintptr_t(codeStart)));
+		WriteValue(debugInfo, uint64_t(uintptr_t(codeEnd)));
+		WriteValue(debugInfo, uint32_t(0)); // stmt_list
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			WriteULEB128(debugInfo, 2);
+			WriteString(debugInfo, symbols[i].name);
+			WriteValue(debugInfo, uint64_t(uintptr_t(symbols[i].codeStart)));
+			WriteValue(debugInfo, uint64_t(uintptr_t(symbols[i].codeEnd)));
+		}
+
+		WriteULEB128(debugInfo, 0);
+
+		PatchValue(debugInfo, 0, uint32_t(debugInfo.size() - sizeof(uint32_t)));
+	}
+
+	void WriteDebugFrame(JitCodeSymbol *symbols, unsigned count, FastVector<char> &debugFrame)
+	{
+		// Common information entry
+		WriteValue(debugFrame, uint32_t(0)); // length
+		WriteValue(debugFrame, uint32_t(0xffffffff)); // CIE_id
+		debugFrame.push_back(1); // version
+		debugFrame.push_back(0); // augmentation
+		WriteULEB128(debugFrame, 1); // code_alignment_factor
+		WriteSLEB128(debugFrame, -8); // data_alignment_factor
+		debugFrame.push_back(DWARF_REG_RA); // return_address_register
+
+		// Return address is at the stack top on entry
+		debugFrame.push_back(DW_CFA_def_cfa);
+		WriteULEB128(debugFrame, DWARF_REG_RSP);
+		WriteULEB128(debugFrame, 8);
+		debugFrame.push_back(DW_CFA_offset | DWARF_REG_RA);
+		WriteULEB128(debugFrame, 1);
+
+		AlignBuffer(debugFrame, sizeof(uint64_t), 0);
+
+		PatchValue(debugFrame, 0, uint32_t(debugFrame.size() - sizeof(uint32_t)));
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			unsigned entryStart = debugFrame.size();
+
+			WriteValue(debugFrame, uint32_t(0)); // length
+			WriteValue(debugFrame, uint32_t(0)); // CIE_pointer
+			WriteValue(debugFrame, uint64_t(uintptr_t(symbols[i].codeStart)));
+			WriteValue(debugFrame, uint64_t(symbols[i].codeEnd - symbols[i].codeStart));
+
+			// Every function and global code block starts with 'push rbx; push r15; sub rsp, 40'
+			debugFrame.push_back(DW_CFA_advance_loc | 1);
+			debugFrame.push_back(DW_CFA_def_cfa_offset);
+			WriteULEB128(debugFrame, 16);
+			debugFrame.push_back(DW_CFA_offset | DWARF_REG_RBX);
+			WriteULEB128(debugFrame, 2);
+
+			debugFrame.push_back(DW_CFA_advance_loc | 2);
+			debugFrame.push_back(DW_CFA_def_cfa_offset);
+			WriteULEB128(debugFrame, 24);
+			debugFrame.push_back(DW_CFA_offset | DWARF_REG_R15);
+			WriteULEB128(debugFrame, 3);
+
+			debugFrame.push_back(DW_CFA_advance_loc | 4);
+			debugFrame.push_back(DW_CFA_def_cfa_offset);
+			WriteULEB128(debugFrame, 64);
+
+			AlignBuffer(debugFrame, sizeof(uint64_t), 0);
+
+			PatchValue(debugFrame, entryStart, uint32_t(debugFrame.size() - entryStart - sizeof(uint32_t)));
+		}
+	}
+
+	jit_code_entry* CreateSymbolFile(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count)
+	{
+		unsigned char *codeStart = symbols[0].codeStart;
+		unsigned char *codeEnd = symbols[0].codeEnd;
+
+		for(unsigned i = 1; i < count; i++)
+		{
+			if(symbols[i].codeStart < codeStart)
+				codeStart = symbols[i].codeStart;
+
+			if(symbols[i].codeEnd > codeEnd)
+				codeEnd = symbols[i].codeEnd;
+		}
+
+		FastVector<char> sections[ELF_SECTION_COUNT];
+
+		// Symbols
+		FastVector<char> &symtab = sections[ELF_SECTION_SYMTAB];
+		FastVector<char> &strtab = sections[ELF_SECTION_STRTAB];
+
+		ElfSymbol nullSymbol;
+		memset(&nullSymbol, 0, sizeof(nullSymbol));
+		WriteValue(symtab, nullSymbol);
+
+		strtab.push_back(0);
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			ElfSymbol symbol;
+
+			symbol.name = strtab.size();
+			symbol.info = (STB_GLOBAL << 4) | STT_FUNC;
+			symbol.other = 0;
+			symbol.shndx = ELF_SECTION_TEXT;
+			symbol.value = uint64_t(uintptr_t(symbols[i].codeStart));
+			symbol.size = uint64_t(symbols[i].codeEnd - symbols[i].codeStart);
+
+			WriteValue(symtab, symbol);
+
+			WriteString(strtab, symbols[i].name);
+		}
+
+		CollectLineBreaks(linker, gdbSourceLineBreaks);
+
+		WriteDebugLine(linker, instAddress, symbols, count, sections[ELF_SECTION_DEBUG_LINE]);
+		WriteDebugInfo(symbols, count, codeStart, codeEnd, sections[ELF_SECTION_DEBUG_INFO], sections[ELF_SECTION_DEBUG_ABBREV]);
+		WriteDebugFrame(symbols, count, sections[ELF_SECTION_DEBUG_FRAME]);
+
+		// Section names
+		FastVector<char> &shstrtab = sections[ELF_SECTION_SHSTRTAB];
+
+		static const char* sectionNames[ELF_SECTION_COUNT] = { "", ".text", ".symtab", ".strtab", ".debug_info", ".debug_abbrev", ".debug_line", ".debug_frame", ".shstrtab" };
+
+		unsigned sectionNameOffsets[ELF_SECTION_COUNT];
+
+		for(unsigned i = 0; i < ELF_SECTION_COUNT; i++)
+		{
+			sectionNameOffsets[i] = shstrtab.size();
+
+			WriteString(shstrtab, sectionNames[i]);
+		}
+
+		// Layout: header, section data, section headers
+		FastVector<char> file;
+
+		ElfHeader header;
+		memset(&header, 0, sizeof(header));
+		WriteValue(file, header);
+
+		unsigned sectionOffsets[ELF_SECTION_COUNT];
+
+		for(unsigned i = 0; i < ELF_SECTION_COUNT; i++)
+		{
+			AlignBuffer(file, sizeof(uint64_t), 0);
+
+			sectionOffsets[i] = file.size();
+
+			if(!sections[i].empty())
+				file.push_back(sections[i].data, sections[i].size());
+		}
+
+		AlignBuffer(file, sizeof(uint64_t), 0);
+
+		unsigned sectionHeadersOffset = file.size();
+
+		for(unsigned i = 0; i < ELF_SECTION_COUNT; i++)
+		{
+			ElfSectionHeader section;
+			memset(&section, 0, sizeof(section));
+
+			section.name = i == ELF_SECTION_NULL ? 0 : sectionNameOffsets[i];
+			section.offset = i == ELF_SECTION_NULL ? 0 : sectionOffsets[i];
+			section.size = sections[i].size();
+			section.addralign = 1;
+
+			switch(i)
+			{
+			case ELF_SECTION_NULL:
+				section.addralign = 0;
+				break;
+			case ELF_SECTION_TEXT:
+				// Code is not a part of the file, section only provides the address range
+				section.type = SHT_NOBITS;
+				section.flags = SHF_ALLOC | SHF_EXECINSTR;
+				section.addr = uint64_t(uintptr_t(codeStart));
+				section.size = uint64_t(codeEnd - codeStart);
+				section.addralign = 16;
+				break;
+			case ELF_SECTION_SYMTAB:
+				section.type = SHT_SYMTAB;
+				section.link = ELF_SECTION_STRTAB;
+				section.info = 1; // First global symbol
+				section.addralign = 8;
+				section.entsize = sizeof(ElfSymbol);
+				break;
+			case ELF_SECTION_STRTAB:
+			case ELF_SECTION_SHSTRTAB:
+				section.type = SHT_STRTAB;
+				break;
+			default:
+				section.type = SHT_PROGBITS;
+				break;
+			}
+
+			WriteValue(file, section);
+		}
+
+		ElfHeader &fileHeader = *(ElfHeader*)file.data;
+
+		fileHeader.ident[0] = 0x7f;
+		fileHeader.ident[1] = 'E';
+		fileHeader.ident[2] = 'L';
+		fileHeader.ident[3] = 'F';
+		fileHeader.ident[4] = ELFCLASS64;
+		fileHeader.ident[5] = ELFDATA2LSB;
+		fileHeader.ident[6] = 1; // EV_CURRENT
+
+		fileHeader.type = ET_REL;
+		fileHeader.machine = EM_X86_64;
+		fileHeader.version = 1;
+		fileHeader.shoff = sectionHeadersOffset;
+		fileHeader.ehsize = sizeof(ElfHeader);
+		fileHeader.shentsize = sizeof(ElfSectionHeader);
+		fileHeader.shnum = ELF_SECTION_COUNT;
+		fileHeader.shstrndx = ELF_SECTION_SHSTRTAB;
+
+		char *symfile = (char*)NULLC::alloc(file.size());
+		memcpy(symfile, file.data, file.size());
+
+		jit_code_entry *entry = (jit_code_entry*)NULLC::alloc(sizeof(jit_code_entry));
+
+		entry->next_entry = NULL;
+		entry->prev_entry = NULL;
+		entry->symfile_addr = symfile;
+		entry->symfile_size = file.size();
+
+		return entry;
+	}
+}
+
+void NULLC::JitGdbSetEnabled(bool enable)
+{
+	gdbInterfaceEnabled = enable;
+}
+
+bool NULLC::JitGdbIsEnabled()
+{
+	return gdbInterfaceEnabled;
+}
+
+void NULLC::JitGdbRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count)
+{
+	if(!gdbInterfaceEnabled || count == 0)
+		return;
+
+	jit_code_entry *entry = CreateSymbolFile(linker, instAddress, symbols, count);
+
+	entry->next_entry = __jit_debug_descriptor.first_entry;
+
+	if(entry->next_entry)
+		entry->next_entry->prev_entry = entry;
+
+	__jit_debug_descriptor.first_entry = entry;
+	__jit_debug_descriptor.relevant_entry = entry;
+	__jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+
+	__jit_debug_register_code();
+
+	gdbCodeEntries.push_back(entry);
+}
+
+void NULLC::JitGdbUnregisterCode()
+{
+	for(unsigned i = 0; i < gdbCodeEntries.size(); i++)
+	{
+		jit_code_entry *entry = gdbCodeEntries[i];
+
+		if(entry->prev_entry)
+			entry->prev_entry->next_entry = entry->next_entry;
+		else
+			__jit_debug_descriptor.first_entry = entry->next_entry;
+
+		if(entry->next_entry)
+			entry->next_entry->prev_entry = entry->prev_entry;
+
+		__jit_debug_descriptor.relevant_entry = entry;
+		__jit_debug_descriptor.action_flag = JIT_UNREGISTER_FN;
+
+		__jit_debug_register_code();
+
+		NULLC::dealloc((void*)entry->symfile_addr);
+		NULLC::dealloc(entry);
+	}
+
+	gdbCodeEntries.clear();
+
+	__jit_debug_descriptor.relevant_entry = NULL;
+	__jit_debug_descriptor.action_flag = JIT_NOACTION;
+}
+
+void NULLC::JitGdbTerminate()
+{
+	JitGdbUnregisterCode();
+
+	gdbCodeEntries.reset();
+
+	gdbSourceLineBreaks.reset();
+	gdbSymbolLineInfo.reset();
+}
+
+#else
+
+void NULLC::JitGdbSetEnabled(bool enable)
+{
+	(void)enable;
+}
+
+bool NULLC::JitGdbIsEnabled()
+{
+	return false;
+}
+
+void NULLC::JitGdbRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count)
+{
+	(void)linker;
+	(void)instAddress;
+	(void)symbols;
+	(void)count;
+}
+
+void NULLC::JitGdbUnregisterCode()
+{
+}
+
+void NULLC::JitGdbTerminate()
+{
+}
+
+#endif
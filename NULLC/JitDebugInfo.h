@@ -0,0 +1,42 @@
+#pragma once
+
+#include "stdafx.h"
+
+class Linker;
+
+// Native code range generated for a function or a block of global code
+struct JitCodeSymbol
+{
+	JitCodeSymbol(): name(NULL), codeStart(NULL), codeEnd(NULL), instStart(0), instEnd(0)
+	{
+	}
+
+	const char *name;
+
+	unsigned char *codeStart;
+	unsigned char *codeEnd;
+
+	// Range of RegVm instructions
+	unsigned instStart;
+	unsigned instEnd;
+};
+
+namespace NULLC
+{
+	// Linux perf integration: /tmp/perf-<pid>.map symbol map and /tmp/jit-<pid>.dump records for 'perf inject --jit'
+	void	JitPerfSetEnabled(bool perfMap, bool jitDump);
+	bool	JitPerfIsEnabled();
+
+	void	JitPerfRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count);
+
+	void	JitPerfTerminate();
+
+	// GDB JIT interface: in-memory ELF object with symbols, line tables and unwind information for each batch of translated code
+	void	JitGdbSetEnabled(bool enable);
+	bool	JitGdbIsEnabled();
+
+	void	JitGdbRegisterCode(Linker *linker, unsigned char **instAddress, JitCodeSymbol *symbols, unsigned count);
+	void	JitGdbUnregisterCode();
+
+	void	JitGdbTerminate();
+}
@@ -48,6 +48,11 @@ Linker::Linker(): exTypes(128), exTypeExtra(256), exTypeConstants(256), exVariab
 {
 	globalVarSize = 0;
 
+	exRootCodeHash = NULLC::GetStringHash("");
+	exRootModuleCount = 0;
+
+	keepRootCode = false;
+
 	typeMap.init();
 	funcMap.init();
 
@@ -78,6 +83,11 @@ void Linker::CleanCode()
 	exImportPaths.clear();
 	exMainModuleName.clear();
 
+	exRootCodeHash = NULLC::GetStringHash("");
+	exRootModuleCount = 0;
+
+	exRootCode.clear();
+
 	exRegVmCode.clear();
 	exRegVmSourceInfo.clear();
 	exRegVmExecCount.clear();
@@ -923,6 +933,22 @@ bool Linker::LinkCode(const char *code, const char *moduleName, bool rootModule)
 	}
 #endif
 
+	if(rootModule)
+	{
+		const char *name = moduleName ? moduleName : "";
+
+		exRootCodeHash = NULLC::StringHashContinue(exRootCodeHash, name);
+		exRootCodeHash = NULLC::StringHashContinue(exRootCodeHash, code, code + bCode->size);
+		exRootModuleCount++;
+
+		// Root modules are kept, so that the program can be linked again from a snapshot
+		if(keepRootCode)
+		{
+			exRootCode.push_back(name, unsigned(strlen(name)) + 1);
+			exRootCode.push_back(code, bCode->size);
+		}
+	}
+
 	return true;
 }
 
@@ -45,6 +45,14 @@ public:
 	FastVector<char>				exImportPaths;
 	FastVector<char>				exMainModuleName;
 
+	// Hash of the linked root modules in link order, states can only be exchanged between programs with the same hash
+	unsigned int					exRootCodeHash;
+	unsigned int					exRootModuleCount;
+
+	// Bytecode of the linked root modules in link order is kept for snapshots when 'keepRootCode' is set, each one follows its zero-terminated module name
+	bool							keepRootCode;
+	FastVector<char>				exRootCode;
+
 	FastVector<RegVmCmd>			exRegVmCode;
 	FastVector<ExternSourceInfo>	exRegVmSourceInfo;
 	FastVector<unsigned int>		exRegVmExecCount;
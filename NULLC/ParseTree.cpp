@@ -906,7 +906,10 @@ SynAlign* ParseAlign(ParseContext &ctx)
 
 		SynBase *value = NULL;
 
-		if(CheckAt(ctx, lex_number, "ERROR: alignment value not found after align("))
+		// align(auto) leaves the alignment and the member layout to the compiler
+		if(ctx.Consume(lex_auto))
+			value = new (ctx.get<SynTypeAuto>()) SynTypeAuto(ctx.Previous(), ctx.Previous());
+		else if(CheckAt(ctx, lex_number, "ERROR: alignment value not found after align("))
 			value = ParseNumber(ctx);
 		else
 			value = new (ctx.get<SynError>()) SynError(ctx.Current(), ctx.Current());
@@ -7,20 +7,27 @@
 
 #include "stdafx.h"
 #include "Pool.h"
-#include "Tree.h"
+#include "HashMap.h"
 
 #include "Executor_Common.h"
 #include "Linker.h"
 
 #include "includes/typeinfo.h"
 
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
 typedef uintptr_t markerType;
 
 // memory structure				   |base->
 // small object storage:			marker, data...
-// big object storage:		size,	marker, data...
+// big object storage:		header,	marker, data...		(header is a list link with the object size)
 // small array storage:				marker, count, data...
-// big array storage:		size,	marker, count, data...
+// big array storage:		header,	marker, count, data...
 
 namespace
 {
@@ -40,13 +47,22 @@ namespace
 namespace NULLC
 {
 	static Linker	*linker = NULL;
+
+	// Objects waiting for their finalizers are kept alive by the queue, entries before the start were already taken by a batch
 	FastVector<NULLCRef>	finalizeList;
+	unsigned	finalizeListStart = 0;
+
+	// Finalizers are called by script code for the objects of the current batch
+	FastVector<NULLCRef>	finalizeBatch;
 
 	static uintptr_t OBJECT_VISIBLE		= 1 << 0;
 	static uintptr_t OBJECT_FREED		= 1 << 1;
 	static uintptr_t OBJECT_FINALIZABLE	= 1 << 2;
 	static uintptr_t OBJECT_FINALIZED	= 1 << 3;
 	static uintptr_t OBJECT_ARRAY		= 1 << 4;
+	static uintptr_t OBJECT_REMEMBERED	= 1 << 5;
+	static uintptr_t OBJECT_PINNED		= 1 << 6;
+	static uintptr_t OBJECT_HASHED		= 1 << 7;
 	static uintptr_t OBJECT_MASK		= OBJECT_VISIBLE | OBJECT_FREED;
 
 	void FinalizeObject(markerType& marker, char* base)
@@ -73,6 +89,244 @@ namespace NULLC
 		}
 		marker |= NULLC::OBJECT_FINALIZED;
 	}
+
+	void ProfileSurvivor(markerType marker, uintptr_t size);
+}
+
+static const unsigned markWordBits = sizeof(uintptr_t) * 8;
+
+// Block pool page flags
+static const unsigned char PAGE_EVACUATING = 1 << 0;
+
+// Element sizes of the block pools in the order of the page map kinds
+static const unsigned poolSizeClasses[] = { 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768 };
+
+static unsigned CountMarkBits(uintptr_t bits)
+{
+	unsigned count = 0;
+
+	for(; bits; bits &= bits - 1)
+		count++;
+
+	return count;
+}
+
+// Map from 512 byte granules of the address space to the block pool pages and large blocks that occupy them
+// Every page and large block is bigger than a granule, so a granule is shared by at most two of them: one that covers the start of the granule and one that begins inside of it
+class HeapPageMap
+{
+public:
+	static const unsigned granuleShift = 9;
+	static const unsigned leafShift = 12;
+	static const unsigned leafSize = 1 << leafShift;
+
+	enum SpanKind
+	{
+		SPAN_POOL_8,
+		SPAN_POOL_16,
+		SPAN_POOL_32,
+		SPAN_POOL_64,
+		SPAN_POOL_128,
+		SPAN_POOL_256,
+		SPAN_POOL_512,
+		SPAN_POOL_1024,
+		SPAN_POOL_2048,
+		SPAN_POOL_4096,
+		SPAN_POOL_8192,
+		SPAN_POOL_16384,
+		SPAN_POOL_32768,
+		SPAN_BIG_BLOCK,
+		SPAN_ARENA
+	};
+
+	HeapPageMap()
+	{
+		leaves = NULL;
+		leafCount = 0;
+		leafCapacity = 0;
+	}
+
+	~HeapPageMap()
+	{
+		Reset();
+	}
+
+	void Clear()
+	{
+		for(unsigned i = 0; i < leafCapacity; i++)
+		{
+			if(leaves[i])
+				NULLC::dealloc(leaves[i]);
+
+			leaves[i] = NULL;
+		}
+
+		leafCount = 0;
+	}
+
+	void Reset()
+	{
+		Clear();
+
+		NULLC::dealloc(leaves);
+
+		leaves = NULL;
+		leafCapacity = 0;
+	}
+
+	void Insert(void *start, uintptr_t size, unsigned kind)
+	{
+		uintptr_t first = uintptr_t(start) >> granuleShift;
+		uintptr_t last = (uintptr_t(start) + size - 1) >> granuleShift;
+
+		Entry &head = GetEntry(first);
+
+		assert(!head.inner);
+
+		head.inner = (char*)start;
+		head.innerKind = (unsigned char)kind;
+
+		for(uintptr_t granule = first + 1; granule <= last; granule++)
+		{
+			Entry &entry = GetEntry(granule);
+
+			entry.cover = (char*)start;
+			entry.coverKind = (unsigned char)kind;
+		}
+	}
+
+	void Remove(void *start, uintptr_t size)
+	{
+		uintptr_t first = uintptr_t(start) >> granuleShift;
+		uintptr_t last = (uintptr_t(start) + size - 1) >> granuleShift;
+
+		GetEntry(first).inner = NULL;
+
+		for(uintptr_t granule = first + 1; granule <= last; granule++)
+			GetEntry(granule).cover = NULL;
+	}
+
+	// Returns the start of a page or a large block that might contain the pointer, caller has to check the end of the span
+	char* Find(void *ptr, unsigned &kind)
+	{
+		uintptr_t granule = uintptr_t(ptr) >> granuleShift;
+
+		Leaf *leaf = FindLeaf(granule >> leafShift);
+
+		if(!leaf)
+			return NULL;
+
+		Entry &entry = leaf->entries[granule & (leafSize - 1)];
+
+		if(entry.inner && (char*)ptr >= entry.inner)
+		{
+			kind = entry.innerKind;
+			return entry.inner;
+		}
+
+		kind = entry.coverKind;
+		return entry.cover;
+	}
+
+private:
+	struct Entry
+	{
+		char			*cover;
+		char			*inner;
+
+		unsigned char	coverKind;
+		unsigned char	innerKind;
+	};
+
+	struct Leaf
+	{
+		uintptr_t	index;
+
+		Entry		entries[leafSize];
+	};
+
+	static unsigned HashIndex(uintptr_t index)
+	{
+		return unsigned(index ^ (index >> 16 >> 16)) * 2654435761u;
+	}
+
+	Leaf* FindLeaf(uintptr_t index)
+	{
+		if(!leafCount)
+			return NULL;
+
+		for(unsigned i = HashIndex(index) & (leafCapacity - 1); leaves[i]; i = (i + 1) & (leafCapacity - 1))
+		{
+			if(leaves[i]->index == index)
+				return leaves[i];
+		}
+
+		return NULL;
+	}
+
+	Entry& GetEntry(uintptr_t granule)
+	{
+		uintptr_t index = granule >> leafShift;
+
+		Leaf *leaf = FindLeaf(index);
+
+		if(!leaf)
+		{
+			if((leafCount + 1) * 2 > leafCapacity)
+				Grow();
+
+			leaf = (Leaf*)NULLC::alloc(sizeof(Leaf));
+			memset(leaf, 0, sizeof(Leaf));
+
+			leaf->index = index;
+
+			AddLeaf(leaf);
+		}
+
+		return leaf->entries[granule & (leafSize - 1)];
+	}
+
+	void AddLeaf(Leaf *leaf)
+	{
+		unsigned i = HashIndex(leaf->index) & (leafCapacity - 1);
+
+		while(leaves[i])
+			i = (i + 1) & (leafCapacity - 1);
+
+		leaves[i] = leaf;
+		leafCount++;
+	}
+
+	void Grow()
+	{
+		Leaf **oldLeaves = leaves;
+		unsigned oldCapacity = leafCapacity;
+
+		leafCapacity = leafCapacity ? leafCapacity * 2 : 16;
+
+		leaves = (Leaf**)NULLC::alloc(sizeof(Leaf*) * leafCapacity);
+		memset(leaves, 0, sizeof(Leaf*) * leafCapacity);
+
+		leafCount = 0;
+
+		for(unsigned i = 0; i < oldCapacity; i++)
+		{
+			if(oldLeaves[i])
+				AddLeaf(oldLeaves[i]);
+		}
+
+		NULLC::dealloc(oldLeaves);
+	}
+
+	// Open addressing table of leaves indexed by the address bits above a leaf
+	Leaf		**leaves;
+	unsigned	leafCount;
+	unsigned	leafCapacity;
+};
+
+namespace NULLC
+{
+	HeapPageMap heapPages;
 }
 
 template<int elemSize>
@@ -90,9 +344,21 @@ struct LargeBlock
 	typedef SmallBlock<elemSize> Block;
 
 	// Padding is used to break the 16 byte alignment of pages in a way that after a marker offset is added to the block, the object pointer will be correctly aligned
-	char padding[16 - sizeof(markerType)];
+	// Page flags are kept in the padding, so that they are at the start of the page in every pool
+	unsigned char	flags;
+	char		padding[16 - sizeof(markerType) - 1];
+
 	Block		page[countInBlock];
 
+	// Mark bits are kept outside of the blocks, so that resetting and scanning them doesn't touch object memory
+	uintptr_t	markBits[(countInBlock + markWordBits - 1) / markWordBits];
+
+	// Free blocks of the page are collected by the sweep that runs when the page is reached by the allocator after a collection
+	Block		*freeBlocks;
+	unsigned	freeCount;
+
+	bool		hasFinalizable;
+
 	LargeBlock	*next;
 };
 #pragma pack(pop)
@@ -102,12 +368,29 @@ class ObjectBlockPool
 {
 	typedef SmallBlock<elemSize> MySmallBlock;
 	typedef LargeBlock<elemSize, countInBlock> MyLargeBlock;
+
+	struct PendingBlock
+	{
+		PendingBlock(): block(NULL)
+		{
+		}
+		PendingBlock(MySmallBlock *block, MyLargeBlock *page, unsigned index): block(block)
+		{
+			mark.word = &page->markBits[index / markWordBits];
+			mark.bit = uintptr_t(1) << (index % markWordBits);
+		}
+
+		MySmallBlock		*block;
+		NULLC::ObjectMark	mark;
+	};
 public:
 	ObjectBlockPool()
 	{
-		freeBlocks = &lastBlock;
 		activePages = NULL;
 		lastNum = countInBlock;
+
+		allocPage = NULL;
+		sweepPage = NULL;
 	}
 
 	~ObjectBlockPool()
@@ -126,22 +409,41 @@ public:
 			activePages = following;
 		}while(activePages != NULL);
 
-		freeBlocks = &lastBlock;
 		activePages = NULL;
 		lastNum = countInBlock;
 
-		sortedPages.reset();
+		allocPage = NULL;
+		sweepPage = NULL;
+
 		objectsToFinalize.reset();
-		objectsToFree.reset();
 	}
 
-	void* Alloc()
+	void* Alloc(bool finalizable)
 	{
-		MySmallBlock*	result;
-		if(freeBlocks && freeBlocks != &lastBlock)
+		// Pages that weren't swept after the last collection are swept when the free blocks of previous pages run out
+		while((!allocPage || !allocPage->freeBlocks) && sweepPage)
+		{
+			allocPage = sweepPage;
+			sweepPage = sweepPage->next;
+
+			// Objects are not placed into pages that are evacuated by the compaction
+			if(allocPage->flags & PAGE_EVACUATING)
+			{
+				allocPage = NULL;
+				continue;
+			}
+
+			Sweep(allocPage);
+		}
+
+		MyLargeBlock	*page;
+		MySmallBlock	*result;
+		if(allocPage && allocPage->freeBlocks)
 		{
-			result = freeBlocks;
-			freeBlocks = (MySmallBlock*)((intptr_t)freeBlocks->next & ~NULLC::OBJECT_MASK);
+			page = allocPage;
+			result = page->freeBlocks;
+			page->freeBlocks = (MySmallBlock*)((intptr_t)result->next & ~NULLC::OBJECT_MASK);
+			page->freeCount--;
 		}else{
 			if(lastNum == countInBlock)
 			{
@@ -150,105 +452,159 @@ public:
 				newPage->next = activePages;
 				activePages = newPage;
 				lastNum = 0;
-				sortedPages.push_back(newPage);
-				int index = sortedPages.size() - 1;
-				while(index > 0 && sortedPages[index] < sortedPages[index - 1])
-				{
-					MyLargeBlock *tmp = sortedPages[index];
-					sortedPages[index] = sortedPages[index - 1];
-					sortedPages[index - 1] = tmp;
-					index--;
-				}
+
+				NULLC::heapPages.Insert(newPage, sizeof(MyLargeBlock), SpanKind());
 			}
+			page = activePages;
 			result = &activePages->page[lastNum++];
 		}
+
+		// New blocks are marked so that a sweep that follows an allocation during a collection will not free them
+		unsigned index = unsigned(result - page->page);
+		page->markBits[index / markWordBits] |= uintptr_t(1) << (index % markWordBits);
+
+		if(finalizable)
+			page->hasFinalizable = true;
+
 		return result;
 	}
 
-	void Free(void* ptr)
+	// Every unmarked block of the page is placed into the page free list
+	void Sweep(MyLargeBlock *page)
 	{
-		if(!ptr)
-			return;
-		MySmallBlock* freedBlock = static_cast<MySmallBlock*>(static_cast<void*>(ptr));
-		freedBlock->next = (MySmallBlock*)((intptr_t)freeBlocks | NULLC::OBJECT_FREED);
-		freeBlocks = freedBlock;
+		unsigned count = page == activePages ? lastNum : countInBlock;
+
+		page->freeBlocks = NULL;
+		page->freeCount = 0;
+
+		for(unsigned word = 0; word * markWordBits < count; word++)
+		{
+			uintptr_t unmarked = ~page->markBits[word];
+
+			if(count - word * markWordBits < markWordBits)
+				unmarked &= (uintptr_t(1) << (count - word * markWordBits)) - 1;
+
+			for(unsigned i = word * markWordBits; unmarked; i++, unmarked >>= 1)
+			{
+				if(!(unmarked & 1))
+					continue;
+
+				MySmallBlock *block = &page->page[i];
+
+				block->next = (MySmallBlock*)((intptr_t)page->freeBlocks | NULLC::OBJECT_FREED);
+				page->freeBlocks = block;
+				page->freeCount++;
+			}
+		}
+	}
+
+	void FinishSweep()
+	{
+		while(sweepPage)
+		{
+			Sweep(sweepPage);
+			sweepPage = sweepPage->next;
+		}
 	}
 
-	bool IsBasePointer(void* ptr)
+	// Marked blocks are reported to the heap profiler as survivors of the collection
+	void ProfileSurvivors()
 	{
-		MyLargeBlock *curr = activePages;
-		while(curr)
+		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
 		{
-			if((char*)ptr >= (char*)curr->page && (char*)ptr <= (char*)curr->page + sizeof(curr->page))
+			unsigned count = curr == activePages ? lastNum : countInBlock;
+
+			for(unsigned i = 0; i < count; i++)
 			{
-				if(((unsigned int)(intptr_t)((char*)ptr - (char*)curr->page) & (elemSize - 1)) == sizeof(markerType))
-					return true;
+				if(curr->markBits[i / markWordBits] & (uintptr_t(1) << (i % markWordBits)))
+					NULLC::ProfileSurvivor(curr->page[i].marker, elemSize);
 			}
-			curr = curr->next;
 		}
-		return false;
 	}
 
-	void* GetBasePointer(void* ptr)
+	// Page map kind of the pool pages
+	static unsigned SpanKind()
 	{
-		if(sortedPages.count == 0 || ptr < sortedPages.data[0] || ptr > (char*)sortedPages.data[sortedPages.count - 1] + sizeof(MyLargeBlock))
-			return NULL;
-		// Binary search
-		unsigned int lowerBound = 0;
-		unsigned int upperBound = sortedPages.count - 1;
-		unsigned int pointer = 0;
-		while(upperBound - lowerBound > 1)
-		{
-			pointer = (lowerBound + upperBound) >> 1;
-			if(ptr < sortedPages.data[pointer])
-				upperBound = pointer;
-			if(ptr > sortedPages.data[pointer])
-				lowerBound = pointer;
-		}
-		if(ptr < sortedPages.data[pointer])
-			pointer--;
-		if(ptr > (char*)sortedPages.data[pointer]  + sizeof(MyLargeBlock))
-			pointer++;
-		MyLargeBlock *best = sortedPages.data[pointer];
-
-		if(ptr < best->page || ptr > (char*)best + sizeof(best->page))
+		unsigned kind = HeapPageMap::SPAN_POOL_8;
+
+		while(poolSizeClasses[kind - HeapPageMap::SPAN_POOL_8] != elemSize)
+			kind++;
+
+		return kind;
+	}
+
+	// Page is found in the heap page map
+	bool IsBasePointer(char* span, void* ptr)
+	{
+		MyLargeBlock *page = (MyLargeBlock*)span;
+
+		if((char*)ptr < (char*)page->page || (char*)ptr >= (char*)page->page + sizeof(page->page))
+			return false;
+
+		return ((unsigned int)(intptr_t)((char*)ptr - (char*)page->page) & (elemSize - 1)) == sizeof(markerType);
+	}
+
+	void* GetBasePointer(char* span, void* ptr, NULLC::ObjectMark *mark)
+	{
+		MyLargeBlock *best = (MyLargeBlock*)span;
+
+		if((char*)ptr < (char*)best->page || (char*)ptr >= (char*)best->page + sizeof(best->page))
 			return NULL;
+
 		unsigned int fromBase = (unsigned int)(intptr_t)((char*)ptr - (char*)best->page);
+
+		if(mark)
+		{
+			unsigned index = fromBase / elemSize;
+
+			mark->word = &best->markBits[index / markWordBits];
+			mark->bit = uintptr_t(1) << (index % markWordBits);
+		}
+
 		return (char*)best->page + (fromBase & ~(elemSize - 1)) + sizeof(markerType);
 	}
 
 	void Mark(unsigned int number)
 	{
 		assert(number <= 1);
-		MyLargeBlock *curr = activePages;
-		while(curr)
-		{
-			for(unsigned int i = 0; i < (curr == activePages ? lastNum : countInBlock); i++)
-			{
-				curr->page[i].marker = (curr->page[i].marker & ~NULLC::OBJECT_VISIBLE) | number;
-			}
-			curr = curr->next;
-		}
+
+		// Dead objects from the previous collection must be gone before they can be reached by a stale pointer
+		FinishSweep();
+
+		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
+			memset(curr->markBits, number ? ~0 : 0, sizeof(curr->markBits));
 	}
 
+	// Only pages that had finalizable objects allocated in them are checked, other unmarked blocks are freed by the sweep
 	void CollectUnmarked()
 	{
 		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
 		{
-			for(unsigned int i = 0; i < (curr == activePages ? lastNum : countInBlock); i++)
+			if(!curr->hasFinalizable)
+				continue;
+
+			unsigned count = curr == activePages ? lastNum : countInBlock;
+
+			for(unsigned word = 0; word * markWordBits < count; word++)
 			{
-				markerType &marker = curr->page[i].marker;
+				uintptr_t unmarked = ~curr->markBits[word];
 
-				if(!(marker & (NULLC::OBJECT_VISIBLE | NULLC::OBJECT_FREED)))
+				// Blocks past the end of the page are never allocated
+				if(count - word * markWordBits < markWordBits)
+					unmarked &= (uintptr_t(1) << (count - word * markWordBits)) - 1;
+
+				for(unsigned i = word * markWordBits; unmarked; i++, unmarked >>= 1)
 				{
+					if(!(unmarked & 1))
+						continue;
+
+					markerType &marker = curr->page[i].marker;
+
+					if(marker & NULLC::OBJECT_FREED)
+						continue;
+
 					if((marker & NULLC::OBJECT_FINALIZABLE) && !(marker & NULLC::OBJECT_FINALIZED))
-					{
-						objectsToFinalize.push_back(&curr->page[i]);
-					}
-					else
-					{
-						objectsToFree.push_back(&curr->page[i]);
-					}
+						objectsToFinalize.push_back(PendingBlock(&curr->page[i], curr, i));
 				}
 			}
 		}
@@ -258,12 +614,12 @@ public:
 	{
 		for(unsigned i = 0, e = objectsToFinalize.size(); i < e; i++)
 		{
-			MySmallBlock *block = objectsToFinalize[i];
+			MySmallBlock *block = objectsToFinalize[i].block;
 
 			markerType &marker = block->marker;
 
 			// Mark block as used
-			marker |= NULLC::OBJECT_VISIBLE;
+			*objectsToFinalize[i].mark.word |= objectsToFinalize[i].mark.bit;
 
 			ExternTypeInfo &typeInfo = NULLC::linker->exTypes[(unsigned)marker >> 8];
 
@@ -288,510 +644,3905 @@ public:
 		objectsToFinalize.clear();
 	}
 
-	unsigned FreePending(unsigned &usedMemory)
+	// Unmarked objects are freed lazily by the allocator, but their memory is no longer accounted as used
+	unsigned BeginSweep(uintptr_t &usedMemory)
 	{
 		unsigned freed = 0;
 
-		for(unsigned i = 0, e = objectsToFree.size(); i < e; i++)
+		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
 		{
-			MySmallBlock *block = objectsToFree[i];
+			unsigned count = curr == activePages ? lastNum : countInBlock;
 
-			markerType &marker = block->marker;
+			unsigned marked = 0;
 
-			// Check flags again, finalizers might have some objects reachable
-			if(!(marker & (NULLC::OBJECT_VISIBLE | NULLC::OBJECT_FREED)))
+			for(unsigned word = 0; word * markWordBits < count; word++)
 			{
-				Free(block);
+				uintptr_t bits = curr->markBits[word];
 
-				freed++;
+				// Slots past the end of the active page are not counted
+				if(count - word * markWordBits < markWordBits)
+					bits &= (uintptr_t(1) << (count - word * markWordBits)) - 1;
+
+				marked += CountMarkBits(bits);
 			}
+
+			// Blocks that were already free are unmarked as well
+			if(count - marked > curr->freeCount)
+				freed += count - marked - curr->freeCount;
 		}
 
-		objectsToFree.clear();
+		allocPage = NULL;
+		sweepPage = activePages;
 
-		usedMemory -= freed * elemSize;
+		usedMemory -= uintptr_t(freed) * elemSize;
 
 		return freed;
 	}
 
-	MySmallBlock	lastBlock;
-
-	MySmallBlock	*freeBlocks;
-	MyLargeBlock	*activePages;
-	unsigned int	lastNum;
-
-	FastVector<MyLargeBlock*> sortedPages;
-
-	FastVector<MySmallBlock*> objectsToFinalize;
-	FastVector<MySmallBlock*> objectsToFree;
-};
-
-namespace NULLC
-{
-	const unsigned int poolBlockSize = 64 * 1024;
-
-	bool collectionEnabled = true;
-
-	unsigned int usedMemory = 0;
+	// Pages that are occupied less than the specified share are evacuated by the compacting collection, the page that is being filled is left in place
+	void SelectEvacuationPages(double occupancy)
+	{
+		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
+		{
+			if(curr == activePages)
+				continue;
 
-	unsigned int collectableMinimum = 1024 * 1024;
-	unsigned int globalMemoryLimit = 1024 * 1024 * 1024;
+			if(countInBlock - curr->freeCount < countInBlock * occupancy)
+			{
+				curr->flags |= PAGE_EVACUATING;
 
-	ObjectBlockPool<8, poolBlockSize / 8>		pool8;
-	ObjectBlockPool<16, poolBlockSize / 16>		pool16;
-	ObjectBlockPool<32, poolBlockSize / 32>		pool32;
-	ObjectBlockPool<64, poolBlockSize / 64>		pool64;
-	ObjectBlockPool<128, poolBlockSize / 128>	pool128;
-	ObjectBlockPool<256, poolBlockSize / 256>	pool256;
-	ObjectBlockPool<512, poolBlockSize / 512>	pool512;
+				if(curr == allocPage)
+					allocPage = NULL;
+			}
+		}
+	}
 
-	struct Range
+	// Reachable objects are copied out of the evacuated pages, moved blocks are unmarked and keep a pointer to the new location in place of the object data
+	unsigned Evacuate(uintptr_t &usedMemory)
 	{
-		Range(): start(NULL), end(NULL)
-		{
-		}
-		Range(void* start, void* end): start(start), end(end)
-		{
-		}
+		unsigned moved = 0;
 
-		// Ranges are equal if they intersect
-		bool operator==(const Range& rhs) const
+		for(MyLargeBlock *curr = activePages; curr; curr = curr->next)
 		{
-			return !(start > rhs.end || end < rhs.start);
-		}
+			if(!(curr->flags & PAGE_EVACUATING))
+				continue;
 
-		bool operator<(const Range& rhs) const
-		{
-			return end < rhs.start;
-		}
+			for(unsigned i = 0; i < countInBlock; i++)
+			{
+				uintptr_t &word = curr->markBits[i / markWordBits];
+				uintptr_t bit = uintptr_t(1) << (i % markWordBits);
 
-		bool operator>(const Range& rhs) const
-		{
-			return start > rhs.end;
-		}
+				if(!(word & bit))
+					continue;
 
-		void *start, *end;
-	};
+				MySmallBlock *block = &curr->page[i];
 
-	typedef Tree<Range>::iterator BigBlockIterator;
-	Tree<Range>	bigBlocks;
+				// Objects referenced from memory without type information, objects with an address-based hash and finalizable objects stay in place
+				if(block->marker & (NULLC::OBJECT_FREED | NULLC::OBJECT_PINNED | NULLC::OBJECT_HASHED | NULLC::OBJECT_FINALIZABLE))
+					continue;
 
-	unsigned currentMark = 0;
+				MySmallBlock *copy = (MySmallBlock*)Alloc(false);
 
-	FastVector<Range> blocksToFinalize;
-	FastVector<Range> blocksToFree;
+				memcpy(copy, block, elemSize);
 
-	void MarkBlock(Range& curr);
-	void CollectUnmarkedBlock(Range& curr);
-	void ClearBlock(Range& curr);
+				WriteVmMemoryPointer(block->data + sizeof(markerType), copy->data + sizeof(markerType));
 
-	double	markTime = 0.0;
-	double	collectTime = 0.0;
-}
+				word &= ~bit;
 
-void NULLC::SetLinker(Linker *linker)
-{
-	NULLC::linker = linker;
-}
+				usedMemory += elemSize;
+				moved++;
+			}
+		}
 
-void* NULLC::AllocObject(int size, unsigned type)
-{
-	if(size < 0)
-	{
-		nullcThrowError("ERROR: requested memory size is less than zero");
-		return NULL;
+		return moved;
 	}
-	void *data = NULL;
-	size += sizeof(markerType);
 
-	if((unsigned int)(usedMemory + size) > globalMemoryLimit)
+	// Evacuated pages without pinned objects are released, the rest are returned to the pool
+	unsigned ReleaseEvacuatedPages(uintptr_t &usedMemory)
 	{
-		CollectMemory();
+		unsigned released = 0;
+
+		MyLargeBlock *prev = NULL;
 
-		if((unsigned int)(usedMemory + size) > globalMemoryLimit)
+		for(MyLargeBlock *curr = activePages; curr;)
 		{
-			nullcThrowError("ERROR: reached global memory maximum");
+			MyLargeBlock *next = curr->next;
+
+			if(!(curr->flags & PAGE_EVACUATING))
+			{
+				prev = curr;
+				curr = next;
+				continue;
+			}
+
+			curr->flags &= ~PAGE_EVACUATING;
+
+			bool hasPinned = false;
+
+			for(unsigned i = 0; i < countInBlock; i++)
+			{
+				if(curr->markBits[i / markWordBits] & (uintptr_t(1) << (i % markWordBits)))
+				{
+					curr->page[i].marker &= ~NULLC::OBJECT_PINNED;
+
+					hasPinned = true;
+				}
+			}
+
+			if(hasPinned)
+			{
+				prev = curr;
+				curr = next;
+				continue;
+			}
+
+			// Every block that is not in the free list is accounted as used until the page is swept
+			released += countInBlock - curr->freeCount;
+
+			usedMemory -= uintptr_t(countInBlock - curr->freeCount) * elemSize;
+
+			if(prev)
+				prev->next = next;
+			else
+				activePages = next;
+
+			if(allocPage == curr)
+				allocPage = NULL;
+			if(sweepPage == curr)
+				sweepPage = next;
+
+			NULLC::heapPages.Remove(curr, sizeof(MyLargeBlock));
+
+			NULLC::alignedDealloc(curr);
+
+			curr = next;
+		}
+
+		return released;
+	}
+
+	MyLargeBlock	*activePages;
+	unsigned int	lastNum;
+
+	// Page with the free list that is used for allocation and the next page that is waiting to be swept
+	MyLargeBlock	*allocPage;
+	MyLargeBlock	*sweepPage;
+
+	FastVector<PendingBlock> objectsToFinalize;
+};
+
+// nursery object storage:	size, padding, marker, data...
+// Objects are bump-allocated in chunks at 16 byte granules, a bitmap of object starts is used to find the object that contains an interior pointer
+class Nursery
+{
+public:
+	static const unsigned chunkSize = 32 * 1024;
+	static const unsigned headerSize = 16;
+
+	// Set in the size field of objects that were moved out of the nursery, object data begins with a pointer to the new location
+	static const unsigned OBJECT_FORWARDED = 1u << 31;
+
+	enum ChunkState
+	{
+		CHUNK_FREE,
+		CHUNK_YOUNG,
+		CHUNK_RETAINED
+	};
+
+	struct Chunk
+	{
+		unsigned state;
+		unsigned top;
+
+		// Size of objects that were kept in place by a collection and are accounted as old memory
+		unsigned retainedBytes;
+	};
+
+	Nursery()
+	{
+		memory = NULL;
+		chunks = NULL;
+		chunkCount = 0;
+		objectStarts = NULL;
+
+		currentChunk = ~0u;
+		youngBytes = 0;
+	}
+
+	~Nursery()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		if(memory)
+			NULLC::alignedDealloc(memory);
+		if(chunks)
+			NULLC::alignedDealloc(chunks);
+		if(objectStarts)
+			NULLC::alignedDealloc(objectStarts);
+
+		memory = NULL;
+		chunks = NULL;
+		chunkCount = 0;
+		objectStarts = NULL;
+
+		currentChunk = ~0u;
+		youngBytes = 0;
+
+		freeChunks.reset();
+	}
+
+	void Init(unsigned size)
+	{
+		unsigned count = (size + chunkSize - 1) / chunkSize;
+
+		if(count == chunkCount)
+		{
+			Clear();
+			return;
+		}
+
+		Reset();
+
+		if(!count)
+			return;
+
+		memory = (char*)NULLC::alignedAlloc(count * chunkSize);
+		chunks = (Chunk*)NULLC::alignedAlloc(count * sizeof(Chunk));
+		objectStarts = (unsigned*)NULLC::alignedAlloc(count * BitmapBytes());
+
+		if(!memory || !chunks || !objectStarts)
+		{
+			Reset();
+			return;
+		}
+
+		chunkCount = count;
+
+		for(unsigned i = chunkCount; i > 0; i--)
+			ReleaseChunk(i - 1);
+	}
+
+	void Clear()
+	{
+		freeChunks.clear();
+
+		for(unsigned i = chunkCount; i > 0; i--)
+			ReleaseChunk(i - 1);
+
+		currentChunk = ~0u;
+		youngBytes = 0;
+	}
+
+	bool IsEmpty()
+	{
+		return freeChunks.size() == chunkCount;
+	}
+
+	static unsigned ObjectSize(unsigned size)
+	{
+		unsigned total = (size + headerSize - sizeof(markerType) + 15) & ~15u;
+
+		return total < 32 ? 32 : total;
+	}
+
+	static unsigned& ObjectHeader(char *base)
+	{
+		return *(unsigned*)(base - headerSize);
+	}
+
+	static markerType& ObjectMarker(char *base)
+	{
+		return *(markerType*)(base - sizeof(markerType));
+	}
+
+	// Returns a pointer to the object marker, object data follows it
+	void* Alloc(unsigned size)
+	{
+		unsigned total = ObjectSize(size);
+
+		if(currentChunk == ~0u || chunks[currentChunk].top + total > chunkSize)
+		{
+			if(freeChunks.empty())
+				return NULL;
+
+			currentChunk = freeChunks.back();
+			freeChunks.pop_back();
+
+			chunks[currentChunk].state = CHUNK_YOUNG;
+		}
+
+		Chunk &chunk = chunks[currentChunk];
+
+		unsigned offset = currentChunk * chunkSize + chunk.top;
+
+		objectStarts[offset >> 9] |= 1u << ((offset >> 4) & 31);
+
+		*(unsigned*)(memory + offset) = size;
+
+		chunk.top += total;
+		youngBytes += total;
+
+		return memory + offset + headerSize - sizeof(markerType);
+	}
+
+	bool Contains(void *ptr)
+	{
+		return (char*)ptr >= memory && (char*)ptr < memory + chunkCount * chunkSize;
+	}
+
+	// Returns the object data pointer for a pointer inside an object
+	char* FindObject(void *ptr, bool youngOnly)
+	{
+		if(!Contains(ptr))
+			return NULL;
+
+		unsigned offset = unsigned((char*)ptr - memory);
+
+		Chunk &chunk = chunks[offset / chunkSize];
+
+		if(chunk.state == CHUNK_FREE || (youngOnly && chunk.state != CHUNK_YOUNG))
+			return NULL;
+
+		if(offset % chunkSize >= chunk.top)
 			return NULL;
+
+		// Chunk always starts with an object
+		unsigned granule = offset >> 4;
+
+		while(!(objectStarts[granule >> 5] & (1u << (granule & 31))))
+			granule--;
+
+		return memory + (granule << 4) + headerSize;
+	}
+
+	char* ChunkStart(unsigned index)
+	{
+		return memory + index * chunkSize;
+	}
+
+	void ReleaseChunk(unsigned index)
+	{
+		chunks[index].state = CHUNK_FREE;
+		chunks[index].top = 0;
+		chunks[index].retainedBytes = 0;
+
+		memset((char*)objectStarts + index * BitmapBytes(), 0, BitmapBytes());
+
+		freeChunks.push_back(index);
+	}
+
+	// Size of the object start bitmap for a single chunk in bytes
+	static unsigned BitmapBytes()
+	{
+		return chunkSize / 16 / 8;
+	}
+
+	char	*memory;
+
+	Chunk	*chunks;
+	unsigned chunkCount;
+
+	unsigned *objectStarts;
+
+	FastVector<unsigned> freeChunks;
+
+	unsigned currentChunk;
+	unsigned youngBytes;
+};
+
+// arena object storage:	size, padding, marker, data...
+// Objects are bump-allocated in arena chunks and are freed together with the arena, GC never marks or frees them
+// Write barrier marks the cards of chunk memory that received pointers, only the objects on those cards are checked for pointers to the heap
+class MemoryArena
+{
+public:
+	static const unsigned chunkSize = 64 * 1024;
+	static const unsigned headerSize = 16;
+
+	static const unsigned cardShift = 9;
+
+	// Card bytes are placed after the chunk memory
+	struct Chunk
+	{
+		MemoryArena	*arena;
+		Chunk		*next;
+
+		uintptr_t	size;
+		uintptr_t	top;
+
+		bool		dirty;
+	};
+
+	// Objects that follow the chunk header are aligned to 16 bytes
+	static const unsigned chunkHeaderSize = (sizeof(Chunk) + 15) & ~15u;
+
+	MemoryArena(unsigned id, bool checkEscapes): id(id), checkEscapes(checkEscapes)
+	{
+		released = false;
+
+		chunks = NULL;
+		usedBytes = 0;
+	}
+
+	~MemoryArena()
+	{
+		while(chunks)
+		{
+			Chunk *next = chunks->next;
+
+			NULLC::heapPages.Remove(chunks, chunkHeaderSize + chunks->size);
+
+			NULLC::alignedDealloc(chunks);
+
+			chunks = next;
 		}
 	}
-	else if((unsigned int)(usedMemory + size) > collectableMinimum)
+
+	static uintptr_t ObjectSize(uintptr_t size)
 	{
-		CollectMemory();
+		return (size + headerSize - sizeof(markerType) + 15) & ~uintptr_t(15);
 	}
 
-	unsigned int realSize = size;
-	if(size <= 64)
+	static uintptr_t& ObjectHeader(char *base)
 	{
-		if(size <= 16)
+		return *(uintptr_t*)(base - headerSize);
+	}
+
+	// Returns a pointer to the object marker, object data follows it
+	void* Alloc(uintptr_t size)
+	{
+		uintptr_t total = ObjectSize(size);
+
+		if(!chunks || chunks->top + total > chunks->size)
 		{
-			if(size <= 8)
+			uintptr_t capacity = total > chunkSize ? total : chunkSize;
+
+			uintptr_t cardCount = CardCount(capacity);
+
+			if(chunkHeaderSize + capacity + cardCount > 0x7fff0000)
+				return NULL;
+
+			Chunk *chunk = (Chunk*)NULLC::alignedAlloc(int(chunkHeaderSize + capacity + cardCount));
+
+			if(!chunk)
+				return NULL;
+
+			chunk->arena = this;
+			chunk->size = capacity;
+			chunk->top = 0;
+			chunk->dirty = false;
+
+			memset(Cards(chunk), 0, cardCount);
+
+			// Objects that don't fit into a regular chunk get a chunk of their own that doesn't replace the current one
+			if(chunks && capacity > chunkSize)
 			{
-				data = pool8.Alloc();
-				realSize = 8;
-			}else{
-				data = pool16.Alloc();
-				realSize = 16;
+				chunk->next = chunks->next;
+				chunks->next = chunk;
 			}
-		}else{
-			if(size <= 32)
+			else
 			{
-				data = pool32.Alloc();
-				realSize = 32;
-			}else{
-				data = pool64.Alloc();
-				realSize = 64;
+				chunk->next = chunks;
+				chunks = chunk;
 			}
+
+			NULLC::heapPages.Insert(chunk, chunkHeaderSize + capacity, HeapPageMap::SPAN_ARENA);
+
+			if(capacity > chunkSize)
+				return Place(chunk, size, total);
 		}
-	}else{
-		if(size <= 256)
+
+		return Place(chunks, size, total);
+	}
+
+	void* Place(Chunk *chunk, uintptr_t size, uintptr_t total)
+	{
+		char *base = (char*)chunk + chunkHeaderSize + chunk->top + headerSize;
+
+		chunk->top += total;
+
+		ObjectHeader(base) = size;
+
+		usedBytes += total;
+
+		return base - sizeof(markerType);
+	}
+
+	static uintptr_t CardCount(uintptr_t capacity)
+	{
+		return (capacity + (1 << cardShift) - 1) >> cardShift;
+	}
+
+	static unsigned char* Cards(Chunk *chunk)
+	{
+		return (unsigned char*)chunk + chunkHeaderSize + chunk->size;
+	}
+
+	static void MarkCard(Chunk *chunk, void *ptr)
+	{
+		Cards(chunk)[((char*)ptr - ((char*)chunk + chunkHeaderSize)) >> cardShift] = 1;
+
+		chunk->dirty = true;
+	}
+
+	// Cards stay marked until the arena is released, since arena objects are not traced otherwise
+	static bool HasMarkedCard(Chunk *chunk, uintptr_t start, uintptr_t end)
+	{
+		unsigned char *cards = Cards(chunk);
+
+		for(uintptr_t card = start >> cardShift; card <= (end - 1) >> cardShift; card++)
 		{
-			if(size <= 128)
-			{
-				data = pool128.Alloc();
-				realSize = 128;
-			}else{
-				data = pool256.Alloc();
-				realSize = 256;
-			}
-		}else{
-			if(size <= 512)
-			{
-				data = pool512.Alloc();
-				realSize = 512;
-			}else{
-				void *ptr = NULLC::alignedAlloc(size - sizeof(markerType), 4 + sizeof(markerType));
-				if(ptr == NULL)
-				{
-					nullcThrowError("Allocation failed.");
-					return NULL;
-				}
+			if(cards[card])
+				return true;
+		}
+
+		return false;
+	}
+
+	// Chunk that contains the pointer, the span found in the heap page map has to be checked for the chunk end
+	static Chunk* FindChunk(char *span, void *ptr)
+	{
+		Chunk *chunk = (Chunk*)span;
+
+		if((char*)ptr < span + chunkHeaderSize || (char*)ptr >= span + chunkHeaderSize + chunk->size)
+			return NULL;
+
+		return chunk;
+	}
+
+	unsigned	id;
+	bool		checkEscapes;
+
+	// Set while the escape check collection runs, before the memory is freed
+	bool		released;
+
+	Chunk		*chunks;
+	uintptr_t	usedBytes;
+};
+
+// Open addressing index of objects that are referenced weakly, it is rebuilt after the collector moves or removes objects
+class PointerIndex
+{
+public:
+	struct Item
+	{
+		char		*key;
+		unsigned	value;
+	};
+
+	PointerIndex()
+	{
+		count = 0;
+	}
+
+	void Clear()
+	{
+		for(unsigned i = 0; i < items.size(); i++)
+			items[i].key = NULL;
+
+		count = 0;
+	}
+
+	void Reset()
+	{
+		items.reset();
+
+		count = 0;
+	}
+
+	unsigned* Find(char *key)
+	{
+		if(!count)
+			return NULL;
+
+		unsigned mask = items.size() - 1;
+
+		for(unsigned i = Hash(key) & mask; items[i].key; i = (i + 1) & mask)
+		{
+			if(items[i].key == key)
+				return &items[i].value;
+		}
+
+		return NULL;
+	}
+
+	void Insert(char *key, unsigned value)
+	{
+		// Index is kept at most half full
+		if((count + 1) * 2 > items.size())
+			Grow();
+
+		unsigned mask = items.size() - 1;
+
+		unsigned i = Hash(key) & mask;
+
+		while(items[i].key)
+			i = (i + 1) & mask;
+
+		items[i].key = key;
+		items[i].value = value;
+
+		count++;
+	}
+
+	static unsigned Hash(char *key)
+	{
+		uintptr_t value = uintptr_t(key) >> 4;
+
+		return unsigned(value ^ (value >> 15)) * 2654435761u;
+	}
+
+	void Grow()
+	{
+		FastVector<Item> old;
+
+		for(unsigned i = 0; i < items.size(); i++)
+		{
+			if(items[i].key)
+				old.push_back(items[i]);
+		}
+
+		unsigned size = items.size() ? items.size() * 2 : 16;
+
+		items.resize(size);
+
+		Clear();
+
+		for(unsigned i = 0; i < old.size(); i++)
+			Insert(old[i].key, old[i].value);
+	}
+
+	FastVector<Item>	items;
+	unsigned			count;
+};
+
+// Table with weak keys that are compared by address, values are reachable only while both the key and the table owner object are reachable
+class WeakTable
+{
+public:
+	struct Entry
+	{
+		char		*key;
+		NULLCRef	value;
+
+		// Set when the value is marked by the current collection
+		bool		traced;
+	};
+
+	WeakTable(unsigned id, char *owner): id(id), owner(owner)
+	{
+		indexValid = true;
+	}
+
+	Entry* Find(char *key)
+	{
+		if(!indexValid)
+			RebuildIndex();
+
+		if(unsigned *position = index.Find(key))
+			return &entries[*position];
+
+		return NULL;
+	}
+
+	void Set(char *key, NULLCRef value)
+	{
+		if(Entry *entry = Find(key))
+		{
+			entry->value = value;
+			return;
+		}
+
+		Entry entry;
+
+		entry.key = key;
+		entry.value = value;
+		entry.traced = false;
+
+		index.Insert(key, entries.size());
+
+		entries.push_back(entry);
+	}
+
+	void RemoveAt(unsigned position)
+	{
+		entries[position] = entries.back();
+		entries.pop_back();
+
+		indexValid = false;
+	}
+
+	void RebuildIndex()
+	{
+		index.Clear();
+
+		for(unsigned i = 0; i < entries.size(); i++)
+			index.Insert(entries[i].key, i);
+
+		indexValid = true;
+	}
+
+	unsigned	id;
+	char		*owner;
+
+	FastVector<Entry>	entries;
+
+	PointerIndex	index;
+	bool			indexValid;
+};
+
+namespace NULLC
+{
+	const unsigned int poolBlockSize = 64 * 1024;
+
+	// Pages of medium size classes are larger, so that they still hold a few objects
+	const unsigned int mediumPoolBlockSize = 256 * 1024;
+
+	// Objects that are larger than the biggest size class are placed into their own memory regions
+	const unsigned int maxPoolObjectSize = 32 * 1024;
+
+	// Big blocks are linked into a list and start with the object size
+	struct BigBlock
+	{
+		BigBlock	*prev;
+		BigBlock	*next;
+
+		uintptr_t	size;
+	};
+
+	// Object that follows the header and the marker is aligned to 16 bytes
+	const unsigned int bigBlockHeaderSize = sizeof(BigBlock);
+
+	// Largest big block that can be requested from a custom allocation function
+	const uintptr_t maxAllocatorBigBlockSize = 0x7fff0000;
+
+	bool collectionEnabled = true;
+
+	// Heap accounting is pointer-sized, so 64-bit builds can grow the heap past 4Gb
+	uintptr_t usedMemory = 0;
+
+	uintptr_t collectableMinimum = 1024 * 1024;
+	uintptr_t globalMemoryLimit = 1024 * 1024 * 1024;
+
+	// Next collection starts when the heap grows to the memory that survived the last one multiplied by the growth factor, within the heap size bounds
+	double gcGrowthFactor = 2.0;
+	uintptr_t gcMinimumHeap = 1024 * 1024;
+	uintptr_t gcMaximumHeap = 0;
+
+	ObjectBlockPool<8, poolBlockSize / 8>		pool8;
+	ObjectBlockPool<16, poolBlockSize / 16>		pool16;
+	ObjectBlockPool<32, poolBlockSize / 32>		pool32;
+	ObjectBlockPool<64, poolBlockSize / 64>		pool64;
+	ObjectBlockPool<128, poolBlockSize / 128>	pool128;
+	ObjectBlockPool<256, poolBlockSize / 256>	pool256;
+	ObjectBlockPool<512, poolBlockSize / 512>	pool512;
+
+	ObjectBlockPool<1024, mediumPoolBlockSize / 1024>	pool1024;
+	ObjectBlockPool<2048, mediumPoolBlockSize / 2048>	pool2048;
+	ObjectBlockPool<4096, mediumPoolBlockSize / 4096>	pool4096;
+	ObjectBlockPool<8192, mediumPoolBlockSize / 8192>	pool8192;
+	ObjectBlockPool<16384, mediumPoolBlockSize / 16384>	pool16384;
+	ObjectBlockPool<32768, mediumPoolBlockSize / 32768>	pool32768;
+
+	// List of all big blocks
+	BigBlock	*bigBlocks = NULL;
+
+	unsigned currentMark = 0;
+
+	FastVector<BigBlock*> blocksToFinalize;
+	FastVector<BigBlock*> blocksToFree;
+
+	void*	AllocBigBlock(uintptr_t size, bool &cleared);
+	bool	BigBlocksFromAllocator();
+	void	FreeBigBlock(BigBlock *block);
+
+	void	CollectUnmarkedBlock(BigBlock *block);
+
+	double	markTime = 0.0;
+	double	collectTime = 0.0;
+
+	unsigned int collectionCount = 0;
+	double	collectionCountStart = 0.0;
+
+	// Collection statistics are measured with a high resolution clock
+	double	statisticsStart = 0.0;
+
+	NULLCGCStatistics	gcStatistics;
+
+	// Ring buffer of the recent full collections
+	NULLCCollectionInfo	collectionHistory[NULLC_GC_HISTORY_SIZE];
+	unsigned	collectionHistoryCount = 0;
+
+	unsigned long long	collectionObjectsFreed = 0;
+	unsigned long long	collectionObjectsMoved = 0;
+	unsigned long long	collectionRootsStart = 0;
+
+	Nursery	nursery;
+	unsigned int nurserySize = 0;
+
+	enum CollectionMode
+	{
+		COLLECT_FULL,
+		COLLECT_MINOR,
+		COLLECT_EVACUATE
+	};
+
+	CollectionMode collectionMode = COLLECT_FULL;
+
+	// Old objects that were modified to point to young objects
+	FastVector<char*> rememberedSet;
+
+	// Locations of pointers to objects that are moved by the current collection
+	FastVector<char*> evacuationSlots;
+
+	// Block pool pages that are occupied less than this share are evacuated by full collections started from script code, 0 disables compaction
+	double compactionOccupancy = 0.0;
+
+	// Set while the collection records the locations of pointers to the objects in evacuated pages
+	bool compactionActive = false;
+
+	FastVector<char*> compactionSlots;
+
+	// Number of active script calls started by the host
+	unsigned scriptRunDepth = 0;
+
+	FastVector<MemoryArena*> arenas;
+
+	// Arenas that receive objects created by script code, the last one is used
+	FastVector<MemoryArena*> arenaScopes;
+
+	// Number of arena scopes at the start of each active script call
+	FastVector<unsigned> scriptRunArenaScopes;
+
+	uintptr_t arenaMemory = 0;
+	unsigned arenaNextId = 1;
+
+	// Number of pointers to a released arena that were found by the debug escape check, parallel marker threads can find them at the same time
+	bool arenaEscapeCheck = false;
+	volatile long arenaEscapes = 0;
+
+	// Weak reference handle contains the slot index and the generation of the slot, which is changed when the target object is freed
+	struct WeakSlot
+	{
+		char		*target;
+		unsigned	type;
+		unsigned	generation;
+	};
+
+	FastVector<WeakSlot> weakSlots;
+	FastVector<unsigned> weakFreeSlots;
+
+	// Weak references to the same object share a slot
+	PointerIndex weakSlotIndex;
+	bool weakSlotIndexValid = true;
+
+	// Weak tables are indexed by their id, released tables leave an empty place
+	FastVector<WeakTable*> weakTables;
+	FastVector<unsigned> weakFreeTables;
+
+	// Finalizers are run by the host instead of the collection that found the objects
+	bool deferredFinalizers = false;
+	bool finalizersRunning = false;
+
+	// Number of objects that are finalized by a single script call, time budget is checked between the batches
+	const unsigned finalizerBatchSize = 16;
+
+	// Time limit for a single incremental marking slice in microseconds, marking is performed all at once if it is 0
+	unsigned markingSliceBudget = 0;
+
+	bool incrementalMarking = false;
+
+	// Set while the write barrier has work to do, compiled code checks it before calling WriteBarrier
+	// Barrier is also used to find the arena memory that can contain pointers to the heap
+	unsigned writeBarrierActive = 0;
+
+	void UpdateWriteBarrierState()
+	{
+		writeBarrierActive = nursery.chunkCount != 0 || incrementalMarking || !arenas.empty();
+	}
+
+	// Marking slice is performed each time this amount of memory is allocated
+	const unsigned markingSliceStep = 32 * 1024;
+	unsigned markingAllocated = 0;
+
+	// Heap snapshot tracing records the location of every pointer that is checked by the collector
+	bool snapshotTracing = false;
+	FastVector<char*> snapshotSlots;
+
+	void*	AllocPoolBlock(unsigned size, uintptr_t &realSize, bool finalizable);
+	void*	AllocObjectImpl(uintptr_t size, unsigned type, bool array, bool scriptAllocation);
+	NULLCArray	AllocArrayImpl(unsigned size, unsigned count, unsigned type, bool scriptAllocation);
+
+	// Pool pages with occupancy below 'compaction' are evacuated if it is not 0
+	void	CollectMemoryImpl(bool evacuate, double compaction);
+	uintptr_t	NextCollectionThreshold();
+
+	void*	GetBasePointer(void* ptr, ObjectMark *mark);
+
+	void	TraceObject(char *base);
+
+	uintptr_t	ObjectCapacity(char *base);
+	void	RecordSnapshotSlot(char *location);
+
+	unsigned	GetTimeMicroseconds();
+	double	GetPreciseTime();
+
+	void	RecordPause(double pause);
+	void	RecordCollection(NULLCCollectionInfo &info);
+
+	void	StartIncrementalMarking();
+	void	MarkIncrementalSlice();
+	void	FinishIncrementalMarking();
+
+	void	CollectNursery();
+	void	EvacuateNursery(bool includeRetained);
+	void	FreeNurseryObjects();
+
+	bool	IsEvacuating(void* ptr);
+	char*	ForwardedPointer(char* ptr);
+	void	CompactHeap();
+	void	ReleaseEvacuatedPages();
+
+	void*	AllocArenaObject(uintptr_t size, unsigned type, bool array);
+	MemoryArena*	FindArena(unsigned id);
+	void	CheckArenaEscape(void* ptr);
+
+	WeakTable*	FindWeakTable(int id);
+	bool	IsWeakTargetReachable(char* ptr);
+	char*	MovedPointer(char* ptr);
+	ExternTypeInfo*	FindAutoRefType();
+	void	MarkWeakTables();
+	void	MarkWeakTableValues();
+	void	ClearWeakReferences();
+	void	UpdateWeakReferences();
+	void	DestroyWeakReferences();
+
+	// Heap profiler statistics of a type or an allocation site
+	struct HeapProfileEntry
+	{
+		unsigned long long	allocations;
+		unsigned long long	allocatedBytes;
+
+		// Objects that survived the last collection
+		unsigned long long	survivors;
+		unsigned long long	survivorBytes;
+	};
+
+	struct HeapProfileCollection
+	{
+		unsigned long long	survivors;
+		unsigned long long	survivorBytes;
+	};
+
+	bool heapProfiler = false;
+
+	// Types are indexed by type index, with a separate entry for arrays of the type
+	FastVector<HeapProfileEntry> heapProfileTypes;
+
+	// Allocation sites are indexed by the instruction that performed an allocation
+	FastVector<HeapProfileEntry> heapProfileSites;
+	FastVector<unsigned> heapProfileSiteInstructions;
+	HashMap<unsigned> heapProfileSiteMap;
+
+	FastVector<HeapProfileCollection> heapProfileCollections;
+
+	FastVector<char> heapProfileReport;
+
+	void *heapProfileReportContext = NULL;
+	void (*heapProfileReportFunction)(void *context, const char *report) = NULL;
+
+	unsigned	CurrentAllocationSite();
+	void	ProfileAllocation(unsigned type, bool array, uintptr_t size);
+	void	ProfileSurvivors();
+}
+
+void NULLC::SetLinker(Linker *linker)
+{
+	NULLC::linker = linker;
+}
+
+void* NULLC::AllocPoolBlock(unsigned size, uintptr_t &realSize, bool finalizable)
+{
+	if(size <= 64)
+	{
+		if(size <= 16)
+		{
+			if(size <= 8)
+			{
+				realSize = 8;
+				return pool8.Alloc(finalizable);
+			}
+
+			realSize = 16;
+			return pool16.Alloc(finalizable);
+		}
+
+		if(size <= 32)
+		{
+			realSize = 32;
+			return pool32.Alloc(finalizable);
+		}
+
+		realSize = 64;
+		return pool64.Alloc(finalizable);
+	}
+
+	if(size <= 128)
+	{
+		realSize = 128;
+		return pool128.Alloc(finalizable);
+	}
+
+	if(size <= 256)
+	{
+		realSize = 256;
+		return pool256.Alloc(finalizable);
+	}
+
+	if(size <= 512)
+	{
+		realSize = 512;
+		return pool512.Alloc(finalizable);
+	}
+
+	if(size <= 4096)
+	{
+		if(size <= 1024)
+		{
+			realSize = 1024;
+			return pool1024.Alloc(finalizable);
+		}
+
+		if(size <= 2048)
+		{
+			realSize = 2048;
+			return pool2048.Alloc(finalizable);
+		}
+
+		realSize = 4096;
+		return pool4096.Alloc(finalizable);
+	}
+
+	if(size <= 8192)
+	{
+		realSize = 8192;
+		return pool8192.Alloc(finalizable);
+	}
+
+	if(size <= 16384)
+	{
+		realSize = 16384;
+		return pool16384.Alloc(finalizable);
+	}
+
+	assert(size <= maxPoolObjectSize);
+
+	realSize = 32768;
+	return pool32768.Alloc(finalizable);
+}
+
+void* NULLC::AllocObject(int size, unsigned type)
+{
+	if(size < 0)
+	{
+		nullcThrowError("ERROR: requested memory size is less than zero");
+		return NULL;
+	}
+
+	return AllocObjectImpl(size, type, false, false);
+}
+
+void* NULLC::NewObject(int size, unsigned type)
+{
+	if(size < 0)
+	{
+		nullcThrowError("ERROR: requested memory size is less than zero");
+		return NULL;
+	}
+
+	return AllocObjectImpl(size, type, false, true);
+}
+
+void* NULLC::AllocObjectImpl(uintptr_t size, unsigned type, bool array, bool scriptAllocation)
+{
+	void *data = NULL;
+	size += sizeof(markerType);
+
+	int finalize = 0;
+	if(type && (linker->exTypes[type].typeFlags & ExternTypeInfo::TYPE_HAS_FINALIZER))
+		finalize = (int)OBJECT_FINALIZABLE;
+
+	// Objects created by script code inside of an arena scope are placed into the arena, objects with finalizers are kept in the heap
+	if(scriptAllocation && !arenaScopes.empty() && !finalize)
+		return AllocArenaObject(size, type, array);
+
+	// Objects can be moved only from allocations performed by script code, when host code has no pointers to them
+	bool nurseryAllocation = scriptAllocation && nursery.chunkCount && !incrementalMarking && size <= 512 && !finalize;
+	bool safePoint = nurseryAllocation && scriptRunDepth == 1 && collectionEnabled && nullcGetCurrentExecutor(NULL) != NULLC_LLVM;
+
+	// Old objects are moved by the same rules, but only while marking is not in progress
+	double compaction = scriptAllocation && compactionOccupancy > 0.0 && scriptRunDepth == 1 && nullcGetCurrentExecutor(NULL) != NULLC_LLVM ? compactionOccupancy : 0.0;
+
+	if(usedMemory + nursery.youngBytes + arenaMemory + size > globalMemoryLimit)
+	{
+		bool markingStarted = incrementalMarking;
+
+		CollectMemoryImpl(safePoint, compaction);
+
+		// Objects allocated during incremental marking were kept alive by it
+		if(markingStarted && usedMemory + nursery.youngBytes + arenaMemory + size > globalMemoryLimit)
+			CollectMemoryImpl(safePoint, compaction);
+
+		if(usedMemory + nursery.youngBytes + arenaMemory + size > globalMemoryLimit)
+		{
+			nullcThrowError("ERROR: reached global memory maximum");
+			return NULL;
+		}
+	}
+	else if(usedMemory + size > collectableMinimum)
+	{
+		if(incrementalMarking)
+		{
+			// Collection is completed at once if marking can't keep up with allocation
+			if(usedMemory + size > collectableMinimum + (collectableMinimum >> 1))
+				CollectMemoryImpl(false, 0.0);
+		}
+		else if(markingSliceBudget && !nursery.chunkCount && collectionEnabled && nullcGetCurrentExecutor(NULL) != NULLC_LLVM)
+		{
+			StartIncrementalMarking();
+		}
+		else
+		{
+			CollectMemoryImpl(safePoint, compaction);
+		}
+	}
+
+	if(incrementalMarking)
+	{
+		markingAllocated += size;
+
+		if(markingAllocated >= markingSliceStep)
+		{
+			markingAllocated = 0;
+
+			MarkIncrementalSlice();
+		}
+	}
+
+	uintptr_t realSize = size;
+	if(nurseryAllocation)
+	{
+		data = nursery.Alloc(size);
+
+		if(!data && safePoint)
+		{
+			CollectNursery();
+
+			data = nursery.Alloc(size);
+		}
+
+		// Young memory is tracked by the nursery
+		if(data)
+			realSize = 0;
+	}
+
+	// Memory of big blocks placed into OS pages is already cleared
+	bool cleared = false;
+
+	if(!data)
+	{
+		if(size <= maxPoolObjectSize)
+		{
+			data = AllocPoolBlock(unsigned(size), realSize, finalize != 0);
+		}
+		else
+		{
+			data = AllocBigBlock(size, cleared);
+			if(data == NULL)
+			{
+				nullcThrowError("Allocation failed.");
+				return NULL;
+			}
+		}
+	}
+	usedMemory += realSize;
+
+	if(data == NULL)
+	{
+		nullcThrowError("ERROR: allocation failed");
+		return NULL;
+	}
+
+	if(!cleared)
+		memset(data, 0, size);
+
+	*(markerType*)data = finalize | (type << 8);
+
+	if(array)
+		*(markerType*)data |= OBJECT_ARRAY;
+
+	if(heapProfiler)
+		ProfileAllocation(type, array, size);
+
+	// Large objects allocated during incremental marking are kept alive by this collection, block pool objects are marked by the pool
+	if(incrementalMarking && size > maxPoolObjectSize)
+		*(markerType*)data |= OBJECT_VISIBLE;
+
+	return (char*)data + sizeof(markerType);
+}
+
+void* NULLC::AllocArenaObject(uintptr_t size, unsigned type, bool array)
+{
+	MemoryArena *arena = arenaScopes.back();
+
+	// Arena memory is not collected, so the collection is only attempted to free heap memory
+	if(usedMemory + nursery.youngBytes + arenaMemory + size > globalMemoryLimit)
+	{
+		CollectMemoryImpl(false, 0.0);
+
+		if(usedMemory + nursery.youngBytes + arenaMemory + size > globalMemoryLimit)
+		{
+			nullcThrowError("ERROR: reached global memory maximum");
+			return NULL;
+		}
+	}
+
+	uintptr_t arenaUsed = arena->usedBytes;
+
+	void *data = arena->Alloc(size);
+
+	if(data == NULL)
+	{
+		nullcThrowError("ERROR: allocation failed");
+		return NULL;
+	}
+
+	arenaMemory += arena->usedBytes - arenaUsed;
+
+	memset(data, 0, size);
+	*(markerType*)data = type << 8;
+
+	if(array)
+		*(markerType*)data |= OBJECT_ARRAY;
+
+	if(heapProfiler)
+		ProfileAllocation(type, array, size);
+
+	return (char*)data + sizeof(markerType);
+}
+
+unsigned int NULLC::UsedMemory()
+{
+	uintptr_t used = usedMemory + nursery.youngBytes + arenaMemory;
+
+	return used < 0xffffffffu ? unsigned(used) : 0xffffffffu;
+}
+
+long long NULLC::UsedMemoryLong()
+{
+	return usedMemory + nursery.youngBytes + arenaMemory;
+}
+
+NULLCArray NULLC::AllocArray(unsigned size, unsigned count, unsigned type)
+{
+	return AllocArrayImpl(size, count, type, false);
+}
+
+NULLCArray NULLC::NewArray(unsigned size, unsigned count, unsigned type)
+{
+	return AllocArrayImpl(size, count, type, true);
+}
+
+NULLCArray NULLC::AllocArrayImpl(unsigned size, unsigned count, unsigned type, bool scriptAllocation)
+{
+	NULLCArray ret;
+
+	ret.len = 0;
+	ret.ptr = NULL;
+
+	if((unsigned long long)size * count > globalMemoryLimit)
+	{
+		nullcThrowError("ERROR: can't allocate array with %u elements of size %u", count, size);
+		return ret;
+	}
+
+	ExternTypeInfo &typeInfo = NULLC::linker->exTypes[type];
+
+	unsigned arrayPadding = typeInfo.defaultAlign > 4 ? typeInfo.defaultAlign : 4;
+
+	uintptr_t bytes = uintptr_t(count) * size;
+
+	if(bytes == 0)
+		bytes += 4;
+
+	char *ptr = (char*)AllocObjectImpl(bytes + arrayPadding, type, true, scriptAllocation);
+
+	if(!ptr)
+		return ret;
+
+	ret.len = count;
+	ret.ptr = arrayPadding + ptr;
+
+	((unsigned*)ret.ptr)[-1] = count;
+
+	return ret;
+}
+
+// Custom allocation functions keep track of all memory, otherwise big blocks are placed into pages requested from the OS
+bool NULLC::BigBlocksFromAllocator()
+{
+	return NULLC::alloc != NULLC::defaultAlloc;
+}
+
+void* NULLC::AllocBigBlock(uintptr_t size, bool &cleared)
+{
+	void *region = NULL;
+
+	if(BigBlocksFromAllocator())
+	{
+		// Allocation function takes an int size
+		if(size > maxAllocatorBigBlockSize)
+			return NULL;
+
+		region = NULLC::alignedAlloc(int(size - sizeof(markerType)), bigBlockHeaderSize + sizeof(markerType));
+	}
+	else
+	{
+		uintptr_t regionSize = (bigBlockHeaderSize + size + 4095) & ~uintptr_t(4095);
+
+		if(regionSize < size)
+			return NULL;
+
+#if defined(_WIN32)
+		region = VirtualAlloc(NULL, regionSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+		region = mmap(NULL, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(region == MAP_FAILED)
+			region = NULL;
+#endif
+
+		// Memory of the OS pages is cleared
+		cleared = region != NULL;
+	}
+
+	if(!region)
+		return NULL;
+
+	BigBlock *block = (BigBlock*)region;
+
+	block->prev = NULL;
+	block->next = bigBlocks;
+	block->size = size;
+
+	if(bigBlocks)
+		bigBlocks->prev = block;
+	bigBlocks = block;
+
+	heapPages.Insert(block, bigBlockHeaderSize + size, HeapPageMap::SPAN_BIG_BLOCK);
+
+	return (char*)block + bigBlockHeaderSize;
+}
+
+// Memory region of the big block is returned right away
+void NULLC::FreeBigBlock(BigBlock *block)
+{
+	if(block->prev)
+		block->prev->next = block->next;
+	else
+		bigBlocks = block->next;
+
+	if(block->next)
+		block->next->prev = block->prev;
+
+	heapPages.Remove(block, bigBlockHeaderSize + block->size);
+
+	if(BigBlocksFromAllocator())
+	{
+		NULLC::alignedDealloc(block);
+		return;
+	}
+
+#if defined(_WIN32)
+	VirtualFree(block, 0, MEM_RELEASE);
+#else
+	munmap(block, (bigBlockHeaderSize + block->size + 4095) & ~uintptr_t(4095));
+#endif
+}
+
+void NULLC::MarkMemory(unsigned int number)
+{
+	assert(number <= 1);
+
+	currentMark = number;
+
+	for(BigBlock *curr = bigBlocks; curr; curr = curr->next)
+	{
+		markerType *marker = (markerType*)((char*)curr + bigBlockHeaderSize);
+		*marker = (*marker & ~NULLC::OBJECT_VISIBLE) | currentMark;
+	}
+
+	pool8.Mark(number);
+	pool16.Mark(number);
+	pool32.Mark(number);
+	pool64.Mark(number);
+	pool128.Mark(number);
+	pool256.Mark(number);
+	pool512.Mark(number);
+	pool1024.Mark(number);
+	pool2048.Mark(number);
+	pool4096.Mark(number);
+	pool8192.Mark(number);
+	pool16384.Mark(number);
+	pool32768.Mark(number);
+
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
+
+		for(unsigned offset = 0; offset < chunk.top;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			markerType &marker = Nursery::ObjectMarker(base);
+
+			if(!(marker & OBJECT_FREED))
+				marker = (marker & ~(OBJECT_VISIBLE | OBJECT_PINNED)) | number;
+
+			offset += Nursery::ObjectSize(Nursery::ObjectHeader(base));
+		}
+	}
+}
+
+void NULLC::CollectUnmarked()
+{
+	for(BigBlock *curr = bigBlocks; curr; curr = curr->next)
+		CollectUnmarkedBlock(curr);
+
+	pool8.CollectUnmarked();
+	pool16.CollectUnmarked();
+	pool32.CollectUnmarked();
+	pool64.CollectUnmarked();
+	pool128.CollectUnmarked();
+	pool256.CollectUnmarked();
+	pool512.CollectUnmarked();
+	pool1024.CollectUnmarked();
+	pool2048.CollectUnmarked();
+	pool4096.CollectUnmarked();
+	pool8192.CollectUnmarked();
+	pool16384.CollectUnmarked();
+	pool32768.CollectUnmarked();
+}
+
+void NULLC::FinalizePending()
+{
+	for(unsigned i = 0; i < blocksToFinalize.size(); i++)
+	{
+		BigBlock *block = blocksToFinalize[i];
+
+		markerType &marker = *(markerType*)((char*)block + bigBlockHeaderSize);
+
+		// Mark block as used
+		marker |= NULLC::OBJECT_VISIBLE;
+
+		ExternTypeInfo &typeInfo = NULLC::linker->exTypes[(unsigned)marker >> 8];
+
+		char *base = (char*)block + bigBlockHeaderSize;
+
+		if(marker & NULLC::OBJECT_ARRAY)
+		{
+			unsigned arrayPadding = typeInfo.defaultAlign > 4 ? typeInfo.defaultAlign : 4;
+
+			unsigned count = *(unsigned*)(base + sizeof(markerType) + arrayPadding - 4);
+
+			GC::CheckArrayElements(base + sizeof(markerType) + arrayPadding, count, typeInfo);
+		}
+		else
+		{
+			GC::CheckVariable(base + sizeof(markerType), typeInfo);
+		}
+
+		NULLC::FinalizeObject(marker, (char*)block + bigBlockHeaderSize);
+	}
+
+	blocksToFinalize.clear();
+
+	pool8.FinalizePending();
+	pool16.FinalizePending();
+	pool32.FinalizePending();
+	pool64.FinalizePending();
+	pool128.FinalizePending();
+	pool256.FinalizePending();
+	pool512.FinalizePending();
+	pool1024.FinalizePending();
+	pool2048.FinalizePending();
+	pool4096.FinalizePending();
+	pool8192.FinalizePending();
+	pool16384.FinalizePending();
+	pool32768.FinalizePending();
+
+	// Mark new roots
+	GC::MarkPendingRoots();
+}
+
+void NULLC::FreePending()
+{
+	for(unsigned i = 0; i < blocksToFree.size(); i++)
+	{
+		BigBlock *block = blocksToFree[i];
+
+		markerType &marker = *(markerType*)((char*)block + bigBlockHeaderSize);
+
+		// Check flags again, finalizers might have some objects reachable
+		if(!(marker & (NULLC::OBJECT_VISIBLE | NULLC::OBJECT_FREED)))
+		{
+			usedMemory -= block->size;
+
+			collectionObjectsFreed++;
+
+			FreeBigBlock(block);
+		}
+	}
+
+	blocksToFree.clear();
+
+	collectionObjectsFreed += pool8.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool16.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool32.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool64.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool128.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool256.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool512.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool1024.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool2048.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool4096.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool8192.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool16384.BeginSweep(usedMemory);
+	collectionObjectsFreed += pool32768.BeginSweep(usedMemory);
+
+	FreeNurseryObjects();
+}
+
+bool NULLC::IsBasePointer(void* ptr)
+{
+	if(nursery.Contains(ptr))
+		return nursery.FindObject(ptr, false) == ptr;
+
+	unsigned kind = 0;
+	char *span = heapPages.Find(ptr, kind);
+
+	if(!span)
+		return false;
+
+	switch(kind)
+	{
+	case HeapPageMap::SPAN_POOL_8:
+		return pool8.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_16:
+		return pool16.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_32:
+		return pool32.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_64:
+		return pool64.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_128:
+		return pool128.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_256:
+		return pool256.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_512:
+		return pool512.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_1024:
+		return pool1024.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_2048:
+		return pool2048.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_4096:
+		return pool4096.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_8192:
+		return pool8192.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_16384:
+		return pool16384.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_POOL_32768:
+		return pool32768.IsBasePointer(span, ptr);
+	case HeapPageMap::SPAN_ARENA:
+		return false;
+	}
+
+	return (char*)ptr - bigBlockHeaderSize - sizeof(markerType) == span;
+}
+
+void* NULLC::GetBasePointer(void* ptr)
+{
+	return GetBasePointer(ptr, NULL);
+}
+
+void* NULLC::GetBasePointer(void* ptr, ObjectMark *mark)
+{
+	if(nursery.Contains(ptr))
+	{
+		char *base = nursery.FindObject(ptr, false);
+
+		if(base && mark)
+		{
+			mark->word = &Nursery::ObjectMarker(base);
+			mark->bit = OBJECT_VISIBLE;
+		}
+
+		return base;
+	}
+
+	// Page or large block is found by the granule of the address
+	unsigned kind = 0;
+	char *span = heapPages.Find(ptr, kind);
+
+	if(!span)
+		return NULL;
+
+	switch(kind)
+	{
+	case HeapPageMap::SPAN_POOL_8:
+		return pool8.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_16:
+		return pool16.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_32:
+		return pool32.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_64:
+		return pool64.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_128:
+		return pool128.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_256:
+		return pool256.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_512:
+		return pool512.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_1024:
+		return pool1024.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_2048:
+		return pool2048.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_4096:
+		return pool4096.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_8192:
+		return pool8192.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_16384:
+		return pool16384.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_POOL_32768:
+		return pool32768.GetBasePointer(span, ptr, mark);
+	case HeapPageMap::SPAN_ARENA:
+		return NULL;
+	}
+
+	// Large blocks begin with the block header
+	if((char*)ptr < span + bigBlockHeaderSize + ((BigBlock*)span)->size)
+	{
+		// Large objects keep the mark in the object marker
+		if(mark)
+		{
+			mark->word = (markerType*)(span + bigBlockHeaderSize);
+			mark->bit = OBJECT_VISIBLE;
+		}
+
+		return span + bigBlockHeaderSize + sizeof(markerType);
+	}
+
+	return NULL;
+}
+
+void NULLC::CollectUnmarkedBlock(BigBlock *block)
+{
+	markerType &marker = *(markerType*)((char*)block + bigBlockHeaderSize);
+
+	if(!(marker & NULLC::OBJECT_VISIBLE))
+	{
+		if((marker & NULLC::OBJECT_FINALIZABLE) && !(marker & NULLC::OBJECT_FINALIZED))
+		{
+			blocksToFinalize.push_back(block);
+		}
+		else
+		{
+			blocksToFree.push_back(block);
+		}
+	}
+}
+
+void NULLC::SetCollectMemory(bool enabled)
+{
+	collectionEnabled = enabled;
+}
+
+void NULLC::CollectMemory()
+{
+	CollectMemoryImpl(false, 0.0);
+}
+
+void NULLC::CompactMemory()
+{
+	// Objects can't be moved while host code might have pointers to them
+	if(scriptRunDepth != 1 || nullcGetCurrentExecutor(NULL) == NULLC_LLVM)
+	{
+		CollectMemoryImpl(false, 0.0);
+		return;
+	}
+
+	CollectMemoryImpl(false, compactionOccupancy > 0.0 ? compactionOccupancy : 0.5);
+}
+
+void NULLC::CollectMemoryImpl(bool evacuate, double compaction)
+{
+	if(!collectionEnabled)
+		return;
+
+	double time = (double(clock()) / CLOCKS_PER_SEC);
+
+	assert(!(evacuate && incrementalMarking));
+
+	double pauseStart = GetPreciseTime();
+
+	NULLCCollectionInfo info;
+
+	info.startTime = pauseStart - statisticsStart;
+	info.bytesBefore = UsedMemoryLong();
+
+	collectionObjectsFreed = 0;
+	collectionObjectsMoved = 0;
+
+	// Roots of the incremental marking were checked when it was started
+	if(!incrementalMarking)
+		collectionRootsStart = GC::RootsScanned();
+
+	collectionMode = evacuate ? COLLECT_EVACUATE : COLLECT_FULL;
+	evacuationSlots.clear();
+
+	// Pointers to objects that were reached by incremental marking were checked without recording their locations
+	compactionActive = compaction > 0.0 && !incrementalMarking;
+	compactionSlots.clear();
+
+	if(incrementalMarking)
+	{
+		// Marking was started earlier, objects modified since then and program roots have to be checked again
+		FinishIncrementalMarking();
+	}
+	else
+	{
+		// All memory blocks are marked with 0
+		MarkMemory(0);
+
+		// Pages are selected using the free block count of the last collection, pool of the smallest objects has no space for a forwarding pointer
+		if(compactionActive)
+		{
+			pool16.SelectEvacuationPages(compaction);
+			pool32.SelectEvacuationPages(compaction);
+			pool64.SelectEvacuationPages(compaction);
+			pool128.SelectEvacuationPages(compaction);
+			pool256.SelectEvacuationPages(compaction);
+			pool512.SelectEvacuationPages(compaction);
+			pool1024.SelectEvacuationPages(compaction);
+			pool2048.SelectEvacuationPages(compaction);
+			pool4096.SelectEvacuationPages(compaction);
+			pool8192.SelectEvacuationPages(compaction);
+			pool16384.SelectEvacuationPages(compaction);
+			pool32768.SelectEvacuationPages(compaction);
+		}
+
+		// Used memory blocks are marked with 1
+		GC::MarkUsedBlocks();
+	}
+
+	// Values of weak tables are marked when their keys are reachable, after that the references to unreachable objects are cleared
+	MarkWeakTables();
+	ClearWeakReferences();
+
+	// Collect sets of objects to finalize and to potentially free
+	CollectUnmarked();
+
+	if(heapProfiler)
+		ProfileSurvivors();
+
+	markTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+	time = (double(clock()) / CLOCKS_PER_SEC);
+
+	double markEnd = GetPreciseTime();
+
+	info.markTime = markEnd - pauseStart;
+
+	// Ressurect objects and register finalizers
+	FinalizePending();
+
+	double finalizeEnd = GetPreciseTime();
+
+	// Remembered objects that are about to be freed are removed, all young objects are moved out of the nursery by the evacuation
+	for(unsigned i = 0; i < rememberedSet.size(); i++)
+	{
+		markerType &marker = *(markerType*)(rememberedSet[i] - sizeof(markerType));
+
+		ObjectMark mark;
+		GetBasePointer(rememberedSet[i], &mark);
+
+		if(evacuate || !(*mark.word & mark.bit))
+		{
+			marker &= ~OBJECT_REMEMBERED;
+
+			rememberedSet[i--] = rememberedSet.back();
+			rememberedSet.pop_back();
+		}
+	}
+
+	if(compactionActive)
+		CompactHeap();
+
+	if(evacuate)
+		EvacuateNursery(true);
+
+	// Evacuated pages are kept until the nursery evacuation finds the moved locations of pointers to young objects
+	if(compactionActive)
+		ReleaseEvacuatedPages();
+
+	compactionActive = false;
+
+	collectionMode = COLLECT_FULL;
+
+	// Free memory that remains unreachable
+	FreePending();
+
+	collectTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+
+	double sweepEnd = GetPreciseTime();
+
+	info.sweepTime = sweepEnd - finalizeEnd;
+	info.bytesAfter = UsedMemoryLong();
+	// Blocks that were left by moved objects are counted as freed by the sweep and by the release of evacuated pages
+	info.objectsFreed = collectionObjectsFreed - collectionObjectsMoved;
+	info.objectsMoved = collectionObjectsMoved;
+	info.rootsScanned = GC::RootsScanned() - collectionRootsStart;
+
+	collectableMinimum = NextCollectionThreshold();
+
+	collectionCount++;
+
+	if(heapProfiler && heapProfileReportFunction)
+		heapProfileReportFunction(heapProfileReportContext, HeapProfileReport());
+
+	if(!deferredFinalizers)
+		RunFinalizers(0);
+
+	double pauseEnd = GetPreciseTime();
+
+	info.finalizeTime = (finalizeEnd - markEnd) + (pauseEnd - sweepEnd);
+	info.pauseTime = pauseEnd - pauseStart;
+
+	RecordCollection(info);
+}
+
+void NULLC::TraceObject(char *base)
+{
+	markerType marker = *(markerType*)(base - sizeof(markerType));
+
+	ExternTypeInfo &typeInfo = NULLC::linker->exTypes[(unsigned)marker >> 8];
+
+	if(marker & NULLC::OBJECT_ARRAY)
+	{
+		unsigned arrayPadding = typeInfo.defaultAlign > 4 ? typeInfo.defaultAlign : 4;
+
+		unsigned count = *(unsigned*)(base + arrayPadding - 4);
+
+		GC::CheckArrayElements(base + arrayPadding, count, typeInfo);
+	}
+	else
+	{
+		GC::CheckVariable(base, typeInfo);
+	}
+}
+
+unsigned NULLC::GetTimeMicroseconds()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return unsigned(count.QuadPart * 1000000ll / freq.QuadPart);
+#elif defined(__linux)
+	timespec x;
+	clock_gettime(CLOCK_MONOTONIC, &x);
+
+	return unsigned(x.tv_sec * 1000000ll + x.tv_nsec / 1000);
+#else
+	return unsigned(clock() * 1000000ll / CLOCKS_PER_SEC);
+#endif
+}
+
+double NULLC::GetPreciseTime()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return double(count.QuadPart) / double(freq.QuadPart);
+#elif defined(__linux)
+	timespec x;
+	clock_gettime(CLOCK_MONOTONIC, &x);
+
+	return double(x.tv_sec) + double(x.tv_nsec) / 1000000000.0;
+#else
+	return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+void NULLC::RecordPause(double pause)
+{
+	gcStatistics.totalPauseTime += pause;
+
+	if(pause > gcStatistics.maxPauseTime)
+		gcStatistics.maxPauseTime = pause;
+
+	unsigned bucket = 0;
+
+	for(double limit = 32.0 / 1000000.0; bucket + 1 < NULLC_GC_PAUSE_BUCKETS && pause >= limit; limit *= 2.0)
+		bucket++;
+
+	gcStatistics.pauseHistogram[bucket]++;
+}
+
+void NULLC::RecordCollection(NULLCCollectionInfo &info)
+{
+	collectionHistory[collectionHistoryCount % NULLC_GC_HISTORY_SIZE] = info;
+	collectionHistoryCount++;
+
+	gcStatistics.collections++;
+
+	RecordPause(info.pauseTime);
+}
+
+void NULLC::StartIncrementalMarking()
+{
+	double time = (double(clock()) / CLOCKS_PER_SEC);
+
+	double pauseStart = GetPreciseTime();
+
+	collectionRootsStart = GC::RootsScanned();
+
+	// All memory blocks are marked with 0
+	MarkMemory(0);
+
+	// Objects referenced by program roots are marked, the objects they reference are checked by the following slices
+	GC::MarkRoots();
+
+	incrementalMarking = true;
+	markingAllocated = 0;
+
+	UpdateWriteBarrierState();
+
+	markTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+
+	gcStatistics.markingSlices++;
+
+	RecordPause(GetPreciseTime() - pauseStart);
+}
+
+void NULLC::MarkIncrementalSlice()
+{
+	double time = (double(clock()) / CLOCKS_PER_SEC);
+
+	double pauseStart = GetPreciseTime();
+
+	unsigned start = GetTimeMicroseconds();
+
+	bool complete = false;
+
+	do
+	{
+		// Objects that were modified after being marked are checked again
+		for(unsigned i = 0; i < 16 && !rememberedSet.empty(); i++)
+		{
+			char *base = rememberedSet.back();
+			rememberedSet.pop_back();
+
+			*(markerType*)(base - sizeof(markerType)) &= ~OBJECT_REMEMBERED;
+
+			TraceObject(base);
+		}
+
+		complete = GC::MarkPendingRootsStep(64) && rememberedSet.empty();
+	}
+	while(!complete && GetTimeMicroseconds() - start < markingSliceBudget);
+
+	markTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+
+	gcStatistics.markingSlices++;
+
+	RecordPause(GetPreciseTime() - pauseStart);
+
+	if(complete)
+		CollectMemoryImpl(false, 0.0);
+}
+
+void NULLC::FinishIncrementalMarking()
+{
+	do
+	{
+		for(unsigned i = 0; i < rememberedSet.size(); i++)
+		{
+			*(markerType*)(rememberedSet[i] - sizeof(markerType)) &= ~OBJECT_REMEMBERED;
+
+			TraceObject(rememberedSet[i]);
+		}
+
+		rememberedSet.clear();
+
+		GC::MarkPendingRoots();
+	}
+	while(!rememberedSet.empty());
+
+	// Program roots are modified without a write barrier
+	GC::MarkUsedBlocks();
+
+	incrementalMarking = false;
+
+	UpdateWriteBarrierState();
+}
+
+void NULLC::CollectNursery()
+{
+	double time = (double(clock()) / CLOCKS_PER_SEC);
+
+	double pauseStart = GetPreciseTime();
+
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
+
+		if(chunk.state != Nursery::CHUNK_YOUNG)
+			continue;
+
+		for(unsigned offset = 0; offset < chunk.top;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			Nursery::ObjectMarker(base) &= ~(OBJECT_VISIBLE | OBJECT_PINNED);
+
+			offset += Nursery::ObjectSize(Nursery::ObjectHeader(base));
+		}
+	}
+
+	collectionMode = COLLECT_MINOR;
+	evacuationSlots.clear();
+
+	// Only young objects are marked, starting from program roots
+	GC::MarkUsedBlocks();
+
+	// And from old objects that were modified since the last collection
+	for(unsigned i = 0; i < rememberedSet.size(); i++)
+	{
+		char *base = rememberedSet[i];
+
+		*(markerType*)(base - sizeof(markerType)) &= ~OBJECT_REMEMBERED;
+
+		TraceObject(base);
+	}
+
+	rememberedSet.clear();
+
+	// Old objects are not checked, so all weak table values are kept
+	MarkWeakTableValues();
+
+	GC::MarkPendingRoots();
+
+	ClearWeakReferences();
+
+	EvacuateNursery(false);
+
+	collectionMode = COLLECT_FULL;
+
+	collectTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+
+	gcStatistics.minorCollections++;
+
+	RecordPause(GetPreciseTime() - pauseStart);
+}
+
+void NULLC::EvacuateNursery(bool includeRetained)
+{
+	// Copy reachable objects into block pools, leaving a pointer to the new location in place of the object data
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
+
+		if(!(chunk.state == Nursery::CHUNK_YOUNG || (includeRetained && chunk.state == Nursery::CHUNK_RETAINED)))
+			continue;
+
+		for(unsigned offset = 0; offset < chunk.top;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			unsigned &header = Nursery::ObjectHeader(base);
+			markerType &marker = Nursery::ObjectMarker(base);
+
+			offset += Nursery::ObjectSize(header);
+
+			if((marker & (OBJECT_VISIBLE | OBJECT_FREED)) != OBJECT_VISIBLE || (marker & (OBJECT_PINNED | OBJECT_HASHED)))
+				continue;
+
+			uintptr_t realSize = 0;
+			char *block = (char*)AllocPoolBlock(header, realSize, false);
+
+			memcpy(block, &marker, header);
+
+			*(markerType*)block &= ~OBJECT_REMEMBERED;
+
+			usedMemory += realSize;
+
+			WriteVmMemoryPointer(base, block + sizeof(markerType));
+
+			header |= Nursery::OBJECT_FORWARDED;
+		}
+	}
+
+	// Update pointers to moved objects, pointers that are located in moved objects are updated at the new location
+	for(unsigned i = 0; i < evacuationSlots.size(); i++)
+	{
+		char *slot = evacuationSlots[i];
+
+		// Old object with the pointer could have been moved by the compaction
+		if(char *moved = ForwardedPointer(slot))
+			slot = moved;
+
+		if(char *slotBase = nursery.FindObject(slot, false))
+		{
+			if(Nursery::ObjectHeader(slotBase) & Nursery::OBJECT_FORWARDED)
+				slot = (char*)ReadVmMemoryPointer(slotBase) + (slot - slotBase);
+		}
+
+		char *target = (char*)ReadVmMemoryPointer(slot);
+
+		if(char *targetBase = nursery.FindObject(target, false))
+		{
+			if(Nursery::ObjectHeader(targetBase) & Nursery::OBJECT_FORWARDED)
+				WriteVmMemoryPointer(slot, (char*)ReadVmMemoryPointer(targetBase) + (target - targetBase));
+		}
+	}
+
+	evacuationSlots.clear();
+
+	UpdateWeakReferences();
+
+	// Chunks without pinned objects are reused, the rest become a part of the old generation
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
+
+		if(!(chunk.state == Nursery::CHUNK_YOUNG || (includeRetained && chunk.state == Nursery::CHUNK_RETAINED)))
+			continue;
+
+		bool hasPinned = false;
+
+		for(unsigned offset = 0; offset < chunk.top && !hasPinned;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			unsigned header = Nursery::ObjectHeader(base);
+
+			if(!(header & Nursery::OBJECT_FORWARDED) && (Nursery::ObjectMarker(base) & (OBJECT_VISIBLE | OBJECT_FREED)) == OBJECT_VISIBLE)
+				hasPinned = true;
+
+			offset += Nursery::ObjectSize(header & ~Nursery::OBJECT_FORWARDED);
+		}
+
+		if(!hasPinned)
+		{
+			usedMemory -= chunk.retainedBytes;
+
+			nursery.ReleaseChunk(i);
+			continue;
+		}
+
+		for(unsigned offset = 0; offset < chunk.top;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			unsigned &header = Nursery::ObjectHeader(base);
+			markerType &marker = Nursery::ObjectMarker(base);
+
+			bool forwarded = (header & Nursery::OBJECT_FORWARDED) != 0;
+
+			header &= ~Nursery::OBJECT_FORWARDED;
+
+			unsigned size = Nursery::ObjectSize(header);
+
+			offset += size;
+
+			if(marker & OBJECT_FREED)
+				continue;
+
+			if(!forwarded && (marker & OBJECT_VISIBLE))
+			{
+				if(chunk.state == Nursery::CHUNK_YOUNG)
+				{
+					chunk.retainedBytes += size;
+					usedMemory += size;
+				}
+
+				marker &= ~OBJECT_PINNED;
+			}
+			else
+			{
+				if(chunk.state == Nursery::CHUNK_RETAINED)
+				{
+					chunk.retainedBytes -= size;
+					usedMemory -= size;
+				}
+
+				marker = OBJECT_FREED;
+			}
+		}
+
+		chunk.state = Nursery::CHUNK_RETAINED;
+	}
+
+	nursery.currentChunk = ~0u;
+	nursery.youngBytes = 0;
+}
+
+void NULLC::FreeNurseryObjects()
+{
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
+
+		if(chunk.state == Nursery::CHUNK_FREE)
+			continue;
+
+		bool hasLive = false;
+
+		for(unsigned offset = 0; offset < chunk.top;)
+		{
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			markerType &marker = Nursery::ObjectMarker(base);
+
+			unsigned size = Nursery::ObjectSize(Nursery::ObjectHeader(base));
+
+			offset += size;
+
+			if(marker & OBJECT_FREED)
+				continue;
+
+			if(marker & OBJECT_VISIBLE)
+			{
+				hasLive = true;
+				continue;
+			}
+
+			// Unreachable young objects are dropped by the next minor collection, but they must not be traced through stale pointers
+			if(chunk.state == Nursery::CHUNK_RETAINED)
+			{
+				chunk.retainedBytes -= size;
+				usedMemory -= size;
+			}
+
+			marker = OBJECT_FREED;
+
+			collectionObjectsFreed++;
+		}
+
+		if(!hasLive && chunk.state == Nursery::CHUNK_RETAINED)
+		{
+			usedMemory -= chunk.retainedBytes;
+
+			nursery.ReleaseChunk(i);
+		}
+	}
+}
+
+void* NULLC::GetTracedBasePointer(void* ptr, void* location, ObjectMark &mark)
+{
+	char *base = NULL;
+
+	if(collectionMode == COLLECT_MINOR)
+	{
+		base = nursery.FindObject(ptr, true);
+
+		if(base)
+		{
+			mark.word = &Nursery::ObjectMarker(base);
+			mark.bit = OBJECT_VISIBLE;
+		}
+	}
+	else
+	{
+		base = (char*)GetBasePointer(ptr, &mark);
+
+		// Only typed locations are checked, values found on the stack might be left-over pointers
+		if(!base && arenaEscapeCheck && location)
+			CheckArenaEscape(ptr);
+
+		if(base && compactionActive && IsEvacuating(base))
+		{
+			// Pointers from memory without type information can't be updated
+			if(location)
+				compactionSlots.push_back((char*)location);
+			else
+				*(markerType*)(base - sizeof(markerType)) |= OBJECT_PINNED;
+		}
+	}
+
+	if(base && collectionMode != COLLECT_FULL && nursery.Contains(base))
+	{
+		// Pointers from memory without type information can't be updated
+		if(location)
+			evacuationSlots.push_back((char*)location);
+		else
+			Nursery::ObjectMarker(base) |= OBJECT_PINNED;
+	}
+
+	return base;
+}
+
+bool NULLC::IsMovingCollection()
+{
+	return collectionMode != COLLECT_FULL || compactionActive || snapshotTracing;
+}
+
+bool NULLC::IsEvacuating(void* ptr)
+{
+	unsigned kind = 0;
+	char *span = heapPages.Find(ptr, kind);
+
+	// Page flags are placed at the start of every block pool page
+	return span && kind <= HeapPageMap::SPAN_POOL_32768 && (*(unsigned char*)span & PAGE_EVACUATING) != 0;
+}
+
+// New location of a pointer into an object that was moved by the compaction
+char* NULLC::ForwardedPointer(char* ptr)
+{
+	if(!compactionActive || !IsEvacuating(ptr))
+		return NULL;
+
+	ObjectMark mark;
+	char *base = (char*)GetBasePointer(ptr, &mark);
+
+	// Objects that stayed in place are still marked
+	if(!base || (*mark.word & mark.bit))
+		return NULL;
+
+	return (char*)ReadVmMemoryPointer(base) + (ptr - base);
+}
+
+void NULLC::CompactHeap()
+{
+	collectionObjectsMoved += pool16.Evacuate(usedMemory);
+	collectionObjectsMoved += pool32.Evacuate(usedMemory);
+	collectionObjectsMoved += pool64.Evacuate(usedMemory);
+	collectionObjectsMoved += pool128.Evacuate(usedMemory);
+	collectionObjectsMoved += pool256.Evacuate(usedMemory);
+	collectionObjectsMoved += pool512.Evacuate(usedMemory);
+	collectionObjectsMoved += pool1024.Evacuate(usedMemory);
+	collectionObjectsMoved += pool2048.Evacuate(usedMemory);
+	collectionObjectsMoved += pool4096.Evacuate(usedMemory);
+	collectionObjectsMoved += pool8192.Evacuate(usedMemory);
+	collectionObjectsMoved += pool16384.Evacuate(usedMemory);
+	collectionObjectsMoved += pool32768.Evacuate(usedMemory);
+
+	// Update pointers to moved objects, pointers that are located in moved objects are updated at the new location
+	for(unsigned i = 0; i < compactionSlots.size(); i++)
+	{
+		char *slot = compactionSlots[i];
+
+		if(char *moved = ForwardedPointer(slot))
+			slot = moved;
+
+		if(char *moved = ForwardedPointer((char*)ReadVmMemoryPointer(slot)))
+			WriteVmMemoryPointer(slot, moved);
+	}
+
+	compactionSlots.clear();
+
+	UpdateWeakReferences();
+
+	// Moved objects keep the remembered flag
+	for(unsigned i = 0; i < rememberedSet.size(); i++)
+	{
+		if(char *moved = ForwardedPointer(rememberedSet[i]))
+			rememberedSet[i] = moved;
+	}
+}
+
+void NULLC::ReleaseEvacuatedPages()
+{
+	collectionObjectsFreed += pool16.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool32.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool64.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool128.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool256.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool512.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool1024.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool2048.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool4096.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool8192.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool16384.ReleaseEvacuatedPages(usedMemory);
+	collectionObjectsFreed += pool32768.ReleaseEvacuatedPages(usedMemory);
+}
+
+void NULLC::WriteBarrier(void* address)
+{
+	if(!writeBarrierActive)
+		return;
+
+	if(!arenas.empty())
+	{
+		unsigned kind = 0;
+		char *span = heapPages.Find(address, kind);
+
+		if(span && kind == HeapPageMap::SPAN_ARENA)
+		{
+			if(MemoryArena::Chunk *chunk = MemoryArena::FindChunk(span, address))
+				MemoryArena::MarkCard(chunk, address);
+
+			return;
+		}
+	}
+
+	// Nothing to remember when there are no young objects and marking is not in progress
+	if(!nursery.youngBytes && !incrementalMarking)
+		return;
+
+	NULLCRef ref = { 0, (char*)address };
+
+	if(GC::IsPointerUnmanaged(ref))
+		return;
+
+	char *base = NULL;
+
+	if(incrementalMarking)
+	{
+		ObjectMark mark;
+		base = (char*)GetBasePointer(address, &mark);
+
+		// Objects that are not marked yet will be checked completely when they are reached
+		if(!base || !(*mark.word & mark.bit))
+			return;
+	}
+	else
+	{
+		// Young objects are always traced by minor collections
+		if(nursery.FindObject(address, true))
+			return;
+
+		base = (char*)GetBasePointer(address);
+
+		if(!base)
+			return;
+	}
+
+	markerType &marker = *(markerType*)(base - sizeof(markerType));
+
+	if(marker & (OBJECT_REMEMBERED | OBJECT_FREED))
+		return;
+
+	marker |= OBJECT_REMEMBERED;
+
+	rememberedSet.push_back(base);
+}
+
+void NULLC::SetNurserySize(unsigned int size)
+{
+	const unsigned maxNurserySize = 256 * 1024 * 1024;
+
+	nurserySize = size < maxNurserySize ? size : maxNurserySize;
+
+	// Change is applied when the heap is cleared if there are objects in the nursery
+	if(nursery.IsEmpty())
+		nursery.Init(nurserySize);
+
+	UpdateWriteBarrierState();
+}
+
+void NULLC::SetHeapCompaction(double occupancy)
+{
+	compactionOccupancy = occupancy < 0.0 ? 0.0 : (occupancy > 1.0 ? 1.0 : occupancy);
+}
+
+void NULLC::SetMarkingSliceBudget(unsigned int microseconds)
+{
+	markingSliceBudget = microseconds;
+}
+
+void NULLC::SetMarkerThreads(unsigned int count)
+{
+	GC::SetMarkerThreads(count);
+}
+
+MemoryArena* NULLC::FindArena(unsigned id)
+{
+	for(unsigned i = 0; i < arenas.size(); i++)
+	{
+		if(arenas[i]->id == id)
+			return arenas[i];
+	}
+
+	return NULL;
+}
+
+void NULLC::CheckArenaEscape(void* ptr)
+{
+	unsigned kind = 0;
+	char *span = heapPages.Find(ptr, kind);
+
+	if(!span || kind != HeapPageMap::SPAN_ARENA)
+		return;
+
+	if(MemoryArena::Chunk *chunk = MemoryArena::FindChunk(span, ptr))
+	{
+		if(chunk->arena->released)
+			GC::AtomicIncrement(&arenaEscapes);
+	}
+}
+
+unsigned NULLC::MarkArenaRoots()
+{
+	unsigned objects = 0;
+
+	for(unsigned i = 0; i < arenas.size(); i++)
+	{
+		if(arenas[i]->released)
+			continue;
+
+		for(MemoryArena::Chunk *chunk = arenas[i]->chunks; chunk; chunk = chunk->next)
+		{
+			if(!chunk->dirty)
+				continue;
+
+			char *start = (char*)chunk + MemoryArena::chunkHeaderSize;
+
+			for(uintptr_t offset = 0; offset < chunk->top;)
+			{
+				char *base = start + offset + MemoryArena::headerSize;
+
+				uintptr_t end = offset + MemoryArena::ObjectSize(MemoryArena::ObjectHeader(base));
+
+				if(MemoryArena::HasMarkedCard(chunk, offset, end))
+				{
+					TraceObject(base);
+
+					objects++;
+				}
+
+				offset = end;
+			}
+		}
+	}
+
+	return objects;
+}
+
+unsigned NULLC::CreateArena(bool checkEscapes)
+{
+	MemoryArena *arena = new(NULLC::alloc(sizeof(MemoryArena))) MemoryArena(arenaNextId++, checkEscapes);
+
+	arenas.push_back(arena);
+
+	// Pointer stores into arena objects are tracked by the write barrier
+	UpdateWriteBarrierState();
+
+	return arena->id;
+}
+
+void NULLC::EnterArena(unsigned id)
+{
+	MemoryArena *arena = FindArena(id);
+
+	if(!arena)
+	{
+		nullcThrowError("ERROR: arena has been released");
+		return;
+	}
+
+	arenaScopes.push_back(arena);
+}
+
+void NULLC::LeaveArena()
+{
+	if(arenaScopes.empty())
+	{
+		nullcThrowError("ERROR: there is no active arena");
+		return;
+	}
+
+	arenaScopes.pop_back();
+}
+
+void NULLC::ReleaseArena(unsigned id)
+{
+	MemoryArena *arena = FindArena(id);
+
+	if(!arena)
+	{
+		nullcThrowError("ERROR: arena has been released");
+		return;
+	}
+
+	for(unsigned i = 0; i < arenaScopes.size(); i++)
+	{
+		if(arenaScopes[i] == arena)
+		{
+			nullcThrowError("ERROR: arena is still active");
+			return;
+		}
+	}
+
+	unsigned escapes = 0;
+
+	// Full collection finds the pointers to arena memory that can still be reached by the program
+	if(arena->checkEscapes && collectionEnabled)
+	{
+		// Objects that were already marked by incremental marking are not checked again
+		if(incrementalMarking)
+			CollectMemoryImpl(false, 0.0);
+
+		arena->released = true;
+
+		arenaEscapeCheck = true;
+		arenaEscapes = 0;
+
+		CollectMemoryImpl(false, 0.0);
+
+		arenaEscapeCheck = false;
+		escapes = unsigned(arenaEscapes);
+	}
+
+	for(unsigned i = 0; i < arenas.size(); i++)
+	{
+		if(arenas[i] == arena)
+		{
+			arenas[i] = arenas.back();
+			arenas.pop_back();
+			break;
+		}
+	}
+
+	arenaMemory -= arena->usedBytes;
+
+	NULLC::destruct(arena);
+
+	UpdateWriteBarrierState();
+
+	if(escapes)
+		nullcThrowError("ERROR: %u pointer(s) to the memory of a released arena are still reachable", escapes);
+}
+
+long long NULLC::ArenaSize(unsigned id)
+{
+	MemoryArena *arena = FindArena(id);
+
+	if(!arena)
+	{
+		nullcThrowError("ERROR: arena has been released");
+		return 0;
+	}
+
+	return arena->usedBytes;
+}
+
+void NULLC::SetDeferredFinalizers(bool enable)
+{
+	deferredFinalizers = enable;
+}
+
+unsigned NULLC::RunFinalizers(unsigned microseconds)
+{
+	// Objects that are found by a collection started from a finalizer are left to the loop that is already running
+	if(finalizersRunning)
+		return 0;
+
+	finalizersRunning = true;
+
+	unsigned start = GetTimeMicroseconds();
+
+	unsigned count = 0;
+
+	while(finalizeListStart < finalizeList.size())
+	{
+		unsigned batch = finalizeList.size() - finalizeListStart;
+
+		if(batch > finalizerBatchSize)
+			batch = finalizerBatchSize;
+
+		finalizeBatch.clear();
+		finalizeBatch.push_back(finalizeList.data + finalizeListStart, batch);
+
+		finalizeListStart += batch;
+
+		(void)nullcRunFunction("__finalizeObjects");
+
+		count += batch;
+
+		if(microseconds && GetTimeMicroseconds() - start >= microseconds)
+			break;
+	}
+
+	finalizeBatch.clear();
+
+	// Queue is compacted when most of it was already taken
+	if(finalizeListStart == finalizeList.size())
+	{
+		finalizeList.clear();
+		finalizeListStart = 0;
+	}
+	else if(finalizeListStart > finalizeList.size() / 2)
+	{
+		unsigned remaining = finalizeList.size() - finalizeListStart;
+
+		memmove(finalizeList.data, finalizeList.data + finalizeListStart, remaining * sizeof(NULLCRef));
+
+		finalizeList.shrink(remaining);
+		finalizeListStart = 0;
+	}
+
+	gcStatistics.finalizersRun += count;
+
+	finalizersRunning = false;
+
+	return count;
+}
+
+unsigned NULLC::PendingFinalizers()
+{
+	return finalizeList.size() - finalizeListStart;
+}
+
+unsigned NULLC::MarkFinalizerRoots()
+{
+	unsigned count = (finalizeList.size() - finalizeListStart) + finalizeBatch.size();
+
+	if(!count)
+		return 0;
+
+	ExternTypeInfo *autoRefType = FindAutoRefType();
+
+	if(!autoRefType)
+		return 0;
+
+	for(unsigned i = finalizeListStart; i < finalizeList.size(); i++)
+		GC::CheckVariable((char*)&finalizeList[i], *autoRefType);
+
+	// Objects of the batch that is being finalized can't be freed by a collection that is started from a finalizer
+	for(unsigned i = 0; i < finalizeBatch.size(); i++)
+		GC::CheckVariable((char*)&finalizeBatch[i], *autoRefType);
+
+	return count;
+}
+
+// Size of the object storage, it is the same as the size of the allocation that will be placed into the same size class
+uintptr_t NULLC::ObjectCapacity(char *base)
+{
+	if(nursery.Contains(base))
+		return (Nursery::ObjectHeader(base) & ~Nursery::OBJECT_FORWARDED) - sizeof(markerType);
+
+	unsigned kind = 0;
+	char *span = heapPages.Find(base, kind);
+
+	if(!span || kind == HeapPageMap::SPAN_ARENA)
+		return 0;
+
+	if(kind == HeapPageMap::SPAN_BIG_BLOCK)
+		return ((BigBlock*)span)->size - sizeof(markerType);
+
+	return poolSizeClasses[kind - HeapPageMap::SPAN_POOL_8] - sizeof(markerType);
+}
+
+void NULLC::RecordSnapshotSlot(char *location)
+{
+	snapshotSlots.push_back(location);
+}
+
+namespace
+{
+	// Heap snapshot region 0 is the global variable storage, objects follow it
+	struct SnapshotRelocation
+	{
+		unsigned	locationRegion;
+		unsigned	locationOffset;
+
+		unsigned	targetRegion;
+		unsigned	targetOffset;
+	};
+
+	struct SnapshotObject
+	{
+		unsigned	type;
+		unsigned	array;
+		unsigned	capacity;
+	};
+}
+
+unsigned NULLC::SaveHeapSnapshot(char *globals, unsigned globalSize, char **data, const char **error)
+{
+	*data = NULL;
+
+	if(scriptRunDepth)
+	{
+		*error = "ERROR: snapshot can't be taken while the script is running";
+		return 0;
+	}
+
+	if(!arenas.empty())
+	{
+		*error = "ERROR: objects in memory arenas can't be saved";
+		return 0;
+	}
+
+	for(unsigned i = 0; i < weakSlots.size(); i++)
+	{
+		if(weakSlots[i].target)
+		{
+			*error = "ERROR: weak references can't be saved";
+			return 0;
+		}
+	}
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		if(weakTables[i])
+		{
+			*error = "ERROR: weak references can't be saved";
+			return 0;
+		}
+	}
+
+	// Unreachable objects are finalized before the heap is traced
+	CollectMemory();
+
+	if(incrementalMarking || PendingFinalizers())
+	{
+		*error = "ERROR: heap has objects waiting for a collection to complete";
+		return 0;
+	}
+
+	snapshotSlots.clear();
+
+	// Marking is performed by a single thread that records all pointer locations
+	snapshotTracing = true;
+	GC::SetSnapshotRecorder(RecordSnapshotSlot);
+
+	MarkMemory(0);
+	GC::MarkUsedBlocks();
+
+	GC::SetSnapshotRecorder(NULL);
+	snapshotTracing = false;
+
+	PointerIndex objectIndex;
+	FastVector<char*> objects;
+
+	// Objects are saved if they are referenced from a recorded location
+	for(unsigned i = 0; i < snapshotSlots.size(); i++)
+	{
+		char *target = (char*)ReadVmMemoryPointer(snapshotSlots[i]);
+
+		if(target <= (char*)0x00010000 || (target >= globals && target <= globals + globalSize))
+			continue;
+
+		char *base = (char*)GetBasePointer(target);
+
+		// Values that don't point to the heap are ignored in the same way as they are by the collector
+		if(!base || objectIndex.Find(base))
+			continue;
+
+		if(*(markerType*)(base - sizeof(markerType)) & OBJECT_HASHED)
+		{
+			*error = "ERROR: objects with address-based hash values can't be saved";
+			return 0;
+		}
+
+		objectIndex.Insert(base, objects.size());
+		objects.push_back(base);
+	}
+
+	FastVector<SnapshotRelocation> relocations;
+
+	for(unsigned i = 0; i < snapshotSlots.size(); i++)
+	{
+		char *location = snapshotSlots[i];
+		char *target = (char*)ReadVmMemoryPointer(location);
+
+		if(target <= (char*)0x00010000)
+			continue;
+
+		SnapshotRelocation relocation;
+
+		// Locations in objects that were only referenced from the stack are not saved
+		if(location >= globals && location < globals + globalSize)
+		{
+			relocation.locationRegion = 0;
+			relocation.locationOffset = unsigned(location - globals);
+		}
+		else if(char *base = (char*)GetBasePointer(location))
+		{
+			unsigned *index = objectIndex.Find(base);
+
+			if(!index)
+				continue;
+
+			relocation.locationRegion = *index + 1;
+			relocation.locationOffset = unsigned(location - base);
+		}
+		else
+		{
+			continue;
+		}
+
+		if(target >= globals && target <= globals + globalSize)
+		{
+			relocation.targetRegion = 0;
+			relocation.targetOffset = unsigned(target - globals);
+		}
+		else
+		{
+			char *base = (char*)GetBasePointer(target);
+			unsigned *index = base ? objectIndex.Find(base) : NULL;
+
+			if(!index)
+				continue;
+
+			relocation.targetRegion = *index + 1;
+			relocation.targetOffset = unsigned(target - base);
+		}
+
+		relocations.push_back(relocation);
+	}
+
+	snapshotSlots.clear();
+
+	unsigned size = 2 * sizeof(unsigned) + relocations.size() * sizeof(SnapshotRelocation);
+
+	for(unsigned i = 0; i < objects.size(); i++)
+		size += sizeof(SnapshotObject) + unsigned(ObjectCapacity(objects[i]));
+
+	char *pos = *data = new char[size];
+
+	unsigned counts[2] = { objects.size(), relocations.size() };
+
+	memcpy(pos, counts, sizeof(counts));
+	pos += sizeof(counts);
+
+	for(unsigned i = 0; i < objects.size(); i++)
+	{
+		markerType marker = *(markerType*)(objects[i] - sizeof(markerType));
+
+		SnapshotObject object;
+
+		object.type = unsigned(marker >> 8);
+		object.array = (marker & OBJECT_ARRAY) != 0;
+		object.capacity = unsigned(ObjectCapacity(objects[i]));
+
+		memcpy(pos, &object, sizeof(object));
+		pos += sizeof(object);
+
+		memcpy(pos, objects[i], object.capacity);
+		pos += object.capacity;
+	}
+
+	if(!relocations.empty())
+		memcpy(pos, relocations.data, relocations.size() * sizeof(SnapshotRelocation));
+
+	return size;
+}
+
+bool NULLC::CheckHeapSnapshot(unsigned globalSize, const char *data, unsigned size)
+{
+	const char *pos = data;
+	const char *end = data + size;
+
+	unsigned counts[2];
+
+	if(unsigned(end - pos) < sizeof(counts))
+		return false;
+
+	memcpy(counts, pos, sizeof(counts));
+	pos += sizeof(counts);
+
+	FastVector<unsigned> capacities;
+
+	for(unsigned i = 0; i < counts[0]; i++)
+	{
+		SnapshotObject object;
+
+		if(unsigned(end - pos) < sizeof(object))
+			return false;
+
+		memcpy(&object, pos, sizeof(object));
+		pos += sizeof(object);
+
+		if(object.type >= linker->exTypes.size() || unsigned(end - pos) < object.capacity)
+			return false;
+
+		pos += object.capacity;
+
+		capacities.push_back(object.capacity);
+	}
+
+	if((unsigned long long)(end - pos) != counts[1] * (unsigned long long)sizeof(SnapshotRelocation))
+		return false;
+
+	for(unsigned i = 0; i < counts[1]; i++)
+	{
+		SnapshotRelocation relocation;
+
+		memcpy(&relocation, pos, sizeof(relocation));
+		pos += sizeof(relocation);
+
+		if(relocation.locationRegion > capacities.size() || relocation.targetRegion > capacities.size())
+			return false;
+
+		unsigned locationSize = relocation.locationRegion ? capacities[relocation.locationRegion - 1] : globalSize;
+		unsigned targetSize = relocation.targetRegion ? capacities[relocation.targetRegion - 1] : globalSize;
+
+		if(locationSize < sizeof(void*) || relocation.locationOffset > locationSize - sizeof(void*) || relocation.targetOffset > targetSize)
+			return false;
+	}
+
+	return true;
+}
+
+bool NULLC::LoadHeapSnapshot(char *globals, unsigned globalSize, const char *data, unsigned size, const char **error)
+{
+	(void)size;
+
+	// Layout was checked by CheckHeapSnapshot, only object allocation can fail
+	assert(CheckHeapSnapshot(globalSize, data, size));
+
+	const char *pos = data;
+
+	unsigned counts[2];
+
+	memcpy(counts, pos, sizeof(counts));
+	pos += sizeof(counts);
+
+	FastVector<char*> objects;
+
+	// Objects are only reachable after the pointers are restored
+	bool enabled = collectionEnabled;
+	collectionEnabled = false;
+
+	for(unsigned i = 0; i < counts[0]; i++)
+	{
+		SnapshotObject object;
+
+		memcpy(&object, pos, sizeof(object));
+		pos += sizeof(object);
+
+		char *base = (char*)AllocObjectImpl(object.capacity, object.type, object.array != 0, false);
+
+		if(!base)
+		{
+			collectionEnabled = enabled;
+
+			*error = "ERROR: failed to allocate memory for the heap snapshot";
+			return false;
+		}
+
+		memcpy(base, pos, object.capacity);
+		pos += object.capacity;
+
+		objects.push_back(base);
+	}
+
+	collectionEnabled = enabled;
+
+	for(unsigned i = 0; i < counts[1]; i++)
+	{
+		SnapshotRelocation relocation;
+
+		memcpy(&relocation, pos, sizeof(relocation));
+		pos += sizeof(relocation);
+
+		char *location = relocation.locationRegion ? objects[relocation.locationRegion - 1] : globals;
+		char *target = relocation.targetRegion ? objects[relocation.targetRegion - 1] : globals;
+
+		WriteVmMemoryPointer(location + relocation.locationOffset, target + relocation.targetOffset);
+	}
+
+	*error = NULL;
+
+	return true;
+}
+
+long long NULLC::WeakRefCreate(NULLCRef target)
+{
+	if(!target.ptr)
+		return 0;
+
+	if(!weakSlotIndexValid)
+	{
+		weakSlotIndex.Clear();
+
+		for(unsigned i = 0; i < weakSlots.size(); i++)
+		{
+			if(weakSlots[i].target)
+				weakSlotIndex.Insert(weakSlots[i].target, i);
+		}
+
+		weakSlotIndexValid = true;
+	}
+
+	unsigned index = 0;
+
+	if(unsigned *position = weakSlotIndex.Find(target.ptr))
+	{
+		index = *position;
+	}
+	else
+	{
+		if(!weakFreeSlots.empty())
+		{
+			index = weakFreeSlots.back();
+			weakFreeSlots.pop_back();
+		}
+		else
+		{
+			index = weakSlots.size();
+
+			WeakSlot slot;
+
+			slot.target = NULL;
+			slot.type = 0;
+			slot.generation = 0;
+
+			weakSlots.push_back(slot);
+		}
+
+		weakSlots[index].target = target.ptr;
+		weakSlots[index].type = target.typeID;
+
+		weakSlotIndex.Insert(target.ptr, index);
+	}
+
+	return ((long long)weakSlots[index].generation << 32) | (index + 1);
+}
+
+NULLCRef NULLC::WeakRefGet(long long handle)
+{
+	NULLCRef result;
+
+	result.typeID = 0;
+	result.ptr = NULL;
+
+	unsigned index = unsigned(handle & 0xffffffff);
+	unsigned generation = unsigned(handle >> 32);
+
+	if(index == 0 || index > weakSlots.size())
+		return result;
+
+	WeakSlot &slot = weakSlots[index - 1];
+
+	// Slot could have been reused after the target was freed
+	if(slot.generation != generation || !slot.target)
+		return result;
+
+	result.typeID = slot.type;
+	result.ptr = slot.target;
+
+	return result;
+}
+
+WeakTable* NULLC::FindWeakTable(int id)
+{
+	if(id <= 0 || unsigned(id) > weakTables.size() || !weakTables[id - 1])
+	{
+		nullcThrowError("ERROR: weak table has been released");
+		return NULL;
+	}
+
+	return weakTables[id - 1];
+}
+
+int NULLC::WeakTableCreate(void* owner)
+{
+	unsigned index = 0;
+
+	if(!weakFreeTables.empty())
+	{
+		index = weakFreeTables.back();
+		weakFreeTables.pop_back();
+	}
+	else
+	{
+		index = weakTables.size();
+
+		weakTables.push_back(NULL);
+	}
+
+	weakTables[index] = new(NULLC::alloc(sizeof(WeakTable))) WeakTable(index + 1, (char*)owner);
+
+	return int(index + 1);
+}
+
+NULLCRef NULLC::WeakTableFind(int id, NULLCRef key)
+{
+	NULLCRef result;
+
+	result.typeID = 0;
+	result.ptr = NULL;
+
+	WeakTable *table = FindWeakTable(id);
+
+	if(!table || !key.ptr)
+		return result;
+
+	if(WeakTable::Entry *entry = table->Find(key.ptr))
+		result = entry->value;
+
+	return result;
+}
+
+void NULLC::WeakTableSet(int id, NULLCRef key, NULLCRef value)
+{
+	WeakTable *table = FindWeakTable(id);
+
+	if(!table)
+		return;
+
+	if(!key.ptr)
+	{
+		nullcThrowError("ERROR: weak table key is null");
+		return;
+	}
+
+	table->Set(key.ptr, value);
+}
+
+void NULLC::WeakTableRemove(int id, NULLCRef key)
+{
+	WeakTable *table = FindWeakTable(id);
+
+	if(!table || !key.ptr)
+		return;
+
+	if(WeakTable::Entry *entry = table->Find(key.ptr))
+		table->RemoveAt(unsigned(entry - table->entries.data));
+}
+
+int NULLC::WeakTableSize(int id)
+{
+	WeakTable *table = FindWeakTable(id);
+
+	return table ? int(table->entries.size()) : 0;
+}
+
+void NULLC::WeakTableClear(int id)
+{
+	WeakTable *table = FindWeakTable(id);
+
+	if(!table)
+		return;
+
+	table->entries.clear();
+	table->index.Clear();
+	table->indexValid = true;
+}
+
+// Memory that is not managed by the collector is never freed by it
+bool NULLC::IsWeakTargetReachable(char* ptr)
+{
+	// Old objects are not checked by minor collections
+	if(collectionMode == COLLECT_MINOR)
+	{
+		char *base = nursery.FindObject(ptr, true);
+
+		return !base || (Nursery::ObjectMarker(base) & OBJECT_VISIBLE) != 0;
+	}
+
+	ObjectMark mark;
+
+	if(!GetBasePointer(ptr, &mark))
+		return true;
+
+	return (*mark.word & mark.bit) != 0;
+}
+
+// New location of a pointer into an object that was moved by the nursery evacuation or by the compaction
+char* NULLC::MovedPointer(char* ptr)
+{
+	if(char *moved = ForwardedPointer(ptr))
+		return moved;
+
+	if(char *base = nursery.FindObject(ptr, false))
+	{
+		if(Nursery::ObjectHeader(base) & Nursery::OBJECT_FORWARDED)
+			return (char*)ReadVmMemoryPointer(base) + (ptr - base);
+	}
+
+	return ptr;
+}
+
+// Weak table values are traced as 'auto ref' variables
+ExternTypeInfo* NULLC::FindAutoRefType()
+{
+	unsigned autoRefHash = GetStringHash("auto ref");
+
+	for(unsigned i = 0; i < linker->exTypes.size(); i++)
+	{
+		if(linker->exTypes[i].nameHash == autoRefHash)
+			return &linker->exTypes[i];
+	}
+
+	return NULL;
+}
+
+void NULLC::MarkWeakTables()
+{
+	if(weakTables.empty())
+		return;
+
+	ExternTypeInfo *autoRefType = FindAutoRefType();
+
+	if(!autoRefType)
+		return;
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		if(WeakTable *table = weakTables[i])
+		{
+			for(unsigned k = 0; k < table->entries.size(); k++)
+				table->entries[k].traced = false;
+		}
+	}
+
+	// Marked values can make more keys and tables reachable
+	bool progress = true;
+
+	while(progress)
+	{
+		progress = false;
+
+		for(unsigned i = 0; i < weakTables.size(); i++)
+		{
+			WeakTable *table = weakTables[i];
+
+			if(!table || !IsWeakTargetReachable(table->owner))
+				continue;
+
+			for(unsigned k = 0; k < table->entries.size(); k++)
+			{
+				WeakTable::Entry &entry = table->entries[k];
+
+				if(entry.traced || !IsWeakTargetReachable(entry.key))
+					continue;
+
+				entry.traced = true;
+
+				GC::CheckVariable((char*)&entry.value, *autoRefType);
+
+				progress = true;
+			}
+		}
+
+		GC::MarkPendingRoots();
+	}
+}
+
+void NULLC::MarkWeakTableValues()
+{
+	if(weakTables.empty())
+		return;
+
+	ExternTypeInfo *autoRefType = FindAutoRefType();
+
+	if(!autoRefType)
+		return;
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		if(WeakTable *table = weakTables[i])
+		{
+			for(unsigned k = 0; k < table->entries.size(); k++)
+				GC::CheckVariable((char*)&table->entries[k].value, *autoRefType);
+		}
+	}
+}
+
+void NULLC::ClearWeakReferences()
+{
+	for(unsigned i = 0; i < weakSlots.size(); i++)
+	{
+		WeakSlot &slot = weakSlots[i];
+
+		if(!slot.target || IsWeakTargetReachable(slot.target))
+			continue;
+
+		slot.target = NULL;
+		slot.type = 0;
+		slot.generation++;
+
+		weakFreeSlots.push_back(i);
+
+		weakSlotIndexValid = false;
+	}
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		WeakTable *table = weakTables[i];
+
+		if(!table)
+			continue;
+
+		// Table is released together with its owner object
+		if(!IsWeakTargetReachable(table->owner))
+		{
+			NULLC::destruct(table);
+
+			weakTables[i] = NULL;
+			weakFreeTables.push_back(i);
+			continue;
+		}
+
+		for(unsigned k = 0; k < table->entries.size(); k++)
+		{
+			if(!IsWeakTargetReachable(table->entries[k].key))
+				table->RemoveAt(k--);
+		}
+	}
+}
+
+void NULLC::UpdateWeakReferences()
+{
+	for(unsigned i = 0; i < weakSlots.size(); i++)
+	{
+		WeakSlot &slot = weakSlots[i];
+
+		if(!slot.target)
+			continue;
+
+		char *moved = MovedPointer(slot.target);
+
+		if(moved != slot.target)
+		{
+			slot.target = moved;
+
+			weakSlotIndexValid = false;
+		}
+	}
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		WeakTable *table = weakTables[i];
+
+		if(!table)
+			continue;
+
+		table->owner = MovedPointer(table->owner);
+
+		for(unsigned k = 0; k < table->entries.size(); k++)
+		{
+			WeakTable::Entry &entry = table->entries[k];
+
+			char *moved = MovedPointer(entry.key);
+
+			if(moved != entry.key)
+			{
+				entry.key = moved;
+
+				table->indexValid = false;
+			}
+		}
+	}
+}
+
+void NULLC::DestroyWeakReferences()
+{
+	weakSlots.clear();
+	weakFreeSlots.clear();
+
+	weakSlotIndex.Clear();
+	weakSlotIndexValid = true;
+
+	for(unsigned i = 0; i < weakTables.size(); i++)
+	{
+		if(weakTables[i])
+			NULLC::destruct(weakTables[i]);
+	}
+
+	weakTables.clear();
+	weakFreeTables.clear();
+}
+
+void NULLC::EnterScriptRun()
+{
+	scriptRunDepth++;
+
+	scriptRunArenaScopes.push_back(arenaScopes.size());
+}
+
+void NULLC::LeaveScriptRun(bool success)
+{
+	assert(scriptRunDepth);
+
+	scriptRunDepth--;
+
+	unsigned scopes = scriptRunArenaScopes.back();
+	scriptRunArenaScopes.pop_back();
+
+	// Script code that was stopped by an error didn't reach the end of its arena scopes
+	if(!success)
+		arenaScopes.shrink(scopes < arenaScopes.size() ? scopes : arenaScopes.size());
+}
+
+double NULLC::MarkTime()
+{
+	return markTime;
+}
+
+double NULLC::CollectTime()
+{
+	return collectTime;
+}
 
-				Range range(ptr, (char*)ptr + size + 4);
-				bigBlocks.insert(range);
+unsigned int NULLC::Collections()
+{
+	return collectionCount;
+}
 
-				realSize = *(int*)ptr = size;
-				data = (char*)ptr + 4;
-			}
-		}
-	}
-	usedMemory += realSize;
+double NULLC::CollectionsPerSecond()
+{
+	double elapsed = GetPreciseTime() - collectionCountStart;
 
-	if(data == NULL)
+	return elapsed > 0.0 ? collectionCount / elapsed : 0.0;
+}
+
+int NULLC::LastCollection(NULLCCollectionInfo* info)
+{
+	if(!info)
 	{
-		nullcThrowError("ERROR: allocation failed");
-		return NULL;
+		nullcThrowError("ERROR: null pointer access");
+		return 0;
 	}
-	int finalize = 0;
-	if(type && (linker->exTypes[type].typeFlags & ExternTypeInfo::TYPE_HAS_FINALIZER))
-		finalize = (int)OBJECT_FINALIZABLE;
 
-	memset(data, 0, size);
-	*(markerType*)data = finalize | (type << 8);
-	return (char*)data + sizeof(markerType);
+	if(!collectionHistoryCount)
+		return 0;
+
+	*info = collectionHistory[(collectionHistoryCount - 1) % NULLC_GC_HISTORY_SIZE];
+
+	return 1;
 }
 
-unsigned int NULLC::UsedMemory()
+long long NULLC::PauseHistogram(int bucket)
 {
-	return usedMemory;
+	if(unsigned(bucket) >= NULLC_GC_PAUSE_BUCKETS)
+	{
+		nullcThrowError("ERROR: pause histogram bucket %d is out of range [0, %d)", bucket, NULLC_GC_PAUSE_BUCKETS);
+		return 0;
+	}
+
+	return gcStatistics.pauseHistogram[bucket];
 }
 
-NULLCArray NULLC::AllocArray(unsigned size, unsigned count, unsigned type)
+double NULLC::MaxPauseTime()
 {
-	NULLCArray ret;
-
-	ret.len = 0;
-	ret.ptr = NULL;
+	return gcStatistics.maxPauseTime;
+}
 
-	if((unsigned long long)size * count > globalMemoryLimit)
-	{
-		nullcThrowError("ERROR: can't allocate array with %u elements of size %u", count, size);
-		return ret;
-	}
+double NULLC::TotalPauseTime()
+{
+	return gcStatistics.totalPauseTime;
+}
 
-	ExternTypeInfo &typeInfo = NULLC::linker->exTypes[type];
+void NULLC::GetGCStatistics(NULLCGCStatistics &stats)
+{
+	stats = gcStatistics;
 
-	unsigned arrayPadding = typeInfo.defaultAlign > 4 ? typeInfo.defaultAlign : 4;
+	stats.finalizersPending = PendingFinalizers();
+}
 
-	unsigned bytes = count * size;
-	
-	if(bytes == 0)
-		bytes += 4;
+unsigned NULLC::GetCollectionHistory(NULLCCollectionInfo *history, unsigned count)
+{
+	unsigned available = collectionHistoryCount < NULLC_GC_HISTORY_SIZE ? collectionHistoryCount : NULLC_GC_HISTORY_SIZE;
 
-	char *ptr = (char*)AllocObject(bytes + arrayPadding, type);
+	if(count > available)
+		count = available;
 
-	if(!ptr)
-		return ret;
+	// Most recent collection is first
+	for(unsigned i = 0; i < count; i++)
+		history[i] = collectionHistory[(collectionHistoryCount - 1 - i) % NULLC_GC_HISTORY_SIZE];
 
-	ret.len = count;
-	ret.ptr = arrayPadding + ptr;
+	return count;
+}
 
-	((unsigned*)ret.ptr)[-1] = count;
+void NULLC::ResetGCStatistics()
+{
+	memset(&gcStatistics, 0, sizeof(gcStatistics));
 
-	markerType *marker = (markerType*)(ptr - sizeof(markerType));
-	*marker |= OBJECT_ARRAY;
+	collectionHistoryCount = 0;
 
-	return ret;
+	statisticsStart = GetPreciseTime();
 }
 
-void NULLC::MarkBlock(Range& curr)
+void NULLC::SetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap)
 {
-	markerType *marker = (markerType*)((char*)curr.start + 4);
-	*marker = (*marker & ~NULLC::OBJECT_VISIBLE) | currentMark;
+	gcGrowthFactor = growthFactor < 1.0 ? 1.0 : growthFactor;
+	gcMinimumHeap = minimumHeap < uintptr_t(-1) ? uintptr_t(minimumHeap) : uintptr_t(-1);
+	gcMaximumHeap = maximumHeap < uintptr_t(-1) ? uintptr_t(maximumHeap) : uintptr_t(-1);
+
+	collectableMinimum = NextCollectionThreshold();
 }
 
-void NULLC::MarkMemory(unsigned int number)
+uintptr_t NULLC::NextCollectionThreshold()
 {
-	assert(number <= 1);
+	double threshold = double(usedMemory) * gcGrowthFactor;
 
-	currentMark = number;
+	if(gcMaximumHeap && threshold > double(gcMaximumHeap))
+		threshold = double(gcMaximumHeap);
 
-	bigBlocks.for_each(MarkBlock);
+	if(threshold < double(gcMinimumHeap))
+		threshold = double(gcMinimumHeap);
 
-	pool8.Mark(number);
-	pool16.Mark(number);
-	pool32.Mark(number);
-	pool64.Mark(number);
-	pool128.Mark(number);
-	pool256.Mark(number);
-	pool512.Mark(number);
+	if(threshold > double(globalMemoryLimit))
+		threshold = double(globalMemoryLimit);
+
+	return uintptr_t(threshold);
 }
 
-void NULLC::CollectUnmarked()
+void NULLC::SetHeapProfiler(bool enable)
 {
-	bigBlocks.for_each(CollectUnmarkedBlock);
+	heapProfiler = enable;
+}
 
-	pool8.CollectUnmarked();
-	pool16.CollectUnmarked();
-	pool32.CollectUnmarked();
-	pool64.CollectUnmarked();
-	pool128.CollectUnmarked();
-	pool256.CollectUnmarked();
-	pool512.CollectUnmarked();
+void NULLC::SetHeapProfilerReportFunction(void *context, void (*callback)(void *context, const char *report))
+{
+	heapProfileReportContext = context;
+	heapProfileReportFunction = callback;
 }
 
-void NULLC::FinalizePending()
+void NULLC::ClearHeapProfile()
 {
-	for(unsigned i = 0; i < blocksToFinalize.size(); i++)
-	{
-		Range &curr = blocksToFinalize[i];
+	// Site map is created by the first profiled allocation
+	if(heapProfileSites.size())
+		heapProfileSiteMap.clear();
+
+	heapProfileTypes.clear();
+	heapProfileSites.clear();
+	heapProfileSiteInstructions.clear();
+	heapProfileCollections.clear();
+}
 
-		void *block = curr.start;
+unsigned NULLC::CurrentAllocationSite()
+{
+	// Innermost call stack frame is the instruction that called the allocation function
+	unsigned site = 0;
 
-		markerType &marker = *(markerType*)((char*)block + 4);
+	unsigned frame = 0;
+	while(unsigned address = nullcDebugEnumStackFrame(frame++))
+		site = address;
 
-		// Mark block as used
-		marker |= NULLC::OBJECT_VISIBLE;
+	return site;
+}
 
-		ExternTypeInfo &typeInfo = NULLC::linker->exTypes[(unsigned)marker >> 8];
+void NULLC::ProfileAllocation(unsigned type, bool array, uintptr_t size)
+{
+	unsigned typeKey = type * 2 + (array ? 1 : 0);
 
-		char *base = (char*)block + 4;
+	while(typeKey >= heapProfileTypes.size())
+		memset(heapProfileTypes.push_back(), 0, sizeof(HeapProfileEntry));
 
-		if(marker & NULLC::OBJECT_ARRAY)
-		{
-			unsigned arrayPadding = typeInfo.defaultAlign > 4 ? typeInfo.defaultAlign : 4;
+	heapProfileTypes[typeKey].allocations++;
+	heapProfileTypes[typeKey].allocatedBytes += size;
 
-			unsigned count = *(unsigned*)(base + sizeof(markerType) + arrayPadding - 4);
+	unsigned site = CurrentAllocationSite();
 
-			GC::CheckArrayElements(base + sizeof(markerType) + arrayPadding, count, typeInfo);
-		}
-		else
-		{
-			GC::CheckVariable(base + sizeof(markerType), typeInfo);
-		}
+	heapProfileSiteMap.init();
+
+	unsigned *siteIndex = heapProfileSiteMap.find(site);
 
-		NULLC::FinalizeObject(marker, (char*)block + 4);
+	if(!siteIndex)
+	{
+		heapProfileSiteMap.insert(site, heapProfileSites.size());
+		siteIndex = heapProfileSiteMap.find(site);
+
+		memset(heapProfileSites.push_back(), 0, sizeof(HeapProfileEntry));
+		heapProfileSiteInstructions.push_back(site);
 	}
 
-	blocksToFinalize.clear();
+	heapProfileSites[*siteIndex].allocations++;
+	heapProfileSites[*siteIndex].allocatedBytes += size;
+}
 
-	pool8.FinalizePending();
-	pool16.FinalizePending();
-	pool32.FinalizePending();
-	pool64.FinalizePending();
-	pool128.FinalizePending();
-	pool256.FinalizePending();
-	pool512.FinalizePending();
+void NULLC::ProfileSurvivor(markerType marker, uintptr_t size)
+{
+	HeapProfileCollection &collection = heapProfileCollections.back();
 
-	// Mark new roots
-	GC::MarkPendingRoots();
+	collection.survivors++;
+	collection.survivorBytes += size;
+
+	unsigned typeKey = unsigned(marker >> 8) * 2 + ((marker & OBJECT_ARRAY) ? 1 : 0);
+
+	if(typeKey < heapProfileTypes.size())
+	{
+		heapProfileTypes[typeKey].survivors++;
+		heapProfileTypes[typeKey].survivorBytes += size;
+	}
 }
 
-void NULLC::FreePending()
+void NULLC::ProfileSurvivors()
 {
-	for(unsigned i = 0; i < blocksToFree.size(); i++)
+	HeapProfileCollection &collection = *heapProfileCollections.push_back();
+
+	collection.survivors = 0;
+	collection.survivorBytes = 0;
+
+	for(unsigned i = 0; i < heapProfileTypes.size(); i++)
+	{
+		heapProfileTypes[i].survivors = 0;
+		heapProfileTypes[i].survivorBytes = 0;
+	}
+
+	for(BigBlock *curr = bigBlocks; curr; curr = curr->next)
 	{
-		Range &curr = blocksToFree[i];
+		markerType marker = *(markerType*)((char*)curr + bigBlockHeaderSize);
 
-		void *block = curr.start;
+		if(marker & OBJECT_VISIBLE)
+			ProfileSurvivor(marker, curr->size);
+	}
 
-		markerType &marker = *(markerType*)((char*)block + 4);
+	pool8.ProfileSurvivors();
+	pool16.ProfileSurvivors();
+	pool32.ProfileSurvivors();
+	pool64.ProfileSurvivors();
+	pool128.ProfileSurvivors();
+	pool256.ProfileSurvivors();
+	pool512.ProfileSurvivors();
+	pool1024.ProfileSurvivors();
+	pool2048.ProfileSurvivors();
+	pool4096.ProfileSurvivors();
+	pool8192.ProfileSurvivors();
+	pool16384.ProfileSurvivors();
+	pool32768.ProfileSurvivors();
+
+	for(unsigned i = 0; i < nursery.chunkCount; i++)
+	{
+		Nursery::Chunk &chunk = nursery.chunks[i];
 
-		// Check flags again, finalizers might have some objects reachable
-		if(!(marker & (NULLC::OBJECT_VISIBLE | NULLC::OBJECT_FREED)))
+		for(unsigned offset = 0; offset < chunk.top;)
 		{
-			unsigned size = *(unsigned int*)block;
+			char *base = nursery.ChunkStart(i) + offset + Nursery::headerSize;
+
+			markerType marker = Nursery::ObjectMarker(base);
 
-			usedMemory -= size;
+			unsigned size = Nursery::ObjectSize(Nursery::ObjectHeader(base));
 
-			NULLC::alignedDealloc(block);
+			offset += size;
 
-			bigBlocks.erase(curr);
+			if((marker & (OBJECT_VISIBLE | OBJECT_FREED)) == OBJECT_VISIBLE)
+				ProfileSurvivor(marker, size);
 		}
 	}
-
-	blocksToFree.clear();
-
-	pool8.FreePending(usedMemory);
-	pool16.FreePending(usedMemory);
-	pool32.FreePending(usedMemory);
-	pool64.FreePending(usedMemory);
-	pool128.FreePending(usedMemory);
-	pool256.FreePending(usedMemory);
-	pool512.FreePending(usedMemory);
 }
 
-bool NULLC::IsBasePointer(void* ptr)
+namespace
 {
-	// Search in range of every pool
-	if(pool8.IsBasePointer(ptr))
-		return true;
-	if(pool16.IsBasePointer(ptr))
-		return true;
-	if(pool32.IsBasePointer(ptr))
-		return true;
-	if(pool64.IsBasePointer(ptr))
-		return true;
-	if(pool128.IsBasePointer(ptr))
-		return true;
-	if(pool256.IsBasePointer(ptr))
-		return true;
-	if(pool512.IsBasePointer(ptr))
-		return true;
+	FastVector<NULLC::HeapProfileEntry> *heapProfileSortTarget = NULL;
 
-	// Search in global pool
-	if(BigBlockIterator it = bigBlocks.find(Range(ptr, ptr)))
+	int SortByAllocatedBytes(const void* a, const void* b)
 	{
-		void *block = it->key.start;
+		NULLC::HeapProfileEntry &lhs = (*heapProfileSortTarget)[*(unsigned*)a];
+		NULLC::HeapProfileEntry &rhs = (*heapProfileSortTarget)[*(unsigned*)b];
 
-		if((char*)ptr - 4 - sizeof(markerType) == block)
-			return true;
-	}
+		if(lhs.allocatedBytes != rhs.allocatedBytes)
+			return lhs.allocatedBytes > rhs.allocatedBytes ? -1 : 1;
 
-	return false;
-}
+		return *(unsigned*)a < *(unsigned*)b ? -1 : 1;
+	}
 
-void* NULLC::GetBasePointer(void* ptr)
-{
-	// Search in range of every pool
-	if(void *base = pool8.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool16.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool32.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool64.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool128.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool256.GetBasePointer(ptr))
-		return base;
-	if(void *base = pool512.GetBasePointer(ptr))
-		return base;
+	void ReportPrintf(FastVector<char> &report, const char *format, ...) NULLC_PRINT_FORMAT_CHECK(2, 3);
 
-	// Search in global pool
-	if(BigBlockIterator it = bigBlocks.find(Range(ptr, ptr)))
+	void ReportPrintf(FastVector<char> &report, const char *format, ...)
 	{
-		void *block = it->key.start;
+		char buf[1024];
+
+		va_list args;
+		va_start(args, format);
+
+		vsnprintf(buf, 1024, format, args);
+		buf[1023] = '\0';
 
-		if(ptr >= block && ptr <= (char*)block + *(unsigned int*)block)
-			return (char*)block + 4 + sizeof(markerType);
+		va_end(args);
+
+		report.push_back(buf, unsigned(strlen(buf)));
 	}
 
-	return NULL;
+	void SortEntries(FastVector<NULLC::HeapProfileEntry> &entries, FastVector<unsigned> &order)
+	{
+		heapProfileSortTarget = &entries;
+
+		qsort(order.data, order.size(), sizeof(unsigned), SortByAllocatedBytes);
+
+		heapProfileSortTarget = NULL;
+	}
 }
 
-void NULLC::CollectUnmarkedBlock(Range& curr)
+const char* NULLC::HeapProfileReport()
 {
-	void *block = curr.start;
+	heapProfileReport.clear();
 
-	markerType &marker = *(markerType*)((char*)block + 4);
+	ReportPrintf(heapProfileReport, "Heap profile: %u collections, %lld bytes in use\n", collectionCount, UsedMemoryLong());
 
-	if(!(marker & NULLC::OBJECT_VISIBLE))
+	// Recent collections
+	const unsigned collectionLimit = 16;
+
+	unsigned firstCollection = heapProfileCollections.size() > collectionLimit ? heapProfileCollections.size() - collectionLimit : 0;
+
+	if(heapProfileCollections.size())
+		ReportPrintf(heapProfileReport, "\nSurvivors by collection:\n");
+
+	for(unsigned i = firstCollection; i < heapProfileCollections.size(); i++)
+		ReportPrintf(heapProfileReport, "  #%u: %llu objects, %llu bytes\n", i + 1, heapProfileCollections[i].survivors, heapProfileCollections[i].survivorBytes);
+
+	FastVector<unsigned> order;
+
+	for(unsigned i = 0; i < heapProfileTypes.size(); i++)
 	{
-		if((marker & NULLC::OBJECT_FINALIZABLE) && !(marker & NULLC::OBJECT_FINALIZED))
-		{
-			blocksToFinalize.push_back(curr);
-		}
-		else
-		{
-			blocksToFree.push_back(curr);
-		}
+		if(heapProfileTypes[i].allocations || heapProfileTypes[i].survivors)
+			order.push_back(i);
 	}
-}
 
-void NULLC::SetCollectMemory(bool enabled)
-{
-	collectionEnabled = enabled;
-}
+	SortEntries(heapProfileTypes, order);
 
-void NULLC::CollectMemory()
-{
-	if(!collectionEnabled)
-		return;
+	ReportPrintf(heapProfileReport, "\nTypes:\n%12s %14s %12s %14s  %s\n", "allocations", "requested", "survivors", "retained", "type");
 
-	double time = (double(clock()) / CLOCKS_PER_SEC);
+	for(unsigned i = 0; i < order.size(); i++)
+	{
+		HeapProfileEntry &entry = heapProfileTypes[order[i]];
 
-	// All memory blocks are marked with 0
-	MarkMemory(0);
+		ExternTypeInfo &typeInfo = linker->exTypes[order[i] / 2];
 
-	// Used memory blocks are marked with 1
-	GC::MarkUsedBlocks();
+		ReportPrintf(heapProfileReport, "%12llu %14llu %12llu %14llu  %s%s\n", entry.allocations, entry.allocatedBytes, entry.survivors, entry.survivorBytes, &linker->exSymbols[typeInfo.offsetToName], (order[i] & 1) ? "[]" : "");
+	}
 
-	// Collect sets of objects to finalize and to potentially free
-	CollectUnmarked();
+	order.clear();
 
-	markTime += (double(clock()) / CLOCKS_PER_SEC) - time;
-	time = (double(clock()) / CLOCKS_PER_SEC);
+	for(unsigned i = 0; i < heapProfileSites.size(); i++)
+		order.push_back(i);
 
-	// Ressurect objects and register finalizers
-	FinalizePending();
+	SortEntries(heapProfileSites, order);
 
-	// Free memory that remains unreachable
-	FreePending();
+	ReportPrintf(heapProfileReport, "\nAllocation sites:\n%12s %14s  %s\n", "allocations", "requested", "location");
 
-	collectTime += (double(clock()) / CLOCKS_PER_SEC) - time;
+	for(unsigned i = 0; i < order.size(); i++)
+	{
+		HeapProfileEntry &entry = heapProfileSites[order[i]];
 
-	if(usedMemory + (usedMemory >> 1) >= collectableMinimum)
-		collectableMinimum <<= 1;
+		unsigned instruction = heapProfileSiteInstructions[order[i]];
 
-	(void)nullcRunFunction("__finalizeObjects");
-	finalizeList.clear();
-}
+		const char *location = instruction ? nullcDebugGetVmAddressLocation(instruction, 0) : NULL;
 
-double NULLC::MarkTime()
-{
-	return markTime;
-}
+		ReportPrintf(heapProfileReport, "%12llu %14llu  %s\n", entry.allocations, entry.allocatedBytes, location ? location : "[host]");
+	}
 
-double NULLC::CollectTime()
-{
-	return collectTime;
+	heapProfileReport.push_back(0);
+
+	return heapProfileReport.data;
 }
 
 void NULLC::FinalizeMemory()
 {
+	// Incomplete marking is abandoned
+	if(incrementalMarking)
+	{
+		for(unsigned i = 0; i < rememberedSet.size(); i++)
+			*(markerType*)(rememberedSet[i] - sizeof(markerType)) &= ~OBJECT_REMEMBERED;
+
+		rememberedSet.clear();
+
+		GC::ResetGC();
+
+		incrementalMarking = false;
+
+		UpdateWriteBarrierState();
+	}
+
 	MarkMemory(0);
 
 	CollectUnmarked();
 	FinalizePending();
 
-	(void)nullcRunFunction("__finalizeObjects");
-	finalizeList.clear();
-}
-
-void NULLC::ClearBlock(Range& curr)
-{
-	NULLC::alignedDealloc(curr.start);
+	// Deferred finalizers are run as well
+	RunFinalizers(0);
 }
 
 void NULLC::ClearMemory()
@@ -800,6 +4551,14 @@ void NULLC::ClearMemory()
 
 	usedMemory = 0;
 
+	// Collection threshold raised by the live set of the previous program starts over
+	collectableMinimum = NextCollectionThreshold();
+
+	collectionCount = 0;
+	collectionCountStart = GetPreciseTime();
+
+	ResetGCStatistics();
+
 	pool8.Reset();
 	pool16.Reset();
 	pool32.Reset();
@@ -807,34 +4566,116 @@ void NULLC::ClearMemory()
 	pool128.Reset();
 	pool256.Reset();
 	pool512.Reset();
+	pool1024.Reset();
+	pool2048.Reset();
+	pool4096.Reset();
+	pool8192.Reset();
+	pool16384.Reset();
+	pool32768.Reset();
+
+	while(bigBlocks)
+		FreeBigBlock(bigBlocks);
+
+	for(unsigned i = 0; i < arenas.size(); i++)
+		NULLC::destruct(arenas[i]);
+
+	arenas.clear();
+	arenaScopes.clear();
+	arenaMemory = 0;
+
+	DestroyWeakReferences();
 
-	bigBlocks.for_each(ClearBlock);
-	bigBlocks.clear();
+	heapPages.Clear();
 
 	blocksToFinalize.clear();
 	blocksToFree.clear();
 
 	finalizeList.clear();
+	finalizeListStart = 0;
+	finalizeBatch.clear();
+
+	nursery.Init(nurserySize);
+
+	rememberedSet.clear();
+	evacuationSlots.clear();
+
+	if(incrementalMarking)
+	{
+		GC::ResetGC();
+
+		incrementalMarking = false;
+	}
+
+	UpdateWriteBarrierState();
+
+	// Type indices and instructions of the profile belong to the previous program
+	ClearHeapProfile();
 }
 
 void NULLC::ResetMemory()
 {
 	ClearMemory();
 
-	bigBlocks.reset();
+	heapPages.Reset();
 
 	blocksToFinalize.reset();
 	blocksToFree.reset();
 
 	finalizeList.reset();
+	finalizeBatch.reset();
+
+	deferredFinalizers = false;
+
+	nurserySize = 0;
+	nursery.Reset();
+
+	UpdateWriteBarrierState();
+
+	markingSliceBudget = 0;
+
+	gcGrowthFactor = 2.0;
+	gcMinimumHeap = 1024 * 1024;
+	gcMaximumHeap = 0;
+
+	GC::SetMarkerThreads(1);
+
+	rememberedSet.reset();
+	evacuationSlots.reset();
+	compactionSlots.reset();
+	snapshotSlots.reset();
+
+	compactionOccupancy = 0.0;
+
+	arenas.reset();
+	arenaScopes.reset();
+	scriptRunArenaScopes.reset();
+	arenaNextId = 1;
+
+	weakSlots.reset();
+	weakFreeSlots.reset();
+	weakSlotIndex.Reset();
+	weakTables.reset();
+	weakFreeTables.reset();
+
+	heapProfiler = false;
+
+	heapProfileTypes.reset();
+	heapProfileSites.reset();
+	heapProfileSiteInstructions.reset();
+	heapProfileSiteMap.reset();
+	heapProfileCollections.reset();
+	heapProfileReport.reset();
+
+	heapProfileReportContext = NULL;
+	heapProfileReportFunction = NULL;
 
 	GC::ResetGC();
 }
 
-void NULLC::SetGlobalLimit(unsigned int limit)
+void NULLC::SetGlobalLimit(unsigned long long limit)
 {
-	globalMemoryLimit = limit;
-	collectableMinimum = limit < 1024 * 1024 ? limit : 1024 * 1024;
+	globalMemoryLimit = limit < uintptr_t(-1) ? uintptr_t(limit) : uintptr_t(-1);
+	collectableMinimum = globalMemoryLimit < gcMinimumHeap ? globalMemoryLimit : gcMinimumHeap;
 }
 
 void NULLC::Assert(int val)
@@ -868,10 +4709,12 @@ void NULLC::CopyArray(NULLCAutoArray* dst, NULLCAutoArray src)
 	}
 	dst->typeID = src.typeID;
 	dst->len = src.len;
-	dst->ptr = (char*)NULLC::AllocObject(src.len * linker->exTypes[src.typeID].size, src.typeID);
+	dst->ptr = (char*)NULLC::AllocObjectImpl(uintptr_t(src.len) * linker->exTypes[src.typeID].size, src.typeID, false, false);
+
+	if(src.len && dst->ptr)
+		memcpy(dst->ptr, src.ptr, uintptr_t(src.len) * linker->exTypes[src.typeID].size);
 
-	if(src.len)
-		memcpy(dst->ptr, src.ptr, unsigned(src.len * linker->exTypes[src.typeID].size));
+	WriteBarrier(dst->ptr);
 }
 
 NULLCRef NULLC::ReplaceObject(NULLCRef l, NULLCRef r)
@@ -882,6 +4725,7 @@ NULLCRef NULLC::ReplaceObject(NULLCRef l, NULLCRef r)
 		return l;
 	}
 	memcpy(l.ptr, r.ptr, linker->exTypes[r.typeID].size);
+	WriteBarrier(l.ptr);
 	return l;
 }
 
@@ -900,6 +4744,9 @@ void NULLC::SwapObjects(NULLCRef l, NULLCRef r)
 	memcpy(tmp, l.ptr, size);
 	memcpy(l.ptr, r.ptr, size);
 	memcpy(r.ptr, tmp, size);
+
+	WriteBarrier(l.ptr);
+	WriteBarrier(r.ptr);
 }
 
 int NULLC::CompareObjects(NULLCRef l, NULLCRef r)
@@ -920,6 +4767,7 @@ void NULLC::AssignObject(NULLCRef l, NULLCRef r)
 		return;
 	}
 	memcpy(l.ptr, &r.ptr, linker->exTypes[l.typeID].size);
+	WriteBarrier(l.ptr);
 }
 
 int NULLC::StrEqual(NULLCArray a, NULLCArray b)
@@ -959,7 +4807,9 @@ NULLCArray NULLC::StrConcatenate(NULLCArray a, NULLCArray b)
 
 NULLCArray NULLC::StrConcatenateAndSet(NULLCArray *a, NULLCArray b)
 {
-	return *a = StrConcatenate(*a, b);
+	*a = StrConcatenate(*a, b);
+	WriteBarrier(a);
+	return *a;
 }
 
 int NULLC::Char(char a)
@@ -1299,6 +5149,12 @@ int NULLC::RefGECompare(NULLCRef a, NULLCRef b)
 
 int NULLC::RefHash(NULLCRef a)
 {
+	// Hash is based on the object address, so it can't be moved by the collector
+	if(char *base = nursery.FindObject(a.ptr, false))
+		Nursery::ObjectMarker(base) |= OBJECT_HASHED;
+	else if(char *base = (char*)GetBasePointer(a.ptr))
+		*(markerType*)(base - sizeof(markerType)) |= OBJECT_HASHED;
+
 	long long value = (long long)(intptr_t)(a.ptr);
 	return (int)((value >> 32) ^ value);
 }
@@ -1336,6 +5192,7 @@ NULLCAutoArray* NULLC::AutoArrayAssign(NULLCAutoArray* left, NULLCRef right)
 	if(right.typeID == NULLC_TYPE_AUTO_ARRAY)
 	{
 		*left = *(NULLCAutoArray*)right.ptr;
+		WriteBarrier(left);
 		return left;
 	}
 	if(!nullcIsArray(right.typeID))
@@ -1354,6 +5211,7 @@ NULLCAutoArray* NULLC::AutoArrayAssign(NULLCAutoArray* left, NULLCRef right)
 		left->ptr = right.ptr;
 	}
 	left->typeID = nullcGetSubType(right.typeID);
+	WriteBarrier(left);
 
 	return left;
 }
@@ -1370,6 +5228,7 @@ NULLCRef NULLC::AutoArrayAssignRev(NULLCRef left, NULLCAutoArray *right)
 	if(left.typeID == NULLC_TYPE_AUTO_ARRAY)
 	{
 		*(NULLCAutoArray*)left.ptr = *right;
+		WriteBarrier(left.ptr);
 		return ret;
 	}
 	if(!nullcIsArray(left.typeID))
@@ -1398,6 +5257,7 @@ NULLCRef NULLC::AutoArrayAssignRev(NULLCRef left, NULLCAutoArray *right)
 		}
 		memcpy(left.ptr, right->ptr, unsigned(leftLength * nullcGetTypeSize(right->typeID)));
 	}
+	WriteBarrier(left.ptr);
 
 	return left;
 }
@@ -1436,7 +5296,8 @@ void NULLC::AutoArray(NULLCAutoArray* arr, int type, unsigned count)
 
 	arr->typeID = type;
 	arr->len = count;
-	arr->ptr = (char*)AllocObject(count * linker->exTypes[type].size, type);
+	arr->ptr = (char*)AllocObjectImpl(uintptr_t(count) * linker->exTypes[type].size, type, false, false);
+	WriteBarrier(arr);
 }
 
 void NULLC::AutoArraySet(NULLCRef x, unsigned pos, NULLCAutoArray* arr)
@@ -1466,6 +5327,7 @@ void NULLC::AutoArraySet(NULLCRef x, unsigned pos, NULLCAutoArray* arr)
 		*arr = n;
 	}
 	memcpy(arr->ptr + elemSize * pos, x.ptr, elemSize);
+	WriteBarrier(arr->ptr);
 }
 
 void NULLC::ShrinkAutoArray(NULLCAutoArray* arr, unsigned size)
@@ -1514,8 +5376,8 @@ void NULLC::AssertCoroutine(NULLCRef f)
 NULLCArray NULLC::GetFinalizationList()
 {
 	NULLCArray arr;
-	arr.ptr = (char*)finalizeList.data;
-	arr.len = finalizeList.size();
+	arr.ptr = (char*)finalizeBatch.data;
+	arr.len = finalizeBatch.size();
 	return arr;
 }
 
@@ -1539,6 +5401,7 @@ void NULLC::ArrayCopy(NULLCAutoArray dst, NULLCAutoArray src)
 		return;
 
 	memcpy(dst.ptr, src.ptr, unsigned(nullcGetTypeSize(dst.typeID) * src.len));
+	WriteBarrier(dst.ptr);
 }
 
 void* NULLC::AssertDerivedFromBase(unsigned* derived, unsigned base)
@@ -1586,9 +5449,11 @@ void NULLC::CloseUpvalue(void **upvalueList, void *variable, int offset, int siz
 		memcpy(copy, variable, unsigned(size));
 		WriteVmMemoryPointer(&upvalue->target, copy);
 		WriteVmMemoryPointer(&upvalue->next, NULL);
+		WriteBarrier(upvalue);
 
 		upvalue = next;
 	}
 
 	WriteVmMemoryPointer(upvalueList, upvalue);
+	WriteBarrier(upvalueList);
 }
@@ -2,6 +2,8 @@
 
 #include "nullcdef.h"
 
+#include <stdint.h>
+
 class Linker;
 
 struct NULLCArray;
@@ -46,6 +48,8 @@ namespace NULLC
 	
 	void*		AllocObject(int size, unsigned type);
 	NULLCArray	AllocArray(unsigned size, unsigned count, unsigned type);
+	void*		NewObject(int size, unsigned type);
+	NULLCArray	NewArray(unsigned size, unsigned count, unsigned type);
 	NULLCRef	CopyObject(NULLCRef ptr);
 	void		CopyArray(NULLCAutoArray* dst, NULLCAutoArray src);
 	NULLCRef	ReplaceObject(NULLCRef l, NULLCRef r);
@@ -64,14 +68,98 @@ namespace NULLC
 	void		SetCollectMemory(bool enabled);
 	void		CollectMemory();
 	unsigned int	UsedMemory();
+	long long	UsedMemoryLong();
 	double		MarkTime();
 	double		CollectTime();
+	unsigned int	Collections();
+	double		CollectionsPerSecond();
+
+	// Collection statistics
+	int			LastCollection(NULLCCollectionInfo* info);
+	long long	PauseHistogram(int bucket);
+	double		MaxPauseTime();
+	double		TotalPauseTime();
+
+	void		GetGCStatistics(NULLCGCStatistics &stats);
+	unsigned	GetCollectionHistory(NULLCCollectionInfo *history, unsigned count);
+	void		ResetGCStatistics();
+
+	void		SetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap);
 
 	void		FinalizeMemory();
 	void		ClearMemory();
 	void		ResetMemory();
 
-	void		SetGlobalLimit(unsigned int limit);
+	void		SetGlobalLimit(unsigned long long limit);
+
+	// Generational collection
+	void		SetNurserySize(unsigned int size);
+	void		WriteBarrier(void* address);
+
+	// Non-zero while generational collection is enabled or incremental marking is in progress
+	extern unsigned	writeBarrierActive;
+
+	// Incremental marking
+	void		SetMarkingSliceBudget(unsigned int microseconds);
+
+	// Parallel marking
+	void		SetMarkerThreads(unsigned int count);
+
+	// Heap compaction
+	void		SetHeapCompaction(double occupancy);
+	void		CompactMemory();
+
+	// Deferred finalization
+	void		SetDeferredFinalizers(bool enable);
+	unsigned	RunFinalizers(unsigned microseconds);
+	unsigned	PendingFinalizers();
+	unsigned	MarkFinalizerRoots();
+
+	// Heap snapshots contain the objects that are reachable from global variables and the locations of pointers to them
+	unsigned	SaveHeapSnapshot(char *globals, unsigned globalSize, char **data, const char **error);
+	bool		CheckHeapSnapshot(unsigned globalSize, const char *data, unsigned size);
+	bool		LoadHeapSnapshot(char *globals, unsigned globalSize, const char *data, unsigned size, const char **error);
+
+	// Memory arenas
+	unsigned	CreateArena(bool checkEscapes);
+	void		EnterArena(unsigned id);
+	void		LeaveArena();
+	void		ReleaseArena(unsigned id);
+	long long	ArenaSize(unsigned id);
+
+	// Weak references
+	long long	WeakRefCreate(NULLCRef target);
+	NULLCRef	WeakRefGet(long long handle);
+
+	int			WeakTableCreate(void* owner);
+	NULLCRef	WeakTableFind(int id, NULLCRef key);
+	void		WeakTableSet(int id, NULLCRef key, NULLCRef value);
+	void		WeakTableRemove(int id, NULLCRef key);
+	int			WeakTableSize(int id);
+	void		WeakTableClear(int id);
+
+	// Heap profiler
+	void		SetHeapProfiler(bool enable);
+	void		SetHeapProfilerReportFunction(void *context, void (*callback)(void *context, const char *report));
+	const char*	HeapProfileReport();
+	void		ClearHeapProfile();
+
+	// Arena scopes entered by a script call that has failed are left
+	void		EnterScriptRun();
+	void		LeaveScriptRun(bool success);
+
+	// Location of the mark bit of a heap object
+	struct ObjectMark
+	{
+		uintptr_t	*word;
+		uintptr_t	bit;
+	};
+
+	void*		GetTracedBasePointer(void* ptr, void* location, ObjectMark &mark);
+	bool		IsMovingCollection();
+
+	// Arena objects are checked as roots, returns the number of objects
+	unsigned	MarkArenaRoots();
 
 	NULLCFuncPtr	FunctionRedirect(NULLCRef r, NULLCArray* arr);
 	NULLCFuncPtr	FunctionRedirectPtr(NULLCRef r, NULLCArray* arr);
@@ -2373,14 +2373,17 @@ void x86SatisfyJumps(FastVector<unsigned char*>& instPos)
 			}
 			else
 			{
+				// Near jumps can also target local labels
+				unsigned char *target = (uJmp.labelID & LABEL_GLOBAL) ? instPos[uJmp.labelID & 0x00ffffff] : labels[uJmp.labelID];
+
 				if(*uJmp.jmpPos == 0x0f)
 				{
-					int value = (int)(instPos[uJmp.labelID & 0x00ffffff] - uJmp.jmpPos-6);
+					int value = (int)(target - uJmp.jmpPos-6);
 					memcpy(uJmp.jmpPos + 2, &value, sizeof(value));
 				}
 				else
 				{
-					int value = (int)(instPos[uJmp.labelID & 0x00ffffff] - uJmp.jmpPos-5);
+					int value = (int)(target - uJmp.jmpPos-5);
 					memcpy(uJmp.jmpPos + 1, &value, sizeof(value));
 				}
 			}
@@ -1028,6 +1028,8 @@ struct TypeClass: TypeStruct
 		isInternal = false;
 
 		hasFinalizer = false;
+
+		reorderMembers = false;
 	}
 
 	SynIdentifier identifier;
@@ -1051,6 +1053,9 @@ struct TypeClass: TypeStruct
 
 	bool hasFinalizer;
 
+	// Class members are placed in the order of decreasing alignment to minimize padding
+	bool reorderMembers;
+
 	static const unsigned myTypeID = TypeNode::TypeClass;
 };
 
@@ -8,9 +8,30 @@
 bool	nullcInitGCModule()
 {
 	REGISTER_FUNC(CollectMemory, "NamespaceGC::CollectMemory", 0);
+	REGISTER_FUNC(CompactMemory, "NamespaceGC::Compact", 0);
 	REGISTER_FUNC(UsedMemory, "NamespaceGC::UsedMemory", 0);
+	REGISTER_FUNC(UsedMemoryLong, "NamespaceGC::UsedMemoryLong", 0);
 	REGISTER_FUNC(MarkTime, "NamespaceGC::MarkTime", 0);
 	REGISTER_FUNC(CollectTime, "NamespaceGC::CollectTime", 0);
+	REGISTER_FUNC(Collections, "NamespaceGC::Collections", 0);
+	REGISTER_FUNC(CollectionsPerSecond, "NamespaceGC::CollectionsPerSecond", 0);
+
+	REGISTER_FUNC(SetGCPolicy, "NamespaceGC::SetPolicy", 0);
+
+	REGISTER_FUNC(LastCollection, "NamespaceGC::LastCollection", 0);
+	REGISTER_FUNC(PauseHistogram, "NamespaceGC::PauseHistogram", 0);
+	REGISTER_FUNC(MaxPauseTime, "NamespaceGC::MaxPauseTime", 0);
+	REGISTER_FUNC(TotalPauseTime, "NamespaceGC::TotalPauseTime", 0);
+
+	REGISTER_FUNC(WeakRefCreate, "__weak_ref_create", 0);
+	REGISTER_FUNC(WeakRefGet, "__weak_ref_get", 0);
+
+	REGISTER_FUNC(WeakTableCreate, "__weak_table_create", 0);
+	REGISTER_FUNC(WeakTableFind, "__weak_table_find", 0);
+	REGISTER_FUNC(WeakTableSet, "__weak_table_set", 0);
+	REGISTER_FUNC(WeakTableRemove, "__weak_table_remove", 0);
+	REGISTER_FUNC(WeakTableSize, "__weak_table_size", 0);
+	REGISTER_FUNC(WeakTableClear, "__weak_table_clear", 0);
 
 	return true;
 }
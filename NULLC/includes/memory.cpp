@@ -3,6 +3,8 @@
 #include "../../NULLC/nullc.h"
 #include "../../NULLC/nullbind.h"
 
+#include "../../NULLC/StdLib.h"
+
 namespace NULLCMemory
 {
 	bool check_access(NULLCArray buffer, int offset, unsigned readSizeLog2, int elements)
@@ -533,6 +535,43 @@ namespace NULLCMemory
 		memcpy(&result, &value, sizeof(value));
 		return result;
 	}
+
+	struct Arena
+	{
+		int id;
+	};
+
+	Arena arena_create()
+	{
+		Arena result = { int(NULLC::CreateArena(false)) };
+		return result;
+	}
+
+	Arena arena_create_debug(bool debug)
+	{
+		Arena result = { int(NULLC::CreateArena(debug)) };
+		return result;
+	}
+
+	void arena_enter(Arena arena)
+	{
+		NULLC::EnterArena(unsigned(arena.id));
+	}
+
+	void arena_leave()
+	{
+		NULLC::LeaveArena();
+	}
+
+	void arena_release(Arena arena)
+	{
+		NULLC::ReleaseArena(unsigned(arena.id));
+	}
+
+	long long arena_size(Arena arena)
+	{
+		return NULLC::ArenaSize(unsigned(arena.id));
+	}
 }
 
 #define REGISTER_FUNC(funcPtr, name, index) if(!nullcBindModuleFunctionHelper("std.memory", NULLCMemory::funcPtr, name, index)) return false;
@@ -596,5 +635,12 @@ bool nullcInitMemoryModule()
 	REGISTER_FUNC(as_int, "memory.as_int", 0);
 	REGISTER_FUNC(as_long, "memory.as_long", 0);
 
+	REGISTER_FUNC(arena_create, "memory.arena_create", 0);
+	REGISTER_FUNC(arena_create_debug, "memory.arena_create", 1);
+	REGISTER_FUNC(arena_enter, "memory.arena_enter", 0);
+	REGISTER_FUNC(arena_leave, "memory.arena_leave", 0);
+	REGISTER_FUNC(arena_release, "memory.arena_release", 0);
+	REGISTER_FUNC(arena_size, "memory.arena_size", 0);
+
 	return true;
 }
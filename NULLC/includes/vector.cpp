@@ -64,6 +64,7 @@ namespace NULLCVector
 			vec->data.ptr = newData;
 		}
 		memcpy(vec->data.ptr + vec->elemSize * vec->size, vec->flags ? (char*)&val.ptr : val.ptr, vec->elemSize);
+		nullcWriteBarrier(vec->data.ptr);
 		vec->size++;
 	}
 
@@ -124,6 +125,7 @@ namespace NULLCVector
 			// Allocate new
 			char *newData = (char*)nullcAllocate(vec->elemSize * size);
 			memcpy(newData, vec->data.ptr, unsigned(vec->elemSize * vec->data.len));
+			nullcWriteBarrier(newData);
 			vec->data.len = size;
 			vec->data.ptr = newData;
 		}
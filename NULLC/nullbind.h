@@ -787,8 +787,76 @@ DEFINE_CALL_WRAPPER(13, 1)
 DEFINE_CALL_WRAPPER(14, 1)
 DEFINE_CALL_WRAPPER(15, 1)
 
+// Function signature description: one character for the result and each argument
+// 'v' - void, 'b' - bool, 'c' - char, 's' - short, 'i' - int, 'l' - long long, 'f' - float, 'd' - double, 'p' - pointer, 'a' - NULLCArray, 'F' - NULLCFuncPtr, '?' - other types
+template<typename T>
+struct NullcCallTypeCode
+{
+	static const char value = '?';
+};
+
+template<typename T>
+struct NullcCallTypeCode<T*>
+{
+	static const char value = 'p';
+};
+
+#define DEFINE_CALL_TYPE_CODE(T, code) template<> struct NullcCallTypeCode<T>{ static const char value = code; };
+
+DEFINE_CALL_TYPE_CODE(void, 'v')
+DEFINE_CALL_TYPE_CODE(bool, 'b')
+DEFINE_CALL_TYPE_CODE(char, 'c')
+DEFINE_CALL_TYPE_CODE(signed char, 'c')
+DEFINE_CALL_TYPE_CODE(short, 's')
+DEFINE_CALL_TYPE_CODE(int, 'i')
+DEFINE_CALL_TYPE_CODE(unsigned int, 'i')
+DEFINE_CALL_TYPE_CODE(long, sizeof(long) == 8 ? 'l' : 'i')
+DEFINE_CALL_TYPE_CODE(unsigned long, sizeof(long) == 8 ? 'l' : 'i')
+DEFINE_CALL_TYPE_CODE(long long, 'l')
+DEFINE_CALL_TYPE_CODE(unsigned long long, 'l')
+DEFINE_CALL_TYPE_CODE(float, 'f')
+DEFINE_CALL_TYPE_CODE(double, 'd')
+DEFINE_CALL_TYPE_CODE(NULLCArray, 'a')
+DEFINE_CALL_TYPE_CODE(NULLCFuncPtr, 'F')
+
+#define TCODE_0
+#define TCODE_1 , NullcCallTypeCode<A1>::value
+#define TCODE_2 TCODE_1, NullcCallTypeCode<A2>::value
+#define TCODE_3 TCODE_2, NullcCallTypeCode<A3>::value
+#define TCODE_4 TCODE_3, NullcCallTypeCode<A4>::value
+#define TCODE_5 TCODE_4, NullcCallTypeCode<A5>::value
+#define TCODE_6 TCODE_5, NullcCallTypeCode<A6>::value
+#define TCODE_7 TCODE_6, NullcCallTypeCode<A7>::value
+#define TCODE_8 TCODE_7, NullcCallTypeCode<A8>::value
+#define TCODE_9 TCODE_8, NullcCallTypeCode<A9>::value
+#define TCODE_10 TCODE_9, NullcCallTypeCode<A10>::value
+#define TCODE_11 TCODE_10, NullcCallTypeCode<A11>::value
+#define TCODE_12 TCODE_11, NullcCallTypeCode<A12>::value
+#define TCODE_13 TCODE_12, NullcCallTypeCode<A13>::value
+#define TCODE_14 TCODE_13, NullcCallTypeCode<A14>::value
+#define TCODE_15 TCODE_14, NullcCallTypeCode<A15>::value
+
+#define DEFINE_CALL_SIGNATURE(X) template<typename R TTYPE_##X> const char* nullcGetCallSignature(R(*)(ATYPE_##X)){ static const char signature[] = { NullcCallTypeCode<R>::value TCODE_##X, 0 }; return signature; }
+
+DEFINE_CALL_SIGNATURE(0)
+DEFINE_CALL_SIGNATURE(1)
+DEFINE_CALL_SIGNATURE(2)
+DEFINE_CALL_SIGNATURE(3)
+DEFINE_CALL_SIGNATURE(4)
+DEFINE_CALL_SIGNATURE(5)
+DEFINE_CALL_SIGNATURE(6)
+DEFINE_CALL_SIGNATURE(7)
+DEFINE_CALL_SIGNATURE(8)
+DEFINE_CALL_SIGNATURE(9)
+DEFINE_CALL_SIGNATURE(10)
+DEFINE_CALL_SIGNATURE(11)
+DEFINE_CALL_SIGNATURE(12)
+DEFINE_CALL_SIGNATURE(13)
+DEFINE_CALL_SIGNATURE(14)
+DEFINE_CALL_SIGNATURE(15)
+
 // Bind functions directly
-#define DEFINE_HELPER_WRAPPER(X) template<typename R TTYPE_##X> nullres nullcBindModuleFunctionHelper(const char* module, R(*f)(ATYPE_##X), const char* name, int index){ return nullcBindModuleFunctionWrapper(module, (void*)f, nullcGetCallWrapper(f), name, index); }
+#define DEFINE_HELPER_WRAPPER(X) template<typename R TTYPE_##X> nullres nullcBindModuleFunctionHelper(const char* module, R(*f)(ATYPE_##X), const char* name, int index){ return nullcBindModuleFunctionWrapperTyped(module, (void*)f, nullcGetCallWrapper(f), nullcGetCallSignature(f), name, index); }
 
 DEFINE_HELPER_WRAPPER(0)
 DEFINE_HELPER_WRAPPER(1)
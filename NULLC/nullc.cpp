@@ -17,6 +17,7 @@
 
 #include "StdLib.h"
 #include "BinaryCache.h"
+#include "JitDebugInfo.h"
 #include "Trace.h"
 
 #include "includes/typeinfo.h"
@@ -56,6 +57,7 @@ namespace NULLC
 
 	bool enableLogFiles = false;
 	bool enableExternalDebugger = false;
+	bool enableSnapshots = false;
 
 	void* (*openStream)(const char* name) = OutputContext::FileOpen;
 	void (*writeStream)(void *stream, const char *data, unsigned size) = OutputContext::FileWrite;
@@ -68,6 +70,14 @@ namespace NULLC
 	TraceContext *traceContext = NULL;
 
 	unsigned currDebugCallStackFrame = 0;
+
+	struct WrapperSignature
+	{
+		void (*wrapper)(void *func, char* retBuf, char* argBuf);
+		const char *signature;
+	};
+
+	FastVector<WrapperSignature> wrapperSignatures;
 }
 
 unsigned nullcFindFunctionIndex(const char* name);
@@ -207,11 +217,71 @@ nullres nullcSetExecutorStackSize(unsigned bytes)
 	return 1;
 }
 
+nullres nullcSetNativeCodeCachePath(const char* path)
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(0);
+
+#if defined(NULLC_BUILD_X86_JIT) && defined(_M_X64) && defined(__linux)
+	executorX86->SetNativeCodeCachePath(path);
+
+	return 1;
+#else
+	(void)path;
+
+	nullcLastError = "ERROR: native code cache is only available for x86-64 JIT on Linux";
+	return 0;
+#endif
+}
+
+unsigned nullcGetNativeCodeCacheHits()
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(0);
+
+#if defined(NULLC_BUILD_X86_JIT) && defined(_M_X64) && defined(__linux)
+	return executorX86->GetNativeCodeCacheHits();
+#else
+	return 0;
+#endif
+}
+
 #ifndef NULLC_NO_EXECUTOR
-void nullcSetGlobalMemoryLimit(unsigned limit)
+void nullcSetGlobalMemoryLimit(unsigned long long limit)
 {
 	NULLC::SetGlobalLimit(limit);
 }
+
+void nullcSetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap)
+{
+	NULLC::SetGCPolicy(growthFactor, minimumHeap, maximumHeap);
+}
+
+void nullcSetNurserySize(unsigned bytes)
+{
+	NULLC::SetNurserySize(bytes);
+}
+
+void nullcSetMarkingSliceBudget(unsigned microseconds)
+{
+	NULLC::SetMarkingSliceBudget(microseconds);
+}
+
+void nullcSetMarkerThreads(unsigned count)
+{
+	NULLC::SetMarkerThreads(count);
+}
+
+void nullcSetHeapCompaction(double occupancy)
+{
+	NULLC::SetHeapCompaction(occupancy);
+}
+
+void nullcSetEnableHeapProfiler(int enable, void *context, void (*report)(void *context, const char *report))
+{
+	NULLC::SetHeapProfiler(enable != 0);
+	NULLC::SetHeapProfilerReportFunction(context, report);
+}
 #endif
 
 void nullcSetEnableLogFiles(int enable, void* (*openStream)(const char* name), void (*writeStream)(void *stream, const char *data, unsigned size), void (*closeStream)(void* stream))
@@ -260,6 +330,21 @@ void nullcSetEnableExternalDebugger(int enable)
 	NULLC::enableExternalDebugger = enable != 0;
 }
 
+void nullcSetEnablePerfOutput(int perfMap, int jitDump)
+{
+	NULLC::JitPerfSetEnabled(perfMap != 0, jitDump != 0);
+}
+
+void nullcSetEnableJitDebugInfo(int enable)
+{
+	NULLC::JitGdbSetEnabled(enable != 0);
+}
+
+void nullcSetEnableSnapshots(int enable)
+{
+	NULLC::enableSnapshots = enable != 0;
+}
+
 nullres	nullcBindModuleFunction(const char* module, void (*ptr)(), const char* name, int index)
 {
 	using namespace NULLC;
@@ -318,6 +403,41 @@ nullres nullcBindModuleFunctionWrapper(const char* module, void *func, void (*pt
 	return true;
 }
 
+nullres nullcBindModuleFunctionWrapperTyped(const char* module, void *func, void (*ptr)(void *func, char* retBuf, char* argBuf), const char *signature, const char* name, int index)
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(false);
+
+	if(!nullcBindModuleFunctionWrapper(module, func, ptr, name, index))
+		return false;
+
+	// Signature is a property of the wrapper instantiation, so it's enough to store it once
+	if(signature && ptr && !nullcGetModuleFunctionWrapperSignature(ptr))
+	{
+		WrapperSignature info;
+
+		info.wrapper = ptr;
+		info.signature = signature;
+
+		wrapperSignatures.push_back(info);
+	}
+
+	return true;
+}
+
+const char* nullcGetModuleFunctionWrapperSignature(void (*ptr)(void *func, char* retBuf, char* argBuf))
+{
+	using namespace NULLC;
+
+	for(unsigned i = 0; i < wrapperSignatures.size(); i++)
+	{
+		if(wrapperSignatures[i].wrapper == ptr)
+			return wrapperSignatures[i].signature;
+	}
+
+	return NULL;
+}
+
 ExternFuncInfo* nullcFindModuleFunction(const char* module, const char* name, int index)
 {
 	using namespace NULLC;
@@ -725,6 +845,8 @@ nullres nullcLinkCodeWithModuleName(const char *bytecode, const char *moduleName
 	TRACE_SCOPE("nullc", "nullcLinkCode");
 
 #ifndef NULLC_NO_EXECUTOR
+	linker->keepRootCode = enableSnapshots;
+
 	if(!linker->LinkCode(bytecode, moduleName, true))
 	{
 		nullcLastError = linker->GetLinkError();
@@ -813,6 +935,361 @@ nullres nullcLinkCodeWithModuleName(const char *bytecode, const char *moduleName
 #endif
 }
 
+namespace NULLC
+{
+	struct SnapshotHeader
+	{
+		unsigned	size;
+		unsigned	magic;
+		unsigned	pointerSize;
+
+		unsigned	moduleCount;
+		unsigned	rootCodeSize;
+
+		unsigned	globalSize;
+		unsigned	heapSize;
+
+		unsigned	typeCount;
+		unsigned	functionCount;
+		unsigned	programHash;
+	};
+
+	const unsigned snapshotMagic = 0x534e4c4e;
+
+#ifndef NULLC_NO_EXECUTOR
+	unsigned SaveProgramSnapshot(char **snapshot)
+	{
+		*snapshot = NULL;
+
+		if(currExec == NULLC_LLVM)
+		{
+			nullcLastError = "ERROR: snapshots are not supported by the LLVM executor";
+			return 0;
+		}
+
+		if(!linker->exRootModuleCount)
+		{
+			nullcLastError = "ERROR: there is no linked code";
+			return 0;
+		}
+
+		if(linker->exRootCode.empty())
+		{
+			nullcLastError = "ERROR: program bytecode is not available, snapshots must be enabled before the code is linked";
+			return 0;
+		}
+
+		// Linker keeps module name hashes, names are taken from the binary cache
+		FastVector<const char*> moduleNames;
+		FastVector<const char*> moduleCodes;
+
+		for(unsigned i = 0; i < linker->exModules.size(); i++)
+		{
+			const char *name = NULL;
+			const char *code = NULL;
+
+			for(unsigned k = 0; const char *cacheName = BinaryCache::EnumerateModules(k); k++)
+			{
+				// Cached module name might start with one of the import paths
+				const char *suffix = cacheName;
+
+				while(suffix && GetStringHash(suffix) != linker->exModules[i].nameHash)
+				{
+					if((suffix = strchr(suffix, '/')) != NULL)
+						suffix++;
+				}
+
+				if(suffix)
+				{
+					name = suffix;
+					code = BinaryCache::GetBytecode(cacheName);
+					break;
+				}
+			}
+
+			if(!code)
+			{
+				nullcLastError = "ERROR: module bytecode is not available";
+				return 0;
+			}
+
+			moduleNames.push_back(name);
+			moduleCodes.push_back(code);
+		}
+
+		char *globals = (char*)nullcGetVariableData(NULL);
+
+		char *heap = NULL;
+		const char *error = NULL;
+
+		unsigned heapSize = SaveHeapSnapshot(globals, linker->globalVarSize, &heap, &error);
+
+		if(!heap)
+		{
+			nullcLastError = error;
+			return 0;
+		}
+
+		SnapshotHeader header;
+
+		header.size = sizeof(header);
+		header.magic = snapshotMagic;
+		header.pointerSize = sizeof(void*);
+
+		header.moduleCount = moduleNames.size();
+		header.rootCodeSize = linker->exRootCode.size();
+
+		header.globalSize = linker->globalVarSize;
+		header.heapSize = heapSize;
+
+		header.typeCount = linker->exTypes.size();
+		header.functionCount = linker->exFunctions.size();
+		header.programHash = linker->exRootCodeHash;
+
+		for(unsigned i = 0; i < moduleNames.size(); i++)
+			header.size += unsigned(strlen(moduleNames[i])) + 1 + ((ByteCode*)moduleCodes[i])->size;
+
+		header.size += header.rootCodeSize + header.globalSize + header.heapSize;
+
+		char *pos = *snapshot = new char[header.size];
+
+		memcpy(pos, &header, sizeof(header));
+		pos += sizeof(header);
+
+		for(unsigned i = 0; i < moduleNames.size(); i++)
+		{
+			unsigned nameLength = unsigned(strlen(moduleNames[i])) + 1;
+
+			memcpy(pos, moduleNames[i], nameLength);
+			pos += nameLength;
+
+			memcpy(pos, moduleCodes[i], ((ByteCode*)moduleCodes[i])->size);
+			pos += ((ByteCode*)moduleCodes[i])->size;
+		}
+
+		memcpy(pos, linker->exRootCode.data, header.rootCodeSize);
+		pos += header.rootCodeSize;
+
+		memcpy(pos, globals, header.globalSize);
+		pos += header.globalSize;
+
+		memcpy(pos, heap, header.heapSize);
+
+		delete[] heap;
+
+		return header.size;
+	}
+
+	// Module entry is a zero-terminated name followed by the bytecode, returns the position after the entry or NULL if it doesn't fit
+	const char* SkipSnapshotModule(const char *pos, const char *end)
+	{
+		const char *nameEnd = (const char*)memchr(pos, 0, end - pos);
+
+		if(!nameEnd)
+			return NULL;
+
+		pos = nameEnd + 1;
+
+		unsigned size = 0;
+
+		if(unsigned(end - pos) < sizeof(ByteCode))
+			return NULL;
+
+		memcpy(&size, pos, sizeof(size));
+
+		if(size < sizeof(ByteCode) || size > unsigned(end - pos))
+			return NULL;
+
+		return pos + size;
+	}
+
+	// Global variables and heap of the linked program are replaced with the ones that start at 'pos', 'header.globalSize + header.heapSize' bytes must be available
+	bool LoadProgramState(const SnapshotHeader &header, const char *pos)
+	{
+		if(linker->globalVarSize != header.globalSize || linker->exTypes.size() != header.typeCount || linker->exFunctions.size() != header.functionCount || linker->exRootCodeHash != header.programHash)
+		{
+			nullcLastError = "ERROR: linked program doesn't match the snapshot";
+			return false;
+		}
+
+		// Current state is kept if the saved one is damaged
+		if(!CheckHeapSnapshot(header.globalSize, pos + header.globalSize, header.heapSize))
+		{
+			nullcLastError = "ERROR: heap snapshot is corrupted";
+			return false;
+		}
+
+		char *globals = NULL;
+
+		if(currExec == NULLC_X86)
+		{
+#ifdef NULLC_BUILD_X86_JIT
+			globals = executorX86->PrepareGlobalData();
+#endif
+		}
+		else if(currExec == NULLC_REG_VM)
+		{
+			globals = executorRegVm->PrepareGlobalData();
+		}
+
+		if(!globals)
+		{
+			nullcLastError = "ERROR: failed to prepare global variable storage";
+			return false;
+		}
+
+		// Objects of the previous state are released without finalization, in the same way as they are when the code is cleaned
+		ClearMemory();
+
+		memcpy(globals, pos, header.globalSize);
+		pos += header.globalSize;
+
+		const char *error = NULL;
+
+		if(!LoadHeapSnapshot(globals, header.globalSize, pos, header.heapSize, &error))
+		{
+			// Global variables can't point to the objects that were not restored, so the program is left with an empty state
+			ClearMemory();
+
+			memset(globals, 0, header.globalSize);
+
+			nullcLastError = error;
+			return false;
+		}
+
+		return true;
+	}
+#endif
+}
+
+unsigned nullcSaveSnapshot(char **snapshot)
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(0);
+
+	TRACE_SCOPE("nullc", "nullcSaveSnapshot");
+
+#ifndef NULLC_NO_EXECUTOR
+	return SaveProgramSnapshot(snapshot);
+#else
+	*snapshot = NULL;
+
+	nullcLastError = "No executor available, compile library without NULLC_NO_EXECUTOR";
+	return 0;
+#endif
+}
+
+nullres nullcLoadSnapshot(const char *snapshot, unsigned size)
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(false);
+
+	TRACE_SCOPE("nullc", "nullcLoadSnapshot");
+
+#ifndef NULLC_NO_EXECUTOR
+	SnapshotHeader header;
+
+	if(!snapshot || size < sizeof(header))
+	{
+		nullcLastError = "ERROR: snapshot is corrupted";
+		return false;
+	}
+
+	memcpy(&header, snapshot, sizeof(header));
+
+	if(header.magic != snapshotMagic || header.pointerSize != sizeof(void*))
+	{
+		nullcLastError = "ERROR: snapshot was created by an incompatible build";
+		return false;
+	}
+
+	if(currExec == NULLC_LLVM)
+	{
+		nullcLastError = "ERROR: snapshots are not supported by the LLVM executor";
+		return false;
+	}
+
+	const char *pos = snapshot + sizeof(header);
+	const char *end = snapshot + size;
+
+	// Every section is checked before the current program is removed
+	bool valid = header.size == size;
+
+	for(unsigned i = 0; i < header.moduleCount && valid; i++)
+		valid = (pos = SkipSnapshotModule(pos, end)) != NULL;
+
+	const char *rootEnd = valid && header.rootCodeSize <= unsigned(end - pos) ? pos + header.rootCodeSize : NULL;
+
+	valid = valid && rootEnd && pos != rootEnd;
+
+	while(valid && pos != rootEnd)
+		valid = (pos = SkipSnapshotModule(pos, rootEnd)) != NULL;
+
+	if(!valid || (unsigned long long)header.globalSize + header.heapSize != (unsigned long long)(end - rootEnd))
+	{
+		nullcLastError = "ERROR: snapshot is corrupted";
+		return false;
+	}
+
+	pos = snapshot + sizeof(header);
+
+	// Modules that are not available are placed into the binary cache
+	for(unsigned i = 0; i < header.moduleCount; i++)
+	{
+		const char *name = pos;
+
+		pos += strlen(name) + 1;
+
+		unsigned codeSize = 0;
+		memcpy(&codeSize, pos, sizeof(codeSize));
+
+		if(!BinaryCache::GetBytecode(name))
+		{
+			// Binary cache releases bytecode with delete[]
+			char *copy = new char[codeSize];
+			memcpy(copy, pos, codeSize);
+
+			BinaryCache::PutBytecode(name, copy, NULL, 0);
+		}
+
+		pos += codeSize;
+	}
+
+	nullcClean();
+
+	// Root modules are linked in the original order, so that the type and function indices stay the same
+	while(pos < rootEnd)
+	{
+		const char *name = pos;
+
+		pos += strlen(name) + 1;
+
+		unsigned codeSize = 0;
+		memcpy(&codeSize, pos, sizeof(codeSize));
+
+		char *code = new char[codeSize];
+		memcpy(code, pos, codeSize);
+
+		bool linked = nullcLinkCodeWithModuleName(code, *name ? name : NULL) != 0;
+
+		delete[] code;
+
+		if(!linked)
+			return false;
+
+		pos += codeSize;
+	}
+
+	return LoadProgramState(header, pos);
+#else
+	(void)snapshot;
+	(void)size;
+
+	nullcLastError = "No executor available, compile library without NULLC_NO_EXECUTOR";
+	return false;
+#endif
+}
+
 nullres nullcBuild(const char* code)
 {
 	return nullcBuildWithModuleName(code, NULL);
@@ -1022,6 +1499,107 @@ nullres	nullcRunFunction(const char* funcName, ...)
 	return nullcRunFunctionInternal(functionID, argBuf);
 }
 
+#ifndef NULLC_NO_EXECUTOR
+namespace NULLC
+{
+	// Finds a batch function and the sizes of its argument block and result
+	bool PrepareBatchFunction(const char *funcName, unsigned &functionID, unsigned &inputSize, unsigned &resultSize)
+	{
+		functionID = nullcFindFunctionIndex(funcName);
+
+		if(functionID == ~0u)
+			return false;
+
+		ExternFuncInfo &function = linker->exFunctions[functionID];
+		ExternTypeInfo &returnType = linker->exTypes[linker->exTypeExtra[linker->exTypes[function.funcType].memberOffset].type];
+
+		// Result buffer is not visible to the collector
+		if(returnType.subCat == ExternTypeInfo::CAT_POINTER || returnType.subCat == ExternTypeInfo::CAT_FUNCTION || (returnType.subCat == ExternTypeInfo::CAT_ARRAY && returnType.arrSize == ~0u) || returnType.pointerCount)
+		{
+			nullcLastError = "ERROR: batch function result can't contain pointers";
+			return false;
+		}
+
+		inputSize = function.bytesToPop - sizeof(uintptr_t);
+		resultSize = returnType.size;
+
+		if(inputSize + sizeof(uintptr_t) > 64 * 1024)
+		{
+			nullcLastError = "ERROR: batch function arguments are too large";
+			return false;
+		}
+
+		return true;
+	}
+}
+#endif
+
+nullres nullcRunBatch(const char *funcName, const void *inputs, void *results, unsigned count)
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(false);
+
+	TRACE_SCOPE("nullc", "nullcRunBatch");
+
+#ifndef NULLC_NO_EXECUTOR
+	unsigned functionID = 0, inputSize = 0, resultSize = 0;
+
+	if(!PrepareBatchFunction(funcName, functionID, inputSize, resultSize))
+		return false;
+
+	// Arguments are followed by an empty context pointer
+	for(unsigned i = 0; i < count; i++)
+	{
+		memcpy(argBuf, (const char*)inputs + uintptr_t(i) * inputSize, inputSize);
+		memset(argBuf + inputSize, 0, sizeof(uintptr_t));
+
+		if(!nullcRunFunctionInternal(functionID, argBuf))
+			return false;
+
+		if(resultSize)
+			memcpy((char*)results + uintptr_t(i) * resultSize, nullcGetResultObject().ptr, resultSize);
+	}
+
+	return true;
+#else
+	(void)funcName;
+	(void)inputs;
+	(void)results;
+	(void)count;
+
+	nullcLastError = "No executor available, compile library without NULLC_NO_EXECUTOR";
+	return false;
+#endif
+}
+
+nullres nullcBeginCallSession()
+{
+	using namespace NULLC;
+	NULLC_CHECK_INITIALIZED(false);
+
+#ifdef NULLC_BUILD_X86_JIT
+	if(currExec == NULLC_X86 && !executorX86->BeginCallSession())
+	{
+		nullcLastError = executorX86->GetErrorMessage();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void nullcEndCallSession()
+{
+	using namespace NULLC;
+
+	if(!initialized)
+		return;
+
+#ifdef NULLC_BUILD_X86_JIT
+	executorX86->EndCallSession();
+#endif
+}
+
 nullres nullcRunFunctionInternal(unsigned functionID, const char* argBuf)
 {
 	using namespace NULLC;
@@ -1029,6 +1607,8 @@ nullres nullcRunFunctionInternal(unsigned functionID, const char* argBuf)
 
 	nullres good = true;
 
+	NULLC::EnterScriptRun();
+
 	if(currExec == NULLC_X86)
 	{
 #ifdef NULLC_BUILD_X86_JIT
@@ -1077,6 +1657,8 @@ nullres nullcRunFunctionInternal(unsigned functionID, const char* argBuf)
 		nullcLastError = "Unknown executor code";
 	}
 
+	NULLC::LeaveScriptRun(good);
+
 #if !defined(NULLC_NO_EXECUTOR) && defined(NULLC_REG_VM_PROFILE_INSTRUCTIONS)
 	if(currExec == NULLC_REG_VM && functionID == ~0u && enableLogFiles)
 	{
@@ -1205,7 +1787,11 @@ nullres nullcCallFunction(NULLCFuncPtr ptr, ...)
 
 	if(!argBuf)
 		return false;
-	
+
+	nullres good = true;
+
+	NULLC::EnterScriptRun();
+
 	if(currExec == NULLC_X86)
 	{
 #ifdef NULLC_BUILD_X86_JIT
@@ -1213,7 +1799,7 @@ nullres nullcCallFunction(NULLCFuncPtr ptr, ...)
 		{
 			nullcLastError = executorX86->GetErrorMessage();
 
-			return false;
+			good = false;
 		}
 #endif
 	}
@@ -1224,7 +1810,7 @@ nullres nullcCallFunction(NULLCFuncPtr ptr, ...)
 		{
 			nullcLastError = executorLLVM->GetErrorMessage();
 
-			return false;
+			good = false;
 		}
 #endif
 	}
@@ -1234,11 +1820,13 @@ nullres nullcCallFunction(NULLCFuncPtr ptr, ...)
 		{
 			nullcLastError = executorRegVm->GetErrorMessage();
 
-			return false;
+			good = false;
 		}
 	}
 
-	return true;
+	NULLC::LeaveScriptRun(good);
+
+	return good;
 }
 
 nullres nullcSetGlobal(const char* name, void* data)
@@ -1414,6 +2002,46 @@ nullres nullcIsManagedPointer(void* ptr)
 	return NULLC::IsBasePointer(ptr);
 }
 
+void nullcWriteBarrier(void* address)
+{
+	NULLC::WriteBarrier(address);
+}
+
+const char* nullcGetHeapProfileReport()
+{
+	return NULLC::HeapProfileReport();
+}
+
+void nullcClearHeapProfile()
+{
+	NULLC::ClearHeapProfile();
+}
+
+void nullcSetDeferredFinalizers(int enable)
+{
+	NULLC::SetDeferredFinalizers(enable != 0);
+}
+
+unsigned nullcRunFinalizers(unsigned microseconds)
+{
+	return NULLC::RunFinalizers(microseconds);
+}
+
+void nullcGetGCStatistics(NULLCGCStatistics *stats)
+{
+	NULLC::GetGCStatistics(*stats);
+}
+
+unsigned nullcGetGCCollectionHistory(NULLCCollectionInfo *history, unsigned count)
+{
+	return NULLC::GetCollectionHistory(history, count);
+}
+
+void nullcResetGCStatistics()
+{
+	NULLC::ResetGCStatistics();
+}
+
 #endif
 
 unsigned nullcGetResultType()
@@ -1647,6 +2275,8 @@ void nullcTerminate()
 
 	allocator.Reset();
 
+	wrapperSignatures.reset();
+
 	NULLC::dealloc(argBuf);
 	argBuf = NULL;
 
@@ -1671,6 +2301,9 @@ void nullcTerminate()
 #ifdef NULLC_BUILD_X86_JIT
 	NULLC::destruct(executorX86);
 	executorX86 = NULL;
+
+	NULLC::JitPerfTerminate();
+	NULLC::JitGdbTerminate();
 #endif
 #ifndef NULLC_NO_EXECUTOR
 	NULLC::destruct(executorRegVm);
@@ -12,6 +12,9 @@ extern "C"
 /*				NULLC initialization and termination					*/
 
 nullres		nullcInit();
+
+/*	All memory is requested through the custom allocation functions, including objects that are larger than 32Kb, which are limited to 2Gb in this case
+	Without them, such objects are placed into pages requested from the OS directly, so that memory is returned as soon as they are collected	*/
 nullres		nullcInitCustomAlloc(void* (*allocFunc)(int), void (*deallocFunc)(void*));
 
 void		nullcClearImportPaths();
@@ -20,13 +23,41 @@ void		nullcRemoveImportPath(const char* importPath);
 nullres		nullcHasImportPath(const char* importPath);
 
 void		nullcSetFileReadHandler(const char* (*fileLoadFunc)(const char* name, unsigned* size), void (*fileFreeFunc)(const char* data));
-void		nullcSetGlobalMemoryLimit(unsigned limit);
+void		nullcSetGlobalMemoryLimit(unsigned long long limit);
+/*	Set the heap growth policy: next collection is started when the heap grows to the memory that survived the last collection multiplied by the growth factor (default is 2.0).
+	Collection threshold is kept between the minimum heap size (default is 1Mb) and the maximum heap size, 0 means no maximum (default)	*/
+void		nullcSetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap);
+
+/*	Enable generational garbage collection with a nursery of the specified size, 0 disables it (default). Objects allocated by script code are placed into the nursery and survivors are moved to the main heap by minor collections.
+	While enabled, objects may move when script code allocates memory: host code must not keep pointers to script objects between calls into script code and has to call nullcWriteBarrier after storing pointers into script objects	*/
+void		nullcSetNurserySize(unsigned bytes);
+/*	Enable incremental marking that is performed in slices of the specified duration in microseconds as script memory is allocated, 0 disables it (default). Has no effect when generational collection is enabled.
+	While enabled, host code has to call nullcWriteBarrier after storing pointers into script objects	*/
+void		nullcSetMarkingSliceBudget(unsigned microseconds);
+/*	Set the number of threads that mark reachable objects during full collections, including the thread that runs the collection, 1 disables parallel marking (default).
+	While enabled, custom allocation functions set by nullcInitCustomAlloc must be thread-safe	*/
+void		nullcSetMarkerThreads(unsigned count);
+/*	Enable heap compaction: full collections started by script memory allocation move live objects out of block pool pages that are occupied less than the specified share (0.0 - 1.0) and release these pages, 0 disables it (default).
+	While enabled, objects may move when script code allocates memory: host code must not keep pointers to script objects between calls into script code	*/
+void		nullcSetHeapCompaction(double occupancy);
+/*	Enable heap profiler that records allocation count and size for each type and allocation site and objects that survive each full collection, disabled by default.
+	If a report function is set, text report is passed to it after each full collection	*/
+void		nullcSetEnableHeapProfiler(int enable, void *context, void (*report)(void *context, const char *report));
 void		nullcSetEnableLogFiles(int enable, void* (*openStream)(const char* name), void (*writeStream)(void *stream, const char *data, unsigned size), void (*closeStream)(void* stream));
 void		nullcSetOptimizationLevel(int level);
 void		nullcSetEnableTimeTrace(int enable);
 void		nullcSetModuleAnalyzeMemoryLimit(unsigned bytes);
 void		nullcSetEnableExternalDebugger(int enable);
 
+/*	Enable output of symbols for code generated by x86 JIT to Linux perf: /tmp/perf-<pid>.map symbol map and /tmp/jit-<pid>.dump records with line information for 'perf inject --jit'	*/
+void		nullcSetEnablePerfOutput(int perfMap, int jitDump);
+
+/*	Register code generated by x86 JIT with native debuggers through the GDB JIT interface (Linux x64): function symbols, source line tables and unwind information	*/
+void		nullcSetEnableJitDebugInfo(int enable);
+
+/*	Keep the bytecode of linked programs for nullcSaveSnapshot, takes effect for the code that is linked after the call	*/
+void		nullcSetEnableSnapshots(int enable);
+
 void		nullcTerminate();
 
 /************************************************************************/
@@ -37,11 +68,20 @@ void		nullcSetExecutor(unsigned id);
 
 nullres		nullcSetExecutorStackSize(unsigned bytes);
 
+/*	Set a directory where native code generated by the x86-64 JIT is stored, keyed by program bytecode hash. Next build of the same program loads native code from it instead of running code generation. Pass NULL to disable	*/
+nullres		nullcSetNativeCodeCachePath(const char* path);
+
+/*	Get the number of builds that have loaded native code from the cache	*/
+unsigned	nullcGetNativeCodeCacheHits();
+
 /*	Used to bind unresolved module functions to external C functions. Function index is the number of a function overload. Direct binding is not available if NULLC_NO_RAW_EXTERNAL_CALL is set	*/
 nullres		nullcBindModuleFunction(const char* module, void (*ptr)(), const char* name, int index);
 
 nullres		nullcBindModuleFunctionWrapper(const char* module, void *func, void (*ptr)(void *func, char* retBuf, char* argBuf), const char* name, int index);
 
+/*	Same as nullcBindModuleFunctionWrapper, with a signature string from nullbind.h that describes C types of the function result and arguments, allowing x86 JIT to call the function directly	*/
+nullres		nullcBindModuleFunctionWrapperTyped(const char* module, void *func, void (*ptr)(void *func, char* retBuf, char* argBuf), const char *signature, const char* name, int index);
+
 /*	Builds module and saves its binary into binary cache	*/
 nullres		nullcLoadModuleBySource(const char* module, const char* code);
 
@@ -91,6 +131,15 @@ nullres		nullcRun();
 nullres		nullcRunFunction(const char* funcName, ...);
 nullres		nullcRunFunctionInternal(unsigned functionID, const char* argBuf);
 
+/*	Call a function for 'count' inputs on the calling thread and write the results in the same order
+	every input contains function arguments as they are placed on the stack, results are placed one after the other and can't contain pointers
+	calls can't be spread between threads because linker, executor and heap state of the library is global */
+nullres		nullcRunBatch(const char *funcName, const void *inputs, void *results, unsigned count);
+
+/*	Keep execution environment prepared between top-level function calls for hosts that call into NULLC at a high frequency. x86 JIT keeps its signal handlers installed until the session is ended	*/
+nullres		nullcBeginCallSession();
+void		nullcEndCallSession();
+
 /*	Retrieve result	*/
 unsigned	nullcGetResultType();
 NULLCRef	nullcGetResultObject();
@@ -156,6 +205,24 @@ nullres		nullcIsStackPointer(void* ptr);
 /*	Function returns 1 if passed pointer points to a memory managed by NULLC GC; otherwise, the return value is 0	*/
 nullres		nullcIsManagedPointer(void* ptr);
 
+/*	Notify garbage collector that a pointer was stored at the specified address inside of an object managed by NULLC GC. Required for external functions when generational collection or incremental marking is enabled	*/
+void		nullcWriteBarrier(void* address);
+
+/*	Defer finalizers of unreachable objects to nullcRunFinalizers calls instead of running them at the end of each collection, disabled by default. Objects are kept alive until their finalizers are run	*/
+void		nullcSetDeferredFinalizers(int enable);
+/*	Run pending finalizers until the time budget in microseconds is spent, 0 runs all of them. Function returns the number of finalized objects	*/
+unsigned	nullcRunFinalizers(unsigned microseconds);
+
+/*	Get heap profiler text report with statistics collected since the program was linked or the profile was cleared	*/
+const char*	nullcGetHeapProfileReport();
+void		nullcClearHeapProfile();
+
+/*	Get garbage collector pause statistics collected since the program was linked or statistics were reset	*/
+void		nullcGetGCStatistics(NULLCGCStatistics *stats);
+/*	Get information about recent full collections, starting from the most recent one. Up to NULLC_GC_HISTORY_SIZE collections are kept, function returns the number of records written	*/
+unsigned	nullcGetGCCollectionHistory(NULLCCollectionInfo *history, unsigned count);
+void		nullcResetGCStatistics();
+
 #endif
 
 /************************************************************************/
@@ -195,6 +262,17 @@ nullres		nullcLinkCode(const char *bytecode);
 /*	Link new chunk of code with an additional module name info	*/
 nullres		nullcLinkCodeWithModuleName(const char *bytecode, const char *moduleName);
 
+/*	Snapshot contains the bytecode of the linked program, its global variables and the objects that are reachable from them
+	function returns snapshot size, memory to which 'snapshot' points should be freed with delete[]
+	program must be linked after nullcSetEnableSnapshots(true) call
+	snapshot can't be taken while the script is running, objects in memory arenas, weak references and objects with address-based hash values are not supported */
+unsigned	nullcSaveSnapshot(char **snapshot);
+
+/*	Link the program from a snapshot of 'size' bytes and restore its global state without running the global code
+	snapshot layout is checked before the current program is removed, but the bytecode inside it is trusted in the same way as it is by nullcLinkCode
+	external functions used by the program must be bound before the snapshot is loaded */
+nullres		nullcLoadSnapshot(const char *snapshot, unsigned size);
+
 /************************************************************************/
 /*							Internal testing functions					*/
 
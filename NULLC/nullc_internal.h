@@ -17,6 +17,8 @@ nullres nullcBindModuleFunctionBuiltin(const char* module, const char* name, int
 
 nullres nullcSetModuleFunctionAttribute(const char* module, const char* name, int index, unsigned attribute, unsigned value);
 
+const char* nullcGetModuleFunctionWrapperSignature(void (*ptr)(void *func, char* retBuf, char* argBuf));
+
 void nullcVisitParseTreeNodes(SynBase *syntax, void *context, void(*accept)(void *context, SynBase *child));
 void nullcVisitExpressionTreeNodes(ExprBase *expression, void *context, void(*accept)(void *context, ExprBase *child));
 
@@ -34,6 +34,43 @@ struct NULLCAutoArray
 
 #pragma pack(pop)
 
+#define NULLC_GC_PAUSE_BUCKETS 16
+#define NULLC_GC_HISTORY_SIZE 64
+
+// Information about a full garbage collection, times are in seconds
+struct NULLCCollectionInfo
+{
+	double		startTime;		// time since the program was linked or statistics were reset
+	double		pauseTime;
+	double		markTime;
+	double		sweepTime;
+	double		finalizeTime;
+
+	long long	bytesBefore;
+	long long	bytesAfter;
+	long long	objectsFreed;
+	long long	rootsScanned;
+	long long	objectsMoved;	// objects moved out of sparse heap pages by compaction
+};
+
+// Garbage collector pause statistics, pauses include full collections, minor collections and incremental marking slices
+struct NULLCGCStatistics
+{
+	long long	collections;
+	long long	minorCollections;
+	long long	markingSlices;
+
+	double		totalPauseTime;
+	double		maxPauseTime;
+
+	// Bucket i counts pauses shorter than (32 << i) microseconds that didn't fit into the previous buckets, the last bucket counts all longer pauses
+	long long	pauseHistogram[NULLC_GC_PAUSE_BUCKETS];
+
+	// Objects waiting in the deferred finalization queue and objects that were finalized
+	long long	finalizersPending;
+	long long	finalizersRun;
+};
+
 #define NULLC_MAX_VARIABLE_NAME_LENGTH 2048
 #define NULLC_MAX_TYPE_NAME_LENGTH 8192
 #define NULLC_DEFAULT_GLOBAL_MEMORY_LIMIT 1024 * 1024 * 1024
@@ -11,6 +11,11 @@
 	#include <stdint.h>
 #endif
 
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#endif
+
 #undef assert
 #define __assert(_Expression) if(!(_Expression)){ printf("assertion failed"); abort(); };
 
@@ -2242,10 +2247,14 @@ namespace NULLC
 {
 	const unsigned int poolBlockSize = 64 * 1024;
 
-	unsigned int usedMemory = 0;
+	uintptr_t usedMemory = 0;
+
+	uintptr_t collectableMinimum = 1024 * 1024;
+	uintptr_t globalMemoryLimit = 1024 * 1024 * 1024;
 
-	unsigned int collectableMinimum = 1024 * 1024;
-	unsigned int globalMemoryLimit = 1024 * 1024 * 1024;
+	double gcGrowthFactor = 2.0;
+	uintptr_t gcMinimumHeap = 1024 * 1024;
+	uintptr_t gcMaximumHeap = 0;
 
 	ObjectBlockPool<8, poolBlockSize / 8>		pool8;
 	ObjectBlockPool<16, poolBlockSize / 16>		pool16;
@@ -2297,6 +2306,21 @@ namespace NULLC
 
 	double	markTime = 0.0;
 	double	collectTime = 0.0;
+
+	double	GetPreciseTime();
+
+	unsigned int collectionCount = 0;
+	double	collectionCountStart = GetPreciseTime();
+
+	CollectionInfo	lastCollection;
+
+	double	maxPauseTime = 0.0;
+	double	totalPauseTime = 0.0;
+
+	// Bucket i counts pauses shorter than (32 << i) microseconds that didn't fit into the previous buckets
+	long long	pauseHistogram[16];
+
+	uintptr_t NextCollectionThreshold();
 }
 
 void* NULLC::AllocObject(int size, unsigned typeID)
@@ -2309,15 +2333,15 @@ void* NULLC::AllocObject(int size, unsigned typeID)
 	void *data = NULL;
 	size += sizeof(markerType);
 
-	if((unsigned int)(usedMemory + size) > globalMemoryLimit)
+	if(usedMemory + size > globalMemoryLimit)
 	{
 		CollectMemory();
-		if((unsigned int)(usedMemory + size) > globalMemoryLimit)
+		if(usedMemory + size > globalMemoryLimit)
 		{
 			nullcThrowError("Reached global memory maximum");
 			return NULL;
 		}
-	}else if((unsigned int)(usedMemory + size) > collectableMinimum){
+	}else if(usedMemory + size > collectableMinimum){
 		CollectMemory();
 	}
 	unsigned int realSize = size;
@@ -2393,6 +2417,11 @@ void* NULLC::AllocObject(int size, unsigned typeID)
 }
 
 unsigned int NULLC::UsedMemory()
+{
+	return usedMemory < 0xffffffffu ? unsigned(usedMemory) : 0xffffffffu;
+}
+
+long long NULLC::UsedMemoryLong()
 {
 	return usedMemory;
 }
@@ -2539,6 +2568,12 @@ void NULLC::CollectBlock(Range& curr)
 	}
 }
 
+// Objects are not moved by the translated code collector
+void NULLC::CompactMemory()
+{
+	CollectMemory();
+}
+
 void NULLC::CollectMemory()
 {
 	GC_DEBUG_PRINT("%d used memory (%d collectable cap, %d max cap)\r\n", usedMemory, collectableMinimum, globalMemoryLimit);
@@ -2547,6 +2582,14 @@ void NULLC::CollectMemory()
 
 	GC::unmanageableBase = (char*)&time;
 
+	double pauseStart = GetPreciseTime();
+
+	CollectionInfo info;
+	memset(&info, 0, sizeof(info));
+
+	info.startTime = pauseStart;
+	info.bytesBefore = usedMemory;
+
 	// All memory blocks are marked with 0
 	MarkMemory(0);
 	// Used memory blocks are marked with 1
@@ -2555,6 +2598,8 @@ void NULLC::CollectMemory()
 	markTime += (double(clock()) / CLOCKS_PER_SEC) - time;
 	time = (double(clock()) / CLOCKS_PER_SEC);
 
+	info.markTime = time - pauseStart;
+
 	// Globally allocated objects marked with 0 are deleted
 	unusedBlocks = 0;
 
@@ -2567,6 +2612,8 @@ void NULLC::CollectMemory()
 
 	toErase.clear();
 
+	info.objectsFreed += unusedBlocks;
+
 //	printf("%d unused globally allocated blocks destroyed\r\n", unusedBlocks);
 
 //	printf("%d used memory\r\n", usedMemory);
@@ -2574,35 +2621,65 @@ void NULLC::CollectMemory()
 	// Objects allocated from pools are freed
 	unusedBlocks = pool8.FreeMarked();
 	usedMemory -= unusedBlocks * 8;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (8 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool16.FreeMarked();
 	usedMemory -= unusedBlocks * 16;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (16 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool32.FreeMarked();
 	usedMemory -= unusedBlocks * 32;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (32 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool64.FreeMarked();
 	usedMemory -= unusedBlocks * 64;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (64 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool128.FreeMarked();
 	usedMemory -= unusedBlocks * 128;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (128 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool256.FreeMarked();
 	usedMemory -= unusedBlocks * 256;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (256 bytes)\r\n", unusedBlocks);
 	unusedBlocks = pool512.FreeMarked();
 	usedMemory -= unusedBlocks * 512;
+	info.objectsFreed += unusedBlocks;
 //	printf("%d unused pool blocks freed (512 bytes)\r\n", unusedBlocks);
 
 	GC_DEBUG_PRINT("%d used memory\r\n", usedMemory);
 
 	collectTime += (double(clock()) / CLOCKS_PER_SEC) - time;
 
-	if(usedMemory + (usedMemory >> 1) >= collectableMinimum)
-		collectableMinimum <<= 1;
+	info.sweepTime = (double(clock()) / CLOCKS_PER_SEC) - time;
+	info.bytesAfter = usedMemory;
+
+	collectableMinimum = NextCollectionThreshold();
+
+	collectionCount++;
+
+	time = (double(clock()) / CLOCKS_PER_SEC);
 
 	__finalizeObjects_void_ref__(0);
 	finalizeList.clear();
+
+	info.finalizeTime = (double(clock()) / CLOCKS_PER_SEC) - time;
+	info.pauseTime = GetPreciseTime() - pauseStart;
+
+	lastCollection = info;
+
+	totalPauseTime += info.pauseTime;
+
+	if(info.pauseTime > maxPauseTime)
+		maxPauseTime = info.pauseTime;
+
+	unsigned bucket = 0;
+
+	for(double limit = 32.0 / 1000000.0; bucket + 1 < 16 && info.pauseTime >= limit; limit *= 2.0)
+		bucket++;
+
+	pauseHistogram[bucket]++;
 }
 
 double NULLC::MarkTime()
@@ -2615,6 +2692,98 @@ double NULLC::CollectTime()
 	return collectTime;
 }
 
+unsigned int NULLC::Collections()
+{
+	return collectionCount;
+}
+
+double NULLC::GetPreciseTime()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return double(count.QuadPart) / double(freq.QuadPart);
+#elif defined(__linux)
+	timespec x;
+	clock_gettime(CLOCK_MONOTONIC, &x);
+
+	return double(x.tv_sec) + double(x.tv_nsec) / 1000000000.0;
+#else
+	return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+double NULLC::CollectionsPerSecond()
+{
+	double elapsed = GetPreciseTime() - collectionCountStart;
+
+	return elapsed > 0.0 ? collectionCount / elapsed : 0.0;
+}
+
+bool NULLC::LastCollection(CollectionInfo* info)
+{
+	if(!info)
+	{
+		nullcThrowError("ERROR: null pointer access");
+		return false;
+	}
+
+	if(!collectionCount)
+		return false;
+
+	*info = lastCollection;
+
+	return true;
+}
+
+long long NULLC::PauseHistogram(int bucket)
+{
+	if(unsigned(bucket) >= 16)
+	{
+		nullcThrowError("ERROR: pause histogram bucket %d is out of range [0, %d)", bucket, 16);
+		return 0;
+	}
+
+	return pauseHistogram[bucket];
+}
+
+double NULLC::MaxPauseTime()
+{
+	return maxPauseTime;
+}
+
+double NULLC::TotalPauseTime()
+{
+	return totalPauseTime;
+}
+
+void NULLC::SetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap)
+{
+	gcGrowthFactor = growthFactor < 1.0 ? 1.0 : growthFactor;
+	gcMinimumHeap = minimumHeap < uintptr_t(-1) ? uintptr_t(minimumHeap) : uintptr_t(-1);
+	gcMaximumHeap = maximumHeap < uintptr_t(-1) ? uintptr_t(maximumHeap) : uintptr_t(-1);
+
+	collectableMinimum = NextCollectionThreshold();
+}
+
+uintptr_t NULLC::NextCollectionThreshold()
+{
+	double threshold = double(usedMemory) * gcGrowthFactor;
+
+	if(gcMaximumHeap && threshold > double(gcMaximumHeap))
+		threshold = double(gcMaximumHeap);
+
+	if(threshold < double(gcMinimumHeap))
+		threshold = double(gcMinimumHeap);
+
+	if(threshold > double(globalMemoryLimit))
+		threshold = double(globalMemoryLimit);
+
+	return uintptr_t(threshold);
+}
+
 void NULLC::FinalizeBlock(Range& curr)
 {
 	void *block = curr.start;
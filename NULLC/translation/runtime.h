@@ -365,9 +365,36 @@ namespace NULLC
 	void*		GetBasePointer(void* ptr);
 
 	void		CollectMemory();
+	void		CompactMemory();
 	unsigned int	UsedMemory();
+	long long	UsedMemoryLong();
 	double		MarkTime();
 	double		CollectTime();
+	unsigned int	Collections();
+	double		CollectionsPerSecond();
+
+	// Layout matches GCCollectionInfo class from std.gc
+	struct CollectionInfo
+	{
+		double		startTime;
+		double		pauseTime;
+		double		markTime;
+		double		sweepTime;
+		double		finalizeTime;
+
+		long long	bytesBefore;
+		long long	bytesAfter;
+		long long	objectsFreed;
+		long long	rootsScanned;
+		long long	objectsMoved;
+	};
+
+	bool		LastCollection(CollectionInfo* info);
+	long long	PauseHistogram(int bucket);
+	double		MaxPauseTime();
+	double		TotalPauseTime();
+
+	void		SetGCPolicy(double growthFactor, unsigned long long minimumHeap, unsigned long long maximumHeap);
 
 	void		FinalizeMemory();
 }
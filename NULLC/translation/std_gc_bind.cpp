@@ -1,17 +1,42 @@
 #include "runtime.h"
 
+struct GCCollectionInfo 
+{
+	double startTime;
+	double pauseTime;
+	double markTime;
+	double sweepTime;
+	double finalizeTime;
+	long long bytesBefore;
+	long long bytesAfter;
+	long long objectsFreed;
+	long long rootsScanned;
+	long long objectsMoved;
+};
 struct NamespaceGC 
 {
 };
+struct weak_table 
+{
+	int id;
+};
 void NamespaceGC__CollectMemory_void_ref__(NamespaceGC * __context)
 {
 	NULLC::CollectMemory();
 }
+void NamespaceGC__Compact_void_ref__(NamespaceGC * __context)
+{
+	NULLC::CompactMemory();
+}
 
 int NamespaceGC__UsedMemory_int_ref__(NamespaceGC * __context)
 {
 	return NULLC::UsedMemory();
 }
+long long NamespaceGC__UsedMemoryLong_long_ref__(NamespaceGC * __context)
+{
+	return NULLC::UsedMemoryLong();
+}
 double NamespaceGC__MarkTime_double_ref__(NamespaceGC * __context)
 {
 	return NULLC::MarkTime();
@@ -20,3 +45,70 @@ double NamespaceGC__CollectTime_double_ref__(NamespaceGC * __context)
 {
 	return NULLC::CollectTime();
 }
+int NamespaceGC__Collections_int_ref__(NamespaceGC * __context)
+{
+	return NULLC::Collections();
+}
+double NamespaceGC__CollectionsPerSecond_double_ref__(NamespaceGC * __context)
+{
+	return NULLC::CollectionsPerSecond();
+}
+void NamespaceGC__SetPolicy_void_ref_double_long_long_(double growthFactor, long long minimumHeap, long long maximumHeap, NamespaceGC * __context)
+{
+	NULLC::SetGCPolicy(growthFactor, minimumHeap, maximumHeap);
+}
+bool NamespaceGC__LastCollection_bool_ref_GCCollectionInfo_ref_(GCCollectionInfo * info, NamespaceGC * __context)
+{
+	return NULLC::LastCollection((NULLC::CollectionInfo*)info);
+}
+long long NamespaceGC__PauseHistogram_long_ref_int_(int bucket, NamespaceGC * __context)
+{
+	return NULLC::PauseHistogram(bucket);
+}
+double NamespaceGC__MaxPauseTime_double_ref__(NamespaceGC * __context)
+{
+	return NULLC::MaxPauseTime();
+}
+double NamespaceGC__TotalPauseTime_double_ref__(NamespaceGC * __context)
+{
+	return NULLC::TotalPauseTime();
+}
+
+// Collector of the translated code doesn't track weak references
+long long __weak_ref_create_long_ref_auto_ref_(NULLCRef target, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+	return 0;
+}
+NULLCRef __weak_ref_get_auto_ref_ref_long_(long long handle, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+	return NULLCRef();
+}
+int __weak_table_create_int_ref_weak_table_ref_(weak_table * owner, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+	return 0;
+}
+NULLCRef __weak_table_find_auto_ref_ref_int_auto_ref_(int id, NULLCRef key, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+	return NULLCRef();
+}
+void __weak_table_set_void_ref_int_auto_ref_auto_ref_(int id, NULLCRef key, NULLCRef value, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+}
+void __weak_table_remove_void_ref_int_auto_ref_(int id, NULLCRef key, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+}
+int __weak_table_size_int_ref_int_(int id, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+	return 0;
+}
+void __weak_table_clear_void_ref_int_(int id, void* __context)
+{
+	nullcThrowError("ERROR: weak references are not supported in translated code");
+}
@@ -28,6 +28,8 @@ void RunCompileFailTests()
 	TEST_FOR_FAIL("Unknown escape sequence", "return '\\p';", "ERROR: unknown escape sequence");
 	TEST_FOR_FAIL("Wrong alignment", "align(32) int a; return 0;", "ERROR: alignment must be less than 16 bytes");
 	TEST_FOR_FAIL("Wrong alignment", "align(13) int a; return 0;", "ERROR: alignment must be power of two");
+	TEST_FOR_FAIL("Automatic alignment of a variable", "align(auto) int a; return 0;", "ERROR: align(auto) is only allowed on class definitions");
+	TEST_FOR_FAIL("Automatic alignment of a member", "class Foo{ align(auto) int a; } return 0;", "ERROR: align(auto) is only allowed on class definitions");
 	TEST_FOR_FAIL("Change of immutable value", "int i; return *i = 5;", "ERROR: cannot dereference type 'int' that is not a pointer");
 	TEST_FOR_FAIL("Hex overflow", "return 0xbeefbeefbeefbeefb;", "ERROR: overflow in hexadecimal constant");
 	TEST_FOR_FAIL("Oct overflow", "return 03333333333333333333333;", "ERROR: overflow in octal constant");
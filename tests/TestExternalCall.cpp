@@ -517,6 +517,56 @@ ReturnSmall3 TestReturnSmall3()
 #undef MODULE_SUFFIX
 #undef ALL_EXTERNAL_CALLS
 
+bool TestDirectMixed(bool negate, char a, short b, long long c, double d, NULLCArray arr)
+{
+	int sum = 0;
+
+	for(unsigned i = 0; i < arr.len; i++)
+		sum += arr.ptr[i];
+
+	bool result = a == -1 && b == -2 && c == -3000000000ll && d == 4.0 && sum == 'a' + 'b';
+
+	return negate ? !result : result;
+}
+
+float TestDirectFloat(int a, double b)
+{
+	return float(a * b);
+}
+
+int TestDirectError(int a)
+{
+	if(a < 0)
+		nullcThrowError("negative value %d", a);
+
+	return a;
+}
+
+LOAD_MODULE_BIND(test_direct, "test.direct", "bool Mixed(bool negate, char a, short b, long c, double d, char[] arr); float Float(int a, double b); int Error(int a);")
+{
+	nullcBindModuleFunctionHelper("test.direct", TestDirectMixed, "Mixed", 0);
+	nullcBindModuleFunctionHelper("test.direct", TestDirectFloat, "Float", 0);
+	nullcBindModuleFunctionHelper("test.direct", TestDirectError, "Error", 0);
+}
+
+const char	*testExternalCallDirect1 =
+"import test.direct;\r\n\
+bool a = Mixed(false, -1, -2, -3000000000l, 4.0, \"ab\");\r\n\
+bool b = Mixed(true, -1, -2, -3000000000l, 4.0, \"ab\");\r\n\
+return a && !b;";
+TEST_RESULT("External function call. Mixed argument types [direct]", testExternalCallDirect1, "1");
+
+const char	*testExternalCallDirect2 =
+"import test.direct;\r\n\
+return int(Float(3, 1.5) * 2) + Error(4);";
+TEST_RESULT("External function call. float result [direct]", testExternalCallDirect2, "13");
+
+const char	*testExternalCallDirect3 =
+"import test.direct;\r\n\
+int x = Error(2);\r\n\
+return Error(-x);";
+TEST_RUNTIME_FAIL("External function call. Error handling [direct]", testExternalCallDirect3, "negative value -2");
+
 #if !defined(ANDROID)
 
 const char	*testFile = 
@@ -418,6 +418,39 @@ class Y{ char x; X v; char z; }\r\n\
 return sizeof(Y);";
 TEST_RESULT("Type padding for correct array element alignment 3", testAlignmentPadding3, "48");
 
+const char	*testAlignmentReorder =
+"import test.alignment;\r\n\
+align(auto) class X{ char a; double b; int c; char d; int ref e; short f; }\r\n\
+class Y{ char a; double b; int c; char d; int ref e; short f; }\r\n\
+X x; x.a = 1; x.b = 2; x.c = 3; x.d = 4; x.f = 6;\r\n\
+int k = 5; x.e = &k;\r\n\
+X ref z = new X; *z = x;\r\n\
+int sum = z.a + z.b + z.c + z.d + *z.e + z.f;\r\n\
+int aligned = CheckAlignment(&z.b, 8) + CheckAlignment(&z.c, 4) + CheckAlignment(&z.f, 2);\r\n\
+return sizeof(X) * 10000 + sizeof(Y) * 100 + sum * 10 + aligned;";
+TEST_RESULT("Class member reordering by alignment", testAlignmentReorder, "244213");
+
+const char	*testAlignmentReorder2 =
+"align(auto) class Base extendable{ char a; long b; int f(){ return a + b; } }\r\n\
+align(auto) class Derived : Base{ char c; double d; int f(){ return a + b + c + d; } }\r\n\
+align(auto) class Node<T>{ char tag; T value; char mark; Node<T> ref next; }\r\n\
+Derived ref y = new Derived;\r\n\
+Base ref x = y;\r\n\
+x.a = 1; x.b = 2;\r\n\
+y.c = 3; y.d = 4;\r\n\
+Node<double> n; n.tag = 5; n.value = 6; n.next = &n;\r\n\
+return x.f() * 1000 + sizeof(Derived) * 10 + n.next.tag + int(n.next.value) + sizeof(Node<double>) - 24;";
+TEST_RESULT("Class member reordering by alignment 2", testAlignmentReorder2, "10331");
+
+const char	*testAlignmentReorder3 =
+"import std.typeinfo;\r\n\
+align(auto) class X{ char a = 1; double b = a + 1; int c = b + 1; }\r\n\
+X x;\r\n\
+typeid t = typeof(x);\r\n\
+assert(t.memberName(0) == \"a\" && t.memberName(1) == \"b\" && t.memberName(2) == \"c\");\r\n\
+return x.a * 100 + int(x.b) * 10 + x.c;";
+TEST_RESULT("Class member reordering keeps declaration order for initialization", testAlignmentReorder3, "123");
+
 struct AlignedStruct
 {
 	char x;
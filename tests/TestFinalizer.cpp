@@ -227,3 +227,72 @@ for(int i = 0; i < 10; i++) new int(7);\r\n\
 \r\n\
 return *global;";
 TEST_RESULT_SIMPLE("Finalizer object ressurection test 4 (large array)", testFinalizerRessurection4, "13");
+
+void SetDeferredFinalizersTest(int enable)
+{
+	nullcSetDeferredFinalizers(enable);
+}
+
+int RunFinalizersTest(int microseconds)
+{
+	return nullcRunFinalizers(microseconds);
+}
+
+int PendingFinalizersTest()
+{
+	NULLCGCStatistics stats;
+	nullcGetGCStatistics(&stats);
+
+	return int(stats.finalizersPending);
+}
+
+LOAD_MODULE_BIND(test_finalizerdeferred, "func.finalizerdeferred", "void SetDeferredFinalizers(int enable); int RunFinalizers(int microseconds); int PendingFinalizers();")
+{
+	nullcBindModuleFunctionHelper("func.finalizerdeferred", SetDeferredFinalizersTest, "SetDeferredFinalizers", 0);
+	nullcBindModuleFunctionHelper("func.finalizerdeferred", RunFinalizersTest, "RunFinalizers", 0);
+	nullcBindModuleFunctionHelper("func.finalizerdeferred", PendingFinalizersTest, "PendingFinalizers", 0);
+}
+
+const char	*testFinalizerDeferred =
+"import func.finalizerdeferred;\r\n\
+import std.gc;\r\n\
+\r\n\
+int sum = 0;\r\n\
+\r\n\
+class Foo\r\n\
+{\r\n\
+	int a;\r\n\
+	int[] data;\r\n\
+}\r\n\
+\r\n\
+void Foo:finalize()\r\n\
+{\r\n\
+	sum += data[1];\r\n\
+}\r\n\
+\r\n\
+void test()\r\n\
+{\r\n\
+	for(int i = 0; i < 100; i++)\r\n\
+	{\r\n\
+		Foo ref x = new Foo;\r\n\
+		x.a = i;\r\n\
+		x.data = new int[2];\r\n\
+		x.data[1] = i + 1000;\r\n\
+	}\r\n\
+}\r\n\
+\r\n\
+SetDeferredFinalizers(1);\r\n\
+test();\r\n\
+GC.CollectMemory();\r\n\
+int afterCollect = sum;\r\n\
+int pending = PendingFinalizers();\r\n\
+\r\n\
+// Queued objects and the objects they reference are kept alive by the queue\r\n\
+for(int i = 0; i < 10000; i++) new int[8];\r\n\
+GC.CollectMemory();\r\n\
+\r\n\
+int finalized = RunFinalizers(0);\r\n\
+SetDeferredFinalizers(0);\r\n\
+\r\n\
+return afterCollect == 0 && pending >= 90 && finalized == pending && PendingFinalizers() == 0 && sum >= pending * 1000;";
+TEST_RESULT_SIMPLE("Deferred finalizers are run by the host [skip_c]", testFinalizerDeferred, "1");
@@ -583,3 +583,596 @@ assert(*a == 5);\r\n\
 assert(m == 6);\r\n\
 return 1;";
 TEST_RESULT_SIMPLE("GC execution when callstack is full of NULLC->C transitions", testGCWhenTransitions, "1");
+
+void SetNurserySizeGC(int size)
+{
+	nullcSetNurserySize(size);
+}
+
+LOAD_MODULE_BIND(test_gcnursery, "func.gcnursery", "void SetNurserySize(int size);")
+{
+	nullcBindModuleFunctionHelper("func.gcnursery", SetNurserySizeGC, "SetNurserySize", 0);
+}
+
+const char	*testGCNurseryLinkedStructures =
+"import func.gcnursery;\r\n\
+import std.gc;\r\n\
+SetNurserySize(64 * 1024);\r\n\
+class Node{ int value; Node ref next; int[] data; }\r\n\
+Node ref[] old = new Node ref[200];\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 20000; i++)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.value = i;\r\n\
+	n.data = new int[3];\r\n\
+	n.data[1] = i * 2;\r\n\
+	if(i % 100 == 0)\r\n\
+	{\r\n\
+		n.next = list;\r\n\
+		list = n;\r\n\
+	}\r\n\
+	old[i % 200] = n;\r\n\
+}\r\n\
+int sum = 0;\r\n\
+for(Node ref curr = list; curr; curr = curr.next)\r\n\
+{\r\n\
+	assert(curr.data[1] == curr.value * 2);\r\n\
+	sum += curr.value / 100;\r\n\
+}\r\n\
+for(int i = 0; i < 200; i++)\r\n\
+	assert(old[i].value == 19800 + i && old[i].data[1] == old[i].value * 2);\r\n\
+GC.CollectMemory();\r\n\
+SetNurserySize(0);\r\n\
+return sum;";
+TEST_RESULT_SIMPLE("Generational collection of linked structures [skip_c]", testGCNurseryLinkedStructures, "19900");
+
+const char	*testGCNurseryClosures =
+"import func.gcnursery;\r\n\
+import std.vector;\r\n\
+SetNurserySize(32 * 1024);\r\n\
+vector<int ref()> funcs;\r\n\
+for(int i = 0; i < 5000; i++)\r\n\
+{\r\n\
+	int ref x = new int(i);\r\n\
+	auto f = auto(){ return *x; };\r\n\
+	if(i % 50 == 0)\r\n\
+		funcs.push_back(f);\r\n\
+}\r\n\
+int sum = 0;\r\n\
+for(i in funcs)\r\n\
+	sum += i() / 50;\r\n\
+SetNurserySize(0);\r\n\
+return sum;";
+TEST_RESULT_SIMPLE("Generational collection with closures and host containers [skip_c]", testGCNurseryClosures, "4950");
+
+void SetMarkingSliceBudgetGC(int budget)
+{
+	nullcSetMarkingSliceBudget(budget);
+}
+
+LOAD_MODULE_BIND(test_gcincremental, "func.gcincremental", "void SetMarkingSliceBudget(int budget);")
+{
+	nullcBindModuleFunctionHelper("func.gcincremental", SetMarkingSliceBudgetGC, "SetMarkingSliceBudget", 0);
+}
+
+const char	*testGCIncrementalMarkingBarrier =
+"import func.gcincremental;\r\n\
+SetMarkingSliceBudget(1);\r\n\
+class Node{ int value; Node ref next; }\r\n\
+Node ref[] holder = new Node ref[20000];\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 20000; i++)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.value = i;\r\n\
+	n.next = list;\r\n\
+	list = n;\r\n\
+}\r\n\
+for(int i = 0; i < 20000; i++)\r\n\
+{\r\n\
+	holder[i] = list;\r\n\
+	list = list.next;\r\n\
+	holder[i].next = nullptr;\r\n\
+	for(int k = 0; k < 8; k++)\r\n\
+	{\r\n\
+		Node ref junk = new Node;\r\n\
+		junk.value = -1;\r\n\
+	}\r\n\
+}\r\n\
+int errors = 0;\r\n\
+for(int i = 0; i < 20000; i++)\r\n\
+{\r\n\
+	if(holder[i].value != 19999 - i)\r\n\
+		errors++;\r\n\
+}\r\n\
+SetMarkingSliceBudget(0);\r\n\
+return errors;";
+TEST_RESULT_SIMPLE("Incremental marking with objects moved between marked and unmarked objects [skip_c]", testGCIncrementalMarkingBarrier, "0");
+
+void SetMarkerThreadsGC(int count)
+{
+	nullcSetMarkerThreads(count);
+}
+
+LOAD_MODULE_BIND(test_gcparallel, "func.gcparallel", "void SetMarkerThreads(int count);")
+{
+	nullcBindModuleFunctionHelper("func.gcparallel", SetMarkerThreadsGC, "SetMarkerThreads", 0);
+}
+
+const char	*testGCParallelMarking =
+"import func.gcparallel;\r\n\
+import std.gc;\r\n\
+SetMarkerThreads(4);\r\n\
+class Node{ int value; Node ref left, right; int[] data; }\r\n\
+Node ref Build(int depth, int value)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.value = value;\r\n\
+	n.data = new int[2];\r\n\
+	n.data[0] = value * 3;\r\n\
+	if(depth)\r\n\
+	{\r\n\
+		n.left = Build(depth - 1, value * 2);\r\n\
+		n.right = Build(depth - 1, value * 2 + 1);\r\n\
+	}\r\n\
+	return n;\r\n\
+}\r\n\
+int Check(Node ref n)\r\n\
+{\r\n\
+	if(!n)\r\n\
+		return 0;\r\n\
+	assert(n.data[0] == n.value * 3);\r\n\
+	return 1 + Check(n.left) + Check(n.right);\r\n\
+}\r\n\
+Node ref[] trees = new Node ref[16];\r\n\
+for(int i = 0; i < 16; i++)\r\n\
+	trees[i] = Build(9, 1);\r\n\
+for(int i = 0; i < 16; i += 2)\r\n\
+	trees[i] = nullptr;\r\n\
+GC.CollectMemory();\r\n\
+for(int i = 0; i < 16; i += 2)\r\n\
+	trees[i] = Build(9, 1);\r\n\
+GC.CollectMemory();\r\n\
+int count = 0;\r\n\
+for(int i = 0; i < 16; i++)\r\n\
+	count += Check(trees[i]);\r\n\
+SetMarkerThreads(1);\r\n\
+return count;";
+TEST_RESULT_SIMPLE("Parallel marking of object trees [skip_c]", testGCParallelMarking, "16368");
+
+const char	*testGCInteriorPointers =
+"import std.gc;\r\n\
+int ref[] refs = new int ref[64];\r\n\
+for(int i = 0; i < 64; i++)\r\n\
+{\r\n\
+	int[] small = new int[1 + i % 8];\r\n\
+	int[] large = new int[200 + i * 50];\r\n\
+	small[small.size - 1] = i;\r\n\
+	large[large.size - 1] = i * 2;\r\n\
+	if(i % 2)\r\n\
+		refs[i] = &small[small.size - 1];\r\n\
+	else\r\n\
+		refs[i] = &large[large.size - 1];\r\n\
+}\r\n\
+GC.CollectMemory();\r\n\
+for(int i = 0; i < 64; i++)\r\n\
+	new int[300];\r\n\
+GC.CollectMemory();\r\n\
+int sum = 0;\r\n\
+for(int i = 0; i < 64; i++)\r\n\
+	sum += i % 2 ? *refs[i] : *refs[i] / 2;\r\n\
+return sum;";
+TEST_RESULT("GC keeps objects reachable through interior pointers", testGCInteriorPointers, "2016");
+
+const char	*testGCSizeClasses =
+"import std.gc;\r\n\
+GC.CollectMemory();\r\n\
+int before = GC.UsedMemory();\r\n\
+int ref Make(int i)\r\n\
+{\r\n\
+	int[] arr = new int[100 + i * i * 40];\r\n\
+	arr[arr.size - 1] = i;\r\n\
+	return &arr[arr.size - 1];\r\n\
+}\r\n\
+int ref[] refs = new int ref[40];\r\n\
+for(int i = 0; i < 40; i++)\r\n\
+	refs[i] = Make(i);\r\n\
+for(int k = 0; k < 20; k++)\r\n\
+{\r\n\
+	for(int i = 0; i < 40; i++)\r\n\
+		new int[100 + i * i * 40];\r\n\
+	GC.CollectMemory();\r\n\
+}\r\n\
+int sum = 0;\r\n\
+for(int i = 0; i < 40; i++)\r\n\
+	sum += *refs[i];\r\n\
+refs = nullptr;\r\n\
+GC.CollectMemory();\r\n\
+return sum == 780 && GC.UsedMemory() - before < 512 * 1024;";
+TEST_RESULT("GC medium size classes and large objects", testGCSizeClasses, "1");
+
+const char	*testGCPolicy =
+"import std.gc;\r\n\
+GC.SetPolicy(2.0, 64 * 1024 * 1024, 0);\r\n\
+int start = GC.Collections();\r\n\
+for(int i = 0; i < 4000; i++)\r\n\
+	new int[256];\r\n\
+int large = GC.Collections() - start;\r\n\
+GC.CollectMemory();\r\n\
+GC.SetPolicy(2.0, 256 * 1024, 0);\r\n\
+start = GC.Collections();\r\n\
+for(int i = 0; i < 4000; i++)\r\n\
+	new int[256];\r\n\
+int small = GC.Collections() - start;\r\n\
+GC.SetPolicy(2.0, 1024 * 1024, 0);\r\n\
+return large == 0 && small > 4 && GC.CollectionsPerSecond() >= 0.0;";
+TEST_RESULT("GC heap growth policy", testGCPolicy, "1");
+
+#ifdef _M_X64
+void SetGlobalMemoryLimitGC(long long limit)
+{
+	nullcSetGlobalMemoryLimit(limit);
+}
+
+LOAD_MODULE_BIND(test_gclarge, "func.gclarge", "void SetGlobalMemoryLimit(long limit);")
+{
+	nullcBindModuleFunctionHelper("func.gclarge", SetGlobalMemoryLimitGC, "SetGlobalMemoryLimit", 0);
+}
+
+const char	*testGCLargeHeapChurn =
+"import func.gclarge;\r\n\
+import std.gc;\r\n\
+SetGlobalMemoryLimit(4608l * 1024 * 1024);\r\n\
+long base = GC.UsedMemoryLong();\r\n\
+// Registers of global code are scanned conservatively and can keep the last array alive, so allocations are made by a function\r\n\
+bool Churn()\r\n\
+{\r\n\
+	char[] a, b;\r\n\
+	long total = 0;\r\n\
+	for(int i = 0; i < 18; i++)\r\n\
+	{\r\n\
+		a = b;\r\n\
+		b = new char[256 * 1024 * 1024];\r\n\
+		b[b.size - 1] = i;\r\n\
+		total += b.size;\r\n\
+	}\r\n\
+	return total > 4l * 1024 * 1024 * 1024 && a[a.size - 1] == 16 && b[b.size - 1] == 17;\r\n\
+}\r\n\
+bool ok = Churn();\r\n\
+GC.CollectMemory();\r\n\
+ok = ok && GC.UsedMemoryLong() - base < 1024 * 1024;\r\n\
+SetGlobalMemoryLimit(1024 * 1024 * 1024);\r\n\
+return ok;";
+TEST_RESULT_SIMPLE("GC heap accounting with a limit above 4Gb and more than 4Gb of churn [skip_c]", testGCLargeHeapChurn, "1");
+#endif
+
+int heapProfileReports = 0;
+
+void HeapProfileReportGC(void *context, const char *report)
+{
+	(void)context;
+	(void)report;
+
+	heapProfileReports++;
+}
+
+void EnableHeapProfilerGC(int enable)
+{
+	heapProfileReports = 0;
+
+	nullcSetEnableHeapProfiler(enable, NULL, enable ? HeapProfileReportGC : NULL);
+}
+
+bool CheckHeapProfileLine(const char *report, const char *name, unsigned long long allocations, unsigned long long minSurvivors, unsigned long long maxSurvivors)
+{
+	char pattern[64];
+	sprintf(pattern, "  %s\n", name);
+
+	const char *end = strstr(report, pattern);
+
+	if(!end)
+		return false;
+
+	const char *start = end;
+
+	while(start != report && start[-1] != '\n')
+		start--;
+
+	unsigned long long count = 0, bytes = 0, survived = 0, survivedBytes = 0;
+
+	if(sscanf(start, "%llu %llu %llu %llu", &count, &bytes, &survived, &survivedBytes) != 4)
+		return false;
+
+	return count == allocations && survived >= minSurvivors && survived <= maxSurvivors && bytes != 0;
+}
+
+int CheckHeapProfileGC()
+{
+	const char *report = nullcGetHeapProfileReport();
+
+	if(heapProfileReports == 0)
+		return 0;
+
+	// Stack is scanned conservatively, so a few dead objects might be retained
+	if(!CheckHeapProfileLine(report, "Node", 1000, 100, 110) || !CheckHeapProfileLine(report, "int[]", 10, 10, 10))
+		return 0;
+
+	// Allocation site is reported with the function that performed the allocation
+	const char *site = strstr(report, "MakeNode(");
+
+	if(!site)
+		return 0;
+
+	while(site != report && site[-1] != '\n')
+		site--;
+
+	unsigned long long count = 0;
+
+	return sscanf(site, "%llu", &count) == 1 && count == 1000;
+}
+
+LOAD_MODULE_BIND(test_gcprofile, "func.gcprofile", "void EnableHeapProfiler(int enable); int CheckHeapProfile();")
+{
+	nullcBindModuleFunctionHelper("func.gcprofile", EnableHeapProfilerGC, "EnableHeapProfiler", 0);
+	nullcBindModuleFunctionHelper("func.gcprofile", CheckHeapProfileGC, "CheckHeapProfile", 0);
+}
+
+const char	*testGCHeapProfiler =
+"import func.gcprofile;\r\n\
+import std.gc;\r\n\
+EnableHeapProfiler(1);\r\n\
+class Node{ int value; Node ref next; }\r\n\
+Node ref MakeNode(int value){ Node ref n = new Node; n.value = value; return n; }\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 1000; i++)\r\n\
+{\r\n\
+	Node ref n = MakeNode(i);\r\n\
+	if(i % 10 == 0)\r\n\
+	{\r\n\
+		n.next = list;\r\n\
+		list = n;\r\n\
+	}\r\n\
+}\r\n\
+int[][] arrays = new int[][10];\r\n\
+for(i in arrays)\r\n\
+	i = new int[16];\r\n\
+GC.CollectMemory();\r\n\
+int result = CheckHeapProfile();\r\n\
+EnableHeapProfiler(0);\r\n\
+return result;";
+TEST_RESULT_SIMPLE("Heap profiler statistics by type and allocation site [skip_c]", testGCHeapProfiler, "1");
+
+const char	*testGCCollectionStatistics =
+"import std.gc;\r\n\
+class Node{ int value; Node ref next; }\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 1000; i++)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.next = i % 2 == 0 ? list : nullptr;\r\n\
+	list = n;\r\n\
+}\r\n\
+GC.CollectMemory();\r\n\
+GCCollectionInfo info;\r\n\
+bool ok = GC.LastCollection(info);\r\n\
+ok = ok && info.bytesBefore >= info.bytesAfter && info.objectsFreed >= 400;\r\n\
+ok = ok && info.pauseTime >= 0.0 && info.markTime >= 0.0 && info.sweepTime >= 0.0 && info.finalizeTime >= 0.0;\r\n\
+long pauses = 0;\r\n\
+for(int i = 0; i < 16; i++)\r\n\
+	pauses += GC.PauseHistogram(i);\r\n\
+ok = ok && pauses >= 1 && GC.MaxPauseTime() >= info.pauseTime && GC.TotalPauseTime() >= GC.MaxPauseTime();\r\n\
+return ok;";
+TEST_RESULT("GC collection statistics", testGCCollectionStatistics, "1");
+
+int CheckGCStatisticsGC()
+{
+	NULLCGCStatistics stats;
+	nullcGetGCStatistics(&stats);
+
+	NULLCCollectionInfo history[4];
+	unsigned count = nullcGetGCCollectionHistory(history, 4);
+
+	if(stats.collections < 2 || count < 2)
+		return 0;
+
+	// Most recent collection is first
+	if(history[0].startTime < history[1].startTime || history[0].rootsScanned == 0)
+		return 0;
+
+	long long pauses = 0;
+
+	for(unsigned i = 0; i < NULLC_GC_PAUSE_BUCKETS; i++)
+		pauses += stats.pauseHistogram[i];
+
+	if(pauses != stats.collections + stats.minorCollections + stats.markingSlices)
+		return 0;
+
+	nullcResetGCStatistics();
+
+	nullcGetGCStatistics(&stats);
+
+	return stats.collections == 0 && nullcGetGCCollectionHistory(history, 4) == 0;
+}
+
+LOAD_MODULE_BIND(test_gcstatistics, "func.gcstatistics", "int CheckGCStatistics();")
+{
+	nullcBindModuleFunctionHelper("func.gcstatistics", CheckGCStatisticsGC, "CheckGCStatistics", 0);
+}
+
+const char	*testGCStatisticsHost =
+"import func.gcstatistics;\r\n\
+import std.gc;\r\n\
+int[] arr = new int[1024];\r\n\
+GC.CollectMemory();\r\n\
+arr = nullptr;\r\n\
+GC.CollectMemory();\r\n\
+return CheckGCStatistics();";
+TEST_RESULT_SIMPLE("GC statistics through the host API [skip_c]", testGCStatisticsHost, "1");
+
+const char	*testGCMemoryArena =
+"import std.memory;\r\n\
+import std.gc;\r\n\
+class Node{ int value; Node ref next; int[] data; }\r\n\
+memory.arena a = memory.arena_create();\r\n\
+int[] shared = new int[16];\r\n\
+shared[3] = 42;\r\n\
+memory.arena_enter(a);\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 10000; i++)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.value = i;\r\n\
+	n.next = list;\r\n\
+	n.data = new int[4];\r\n\
+	n.data[1] = i;\r\n\
+	list = n;\r\n\
+}\r\n\
+list.data = shared;\r\n\
+memory.arena_leave();\r\n\
+shared = nullptr;\r\n\
+long size = memory.arena_size(a);\r\n\
+for(int i = 0; i < 10000; i++) new int[16];\r\n\
+GC.CollectMemory();\r\n\
+for(int i = 0; i < 10000; i++)\r\n\
+{\r\n\
+	int[] x = new int[16];\r\n\
+	x[3] = 7;\r\n\
+}\r\n\
+int sum = 0;\r\n\
+for(Node ref n = list.next; n; n = n.next)\r\n\
+	sum += n.data[1] - n.value;\r\n\
+int r = list.data[3];\r\n\
+list = nullptr;\r\n\
+memory.arena_release(a);\r\n\
+return (sum == 0 && r == 42 && size > 10000 * 32) ? 1 : 0;";
+TEST_RESULT("Memory arena objects keep heap objects alive [skip_c]", testGCMemoryArena, "1");
+
+const char	*testGCMemoryArenaCards =
+"import std.memory;\r\n\
+import std.gc;\r\n\
+class Holder{ int[] data; }\r\n\
+GCCollectionInfo info;\r\n\
+GC.CollectMemory();\r\n\
+GC.LastCollection(info);\r\n\
+long before = info.rootsScanned;\r\n\
+memory.arena a = memory.arena_create();\r\n\
+memory.arena_enter(a);\r\n\
+Holder ref[] holders = new Holder ref[64];\r\n\
+for(int i = 0; i < 64; i++)\r\n\
+	holders[i] = new Holder;\r\n\
+for(int i = 0; i < 20000; i++)\r\n\
+	new int[8];\r\n\
+memory.arena_leave();\r\n\
+holders[40].data = new int[16];\r\n\
+holders[40].data[3] = 42;\r\n\
+for(int i = 0; i < 10000; i++) new int[16];\r\n\
+GC.CollectMemory();\r\n\
+GC.LastCollection(info);\r\n\
+long after = info.rootsScanned;\r\n\
+for(int i = 0; i < 10000; i++)\r\n\
+{\r\n\
+	int[] x = new int[16];\r\n\
+	x[3] = 7;\r\n\
+}\r\n\
+int r = holders[40].data[3];\r\n\
+holders = nullptr;\r\n\
+memory.arena_release(a);\r\n\
+// Only the arena objects that received pointers are checked\r\n\
+return (r == 42 && after - before < 1000) ? 1 : 0;";
+TEST_RESULT("Memory arena objects are checked only on the cards that received pointers [skip_c]", testGCMemoryArenaCards, "1");
+
+const char	*testGCMemoryArenaEscape =
+"import std.memory;\r\n\
+class Node\r\n\
+{\r\n\
+	int value;\r\n\
+}\r\n\
+memory.arena a = memory.arena_create(true);\r\n\
+memory.arena_enter(a);\r\n\
+Node ref n = new Node;\r\n\
+memory.arena_leave();\r\n\
+memory.arena_release(a);\r\n\
+return 1;";
+TEST_RUNTIME_FAIL("Memory arena escaping pointer check [skip_c]", testGCMemoryArenaEscape, "ERROR: 1 pointer(s) to the memory of a released arena are still reachable");
+
+const char	*testGCCompaction =
+"import std.gc;\r\n\
+class Node{ int value; Node ref next; int[] data; }\r\n\
+Node ref[] kept = new Node ref[1000];\r\n\
+Node ref list;\r\n\
+for(int i = 0; i < 32000; i++)\r\n\
+{\r\n\
+	Node ref n = new Node;\r\n\
+	n.value = i;\r\n\
+	n.data = new int[2];\r\n\
+	n.data[1] = i * 3;\r\n\
+	if(i % 32 == 0)\r\n\
+	{\r\n\
+		n.next = list;\r\n\
+		list = n;\r\n\
+		kept[i / 32] = n;\r\n\
+	}\r\n\
+}\r\n\
+GC.CollectMemory();\r\n\
+long before = GC.UsedMemoryLong();\r\n\
+GC.Compact();\r\n\
+GCCollectionInfo info;\r\n\
+GC.LastCollection(info);\r\n\
+int count = 0;\r\n\
+for(Node ref curr = list; curr; curr = curr.next)\r\n\
+{\r\n\
+	assert(curr.data[1] == curr.value * 3);\r\n\
+	assert(kept[curr.value / 32] == curr);\r\n\
+	count++;\r\n\
+}\r\n\
+return count == 1000 && info.objectsMoved > 0 && GC.UsedMemoryLong() <= before;";
+TEST_RESULT_SIMPLE("Heap compaction moves objects out of sparse pages [skip_c]", testGCCompaction, "1");
+
+const char	*testGCWeakReferences =
+"import std.gc;\r\n\
+class Node{ int value; }\r\n\
+Node ref a = new Node, b = new Node;\r\n\
+a.value = 1;\r\n\
+b.value = 2;\r\n\
+weak_ref<Node> wa = weak_ref<Node>(a), wb = weak_ref<Node>(b), empty;\r\n\
+weak_ref<Node> wa2 = weak_ref<Node>(a);\r\n\
+b = nullptr;\r\n\
+for(int i = 0; i < 1000; i++) new int[16];\r\n\
+GC.CollectMemory();\r\n\
+for(int i = 0; i < 1000; i++) new int[16];\r\n\
+GC.CollectMemory();\r\n\
+return wa.get() == a && wa2.get().value == 1 && wa.alive() && !wb.alive() && wb.get() == nullptr && empty.get() == nullptr;";
+TEST_RESULT("Weak references are cleared after their objects are freed [skip_c]", testGCWeakReferences, "1");
+
+const char	*testGCWeakHashmap =
+"import func.gcnursery;\r\n\
+import std.gc;\r\n\
+SetNurserySize(64 * 1024);\r\n\
+class Key{ int id; }\r\n\
+class Data{ int value; Key ref key; }\r\n\
+weak_hashmap<Key, Data> cache;\r\n\
+Key ref[] live = new Key ref[100];\r\n\
+for(int i = 0; i < 10000; i++)\r\n\
+{\r\n\
+	Key ref k = new Key;\r\n\
+	k.id = i;\r\n\
+	cache[k].value = i * 2;\r\n\
+	cache[k].key = k;\r\n\
+	if(i % 100 == 0)\r\n\
+		live[i / 100] = k;\r\n\
+}\r\n\
+GC.CollectMemory();\r\n\
+GC.CollectMemory();\r\n\
+int sum = 0;\r\n\
+for(int i = 0; i < 100; i++)\r\n\
+{\r\n\
+	auto d = cache.find(live[i]);\r\n\
+	assert(d && d.key == live[i]);\r\n\
+	sum += d.value;\r\n\
+}\r\n\
+cache.remove(live[0]);\r\n\
+int size = cache.size();\r\n\
+SetNurserySize(0);\r\n\
+return size < 200 && !cache.find(live[0]) && sum == 990000 ? 1 : 0;";
+TEST_RESULT_SIMPLE("Weak hashmap entries are removed with their keys [skip_c]", testGCWeakHashmap, "1");
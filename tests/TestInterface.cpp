@@ -5,8 +5,25 @@
 #include "../NULLC/nullc_debug.h"
 #include "../NULLC/Array.h"
 
+#if defined(__linux)
+	#include <signal.h>
+#endif
+
 bool	initialized;
 
+#if defined(__linux)
+volatile sig_atomic_t hostSignalCount = 0;
+
+void HostSignalHandler(int signum, siginfo_t *info, void *ucontext)
+{
+	(void)signum;
+	(void)info;
+	(void)ucontext;
+
+	hostSignalCount++;
+}
+#endif
+
 #define TEST_COMPARE(test, result)\
 	testsCount[TEST_TYPE_EXTRA]++;\
 	if((test) != result)\
@@ -539,6 +556,320 @@ void RunInterfaceTests()
 		}
 	}
 
+	if(Tests::messageVerbose)
+		printf("nullcRunFunction in a call session test\r\n");
+
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+		testsCount[t]++;
+		nullcSetExecutor(testTarget[t]);
+		if(!nullcBuild("int sum = 0; int add(int x){ sum += x; return sum; } int div(int x){ return 10 / x; }") || !nullcRun())
+		{
+			printf("Build failed:%s\n", nullcGetLastError());
+			continue;
+		}
+
+		if(!nullcBeginCallSession())
+		{
+			printf("Call session failed: %s\n", nullcGetLastError());
+			continue;
+		}
+
+		bool passed = true;
+
+		for(int i = 1; i <= 100 && passed; i++)
+		{
+			if(!nullcRunFunction("add", i) || nullcGetResultInt() != i * (i + 1) / 2)
+				passed = false;
+		}
+
+		// Execution errors are reported and the session stays usable
+		for(int i = 0; i < 2 && passed; i++)
+		{
+			if(nullcRunFunction("div", 0) || !strstr(nullcGetLastError(), "integer division by zero"))
+				passed = false;
+
+			if(!nullcRunFunction("div", 5) || nullcGetResultInt() != 2)
+				passed = false;
+		}
+
+		nullcEndCallSession();
+
+		if(passed && nullcRunFunction("add", 0) && nullcGetResultInt() == 5050)
+			testsPassed[t]++;
+		else
+			printf("nullcRunFunction in a call session failed: %s\n", nullcGetLastError());
+	}
+
+#if defined(__linux)
+	if(Tests::messageVerbose)
+		printf("Host signal handler in a call session\r\n");
+
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+		testsCount[t]++;
+		nullcSetExecutor(testTarget[t]);
+		if(!nullcBuild("int div(int x){ return 10 / x; }") || !nullcRun())
+		{
+			printf("Build failed:%s\n", nullcGetLastError());
+			continue;
+		}
+
+		struct sigaction hostAction;
+		struct sigaction oldAction;
+
+		memset(&hostAction, 0, sizeof(hostAction));
+		hostAction.sa_sigaction = HostSignalHandler;
+		sigemptyset(&hostAction.sa_mask);
+		hostAction.sa_flags = SA_SIGINFO;
+
+		sigaction(SIGFPE, &hostAction, &oldAction);
+
+		hostSignalCount = 0;
+
+		bool passed = nullcBeginCallSession();
+
+		// Signals raised outside of NULLC code are passed to the handler of the host
+		raise(SIGFPE);
+
+		if(hostSignalCount != 1)
+			passed = false;
+
+		if(nullcRunFunction("div", 0) || !strstr(nullcGetLastError(), "integer division by zero") || hostSignalCount != 1)
+			passed = false;
+
+		nullcEndCallSession();
+
+		sigaction(SIGFPE, &oldAction, NULL);
+
+		if(passed)
+			testsPassed[t]++;
+		else
+			printf("Host signal handler in a call session failed (%d signals): %s\n", int(hostSignalCount), nullcGetLastError());
+	}
+#endif
+
+	if(Tests::messageVerbose)
+		printf("Memory arena scope after an execution error\r\n");
+
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+		testsCount[t]++;
+		nullcSetExecutor(testTarget[t]);
+		if(!nullcBuild("import std.memory; memory.arena a = memory.arena_create(); int fail(int x){ memory.arena_enter(a); new int[16]; return 10 / x; } long alloc(){ new int[16]; return memory.arena_size(a); }") || !nullcRun())
+		{
+			printf("Build failed:%s\n", nullcGetLastError());
+			continue;
+		}
+
+		bool passed = true;
+
+		if(nullcRunFunction("fail", 0))
+			passed = false;
+
+		// Allocations after the failed call must not go to the arena that the call has entered
+		long long size = 0;
+
+		for(int i = 0; i < 4 && passed; i++)
+		{
+			if(!nullcRunFunction("alloc"))
+				passed = false;
+			else if(i == 0)
+				size = nullcGetResultLong();
+			else if(nullcGetResultLong() != size)
+				passed = false;
+		}
+
+		if(passed)
+			testsPassed[t]++;
+		else
+			printf("Memory arena scope after an execution error failed: %s\n", nullcGetLastError());
+	}
+
+	if(Tests::messageVerbose)
+		printf("Program snapshot save and load\r\n");
+
+	{
+		const char *code =
+"import std.vector;\r\n\
+class Node{ int value; Node ref next; int[] data; }\r\n\
+Node ref list;\r\n\
+vector<int> values;\r\n\
+int g = 5;\r\n\
+int ref pg = &g;\r\n\
+auto ref boxed = new int(42);\r\n\
+auto make(int start){ int x = start; return auto(){ x++; return x; }; }\r\n\
+int ref() gen = make(10);\r\n\
+for(int i = 0; i < 10; i++){ Node ref n = new Node; n.value = i; n.next = list; n.data = new int[i + 1]; n.data[i] = i * 2; list = n; values.push_back(i); }\r\n\
+int check(){ int sum = 0; for(Node ref n = list; n; n = n.next) sum += n.value + n.data[n.value] + values[n.value]; *pg += 1; return sum * 1000 + g * 100 + int(boxed) + gen(); }\r\n\
+return check();";
+
+		for(int t = 0; t < TEST_TARGET_COUNT; t++)
+		{
+			if(!Tests::testExecutor[t])
+				continue;
+			testsCount[t]++;
+			nullcSetExecutor(testTarget[t]);
+
+			nullcSetEnableSnapshots(true);
+
+			bool built = nullcBuild(code) && nullcRun();
+
+			nullcSetEnableSnapshots(false);
+
+			if(!built)
+			{
+				printf("Program snapshot build failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			char *snapshot = NULL;
+			unsigned size = nullcSaveSnapshot(&snapshot);
+			if(!size)
+			{
+				printf("Program snapshot save failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			// Damaged snapshots are rejected and the current program stays linked
+			bool rejected = !nullcLoadSnapshot(snapshot, size - 1) && !nullcLoadSnapshot(snapshot, 16);
+
+			char *damaged = new char[size];
+			memcpy(damaged, snapshot, size);
+
+			// Size of the first module bytecode follows its name, which follows a header of ten unsigned fields
+			char *moduleSize = damaged + 10 * sizeof(unsigned) + strlen(damaged + 10 * sizeof(unsigned)) + 1;
+			memset(moduleSize, 0xff, sizeof(unsigned));
+
+			rejected = rejected && !nullcLoadSnapshot(damaged, size) && strcmp(nullcGetLastError(), "ERROR: snapshot is corrupted") == 0;
+
+			delete[] damaged;
+
+			if(!rejected || !nullcRunFunction("check"))
+			{
+				printf("Program snapshot corruption check failed: %s\r\n", nullcGetLastError());
+				delete[] snapshot;
+				continue;
+			}
+
+			nullcClean();
+
+			if(!nullcLoadSnapshot(snapshot, size))
+			{
+				printf("Program snapshot load failed: %s\r\n", nullcGetLastError());
+				delete[] snapshot;
+				continue;
+			}
+			delete[] snapshot;
+
+			if(!nullcRunFunction("check"))
+			{
+				printf("Program snapshot execution failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			if(nullcGetResultInt() != 180754)
+			{
+				printf("Program snapshot check returned %d instead of 180754\r\n", nullcGetResultInt());
+				continue;
+			}
+
+			testsPassed[t]++;
+		}
+	}
+
+	if(Tests::messageVerbose)
+		printf("Batch function calls\r\n");
+
+	{
+		const char *code = "int calls = 0; class Pair{ int a; int b; } Pair f(int x, char y){ calls++; Pair p; p.a = x * x + y; p.b = calls; return p; } int g(int x){ return 10 / x; } int[] h(int x){ return new int[x]; }";
+
+		struct Input{ int x, y; };
+		struct Result{ int a, b; };
+
+		const unsigned count = 37;
+
+		Input inputs[count];
+		Result results[count];
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			inputs[i].x = int(i);
+			inputs[i].y = 3;
+		}
+
+		for(int t = 0; t < TEST_TARGET_COUNT; t++)
+		{
+			if(!Tests::testExecutor[t])
+				continue;
+			testsCount[t]++;
+			nullcSetExecutor(testTarget[t]);
+
+			if(!nullcBuild(code) || !nullcRun())
+			{
+				printf("Batch function build failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			memset(results, 0, sizeof(results));
+
+			if(!nullcRunBatch("f", inputs, results, count))
+			{
+				printf("Batch function call failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			bool success = true;
+
+			// Calls are made one after the other and keep their changes to the global state
+			for(unsigned i = 0; i < count && success; i++)
+			{
+				if(results[i].a != int(i * i + 3) || results[i].b != int(i + 1))
+				{
+					printf("Batch function result %d is %d, %d\r\n", i, results[i].a, results[i].b);
+					success = false;
+				}
+			}
+
+			if(!success)
+				continue;
+
+			int divisors[count];
+			int quotients[count];
+
+			for(unsigned i = 0; i < count; i++)
+				divisors[i] = i + 1;
+
+			if(!nullcRunBatch("g", divisors, quotients, count) || quotients[9] != 1)
+			{
+				printf("Batch function call failed: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			divisors[20] = 0;
+
+			if(nullcRunBatch("g", divisors, quotients, count) || !strstr(nullcGetLastError(), "division by zero"))
+			{
+				printf("Batch function error wasn't reported: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			if(nullcRunBatch("h", divisors, quotients, count) || strcmp(nullcGetLastError(), "ERROR: batch function result can't contain pointers") != 0)
+			{
+				printf("Batch function pointer result wasn't rejected: %s\r\n", nullcGetLastError());
+				continue;
+			}
+
+			testsPassed[t]++;
+		}
+	}
+
 	if(Tests::messageVerbose)
 		printf("Type constant check\r\n");
 
@@ -1,5 +1,13 @@
 #include "TestBase.h"
 
+#include "../NULLC/StrAlgo.h"
+
+#if defined(__linux)
+#include <unistd.h>
+#include <dirent.h>
+#include <stdlib.h>
+#endif
+
 const char *testJiTError1 = 
 "void median3(int first, middle, last)\r\n\
 {\r\n\
@@ -76,3 +84,254 @@ char[16] board;\r\n\
 board = make_move(board, 1, 0);\r\n\
 return board[0];";
 TEST_RESULT("Test for JiT error 7 (extended byte move registers)", testJiTError7, "1");
+
+const char *testNativeCodeCacheCode =
+"class Point{ int x, y; }\r\n\
+int sum(int[] arr){ int s = 0; for(i in arr) s += i; return s; }\r\n\
+Point ref pt = new Point;\r\n\
+pt.x = 3; pt.y = 4;\r\n\
+auto ref p = pt;\r\n\
+Point ref q = p;\r\n\
+int[] arr = { 1, 2, 3, 4 };\r\n\
+double d = 7.5 % 2.0;\r\n\
+long l = 3l ** 3;\r\n\
+return sum(arr) + q.x * q.y + 2 ** 3 + int(d * 2) + int(l);";
+
+#if defined(__linux)
+
+struct TestNativeCodeCache : TestQueue
+{
+	static void RemoveCacheDirectory(const char *path)
+	{
+		if(DIR *dir = opendir(path))
+		{
+			while(dirent *entry = readdir(dir))
+			{
+				if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+					continue;
+
+				char name[1024];
+				NULLC::SafeSprintf(name, 1024, "%s/%s", path, entry->d_name);
+				unlink(name);
+			}
+
+			closedir(dir);
+		}
+
+		rmdir(path);
+	}
+
+	static unsigned CountTemporaryFiles(const char *path)
+	{
+		unsigned count = 0;
+
+		if(DIR *dir = opendir(path))
+		{
+			while(dirent *entry = readdir(dir))
+			{
+				unsigned length = unsigned(strlen(entry->d_name));
+
+				if(length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0)
+					count++;
+			}
+
+			closedir(dir);
+		}
+
+		return count;
+	}
+
+	virtual void Run()
+	{
+		for(int t = 0; t < TEST_TARGET_COUNT; t++)
+		{
+			if(!Tests::testExecutor[t] || testTarget[t] != NULLC_X86)
+				continue;
+
+			char path[] = "/tmp/nullc_cache_XXXXXX";
+
+			if(!mkdtemp(path))
+				continue;
+
+			if(!nullcSetNativeCodeCachePath(path))
+			{
+				RemoveCacheDirectory(path);
+				continue;
+			}
+
+			// First build stores native code in the cache and the second one restores it from there
+			for(unsigned i = 0; i < 2; i++)
+			{
+				unsigned hits = nullcGetNativeCodeCacheHits();
+
+				testsCount[t]++;
+				if(Tests::RunCodeSimple(testNativeCodeCacheCode, testTarget[t], "60", "Native code cache", false, ""))
+				{
+					if(nullcGetNativeCodeCacheHits() == hits + i)
+						testsPassed[t]++;
+					else
+						printf("Native code cache: build %d loaded from the cache %d times\n", i + 1, nullcGetNativeCodeCacheHits() - hits);
+				}
+			}
+
+			nullcSetNativeCodeCachePath(NULL);
+
+			// Cache files are written under a temporary name first, none of them should remain
+			testsCount[t]++;
+			if(CountTemporaryFiles(path) == 0)
+				testsPassed[t]++;
+			else
+				printf("Native code cache: temporary files were left in the cache directory\n");
+
+			RemoveCacheDirectory(path);
+		}
+	}
+};
+TestNativeCodeCache testNativeCodeCache;
+
+#endif
+
+#if defined(__linux)
+
+const char *testPerfOutputCode =
+"int perfTestFunction(int x){ return x * 2; }\r\n\
+return perfTestFunction(21);";
+
+struct TestPerfOutput : TestQueue
+{
+	virtual void Run()
+	{
+		for(int t = 0; t < TEST_TARGET_COUNT; t++)
+		{
+			if(!Tests::testExecutor[t] || testTarget[t] != NULLC_X86)
+				continue;
+
+			nullcSetEnablePerfOutput(1, 1);
+
+			testsCount[t]++;
+			bool passed = Tests::RunCodeSimple(testPerfOutputCode, testTarget[t], "42", "Perf map and jitdump output", false, "");
+
+			nullcSetEnablePerfOutput(0, 0);
+
+			char perfMapName[64];
+			sprintf(perfMapName, "/tmp/perf-%d.map", int(getpid()));
+
+			char jitDumpName[64];
+			sprintf(jitDumpName, "/tmp/jit-%d.dump", int(getpid()));
+
+			char perfMap[4096] = { 0 };
+
+			if(FILE *perfMapFile = fopen(perfMapName, "rb"))
+			{
+				(void)fread(perfMap, 1, sizeof(perfMap) - 1, perfMapFile);
+
+				fclose(perfMapFile);
+			}
+
+			if(!strstr(perfMap, " perfTestFunction\n"))
+			{
+				printf("Perf map doesn't contain the test function\n");
+				passed = false;
+			}
+
+			if(FILE *jitDump = fopen(jitDumpName, "rb"))
+			{
+				unsigned magic = 0;
+
+				if(fread(&magic, sizeof(magic), 1, jitDump) != 1 || magic != 0x4A695444)
+				{
+					printf("Jitdump file header is invalid\n");
+					passed = false;
+				}
+
+				fclose(jitDump);
+			}
+			else
+			{
+				printf("Jitdump file wasn't created\n");
+				passed = false;
+			}
+
+			remove(perfMapName);
+			remove(jitDumpName);
+
+			if(passed)
+				testsPassed[t]++;
+		}
+	}
+};
+TestPerfOutput testPerfOutput;
+
+#endif
+
+#if defined(__linux) && defined(_M_X64) && !defined(NULLC_LLVM_SUPPORT)
+
+extern "C"
+{
+	struct jit_code_entry
+	{
+		jit_code_entry *next_entry;
+		jit_code_entry *prev_entry;
+		const char *symfile_addr;
+		unsigned long long symfile_size;
+	};
+
+	struct jit_descriptor
+	{
+		unsigned version;
+		unsigned action_flag;
+		jit_code_entry *relevant_entry;
+		jit_code_entry *first_entry;
+	};
+
+	extern jit_descriptor __jit_debug_descriptor;
+}
+
+const char *testJitDebugInfoCode =
+"int gdbTestFunction(int x){ return x * 3; }\r\n\
+return gdbTestFunction(14);";
+
+struct TestJitDebugInfo : TestQueue
+{
+	virtual void Run()
+	{
+		for(int t = 0; t < TEST_TARGET_COUNT; t++)
+		{
+			if(!Tests::testExecutor[t] || testTarget[t] != NULLC_X86)
+				continue;
+
+			nullcSetEnableJitDebugInfo(1);
+
+			testsCount[t]++;
+			bool passed = Tests::RunCodeSimple(testJitDebugInfoCode, testTarget[t], "42", "GDB JIT interface registration", false, "");
+
+			bool found = false;
+
+			for(jit_code_entry *entry = __jit_debug_descriptor.first_entry; entry; entry = entry->next_entry)
+			{
+				if(entry->symfile_size < 4 || memcmp(entry->symfile_addr, "\x7f" "ELF", 4) != 0)
+					continue;
+
+				for(unsigned i = 0; i + 16 <= entry->symfile_size && !found; i++)
+				{
+					if(memcmp(entry->symfile_addr + i, "gdbTestFunction", 16) == 0)
+						found = true;
+				}
+			}
+
+			if(!found)
+			{
+				printf("GDB JIT interface doesn't have an object file with the test function\n");
+				passed = false;
+			}
+
+			nullcSetEnableJitDebugInfo(0);
+
+			if(passed)
+				testsPassed[t]++;
+		}
+	}
+};
+TestJitDebugInfo testJitDebugInfo;
+
+#endif
@@ -841,6 +841,155 @@ auto arr = \r\n\
 
 	delete[] tmp;
 
+	const char	*testHostCallSpeed = "int callback(int x){ return x + 1; }";
+
+	printf("Host to script calls\r\n");
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+
+		nullcSetExecutor(testTarget[t]);
+
+		NULLCFuncPtr callback;
+
+		if(!nullcBuild(testHostCallSpeed) || !nullcRun() || !nullcGetFunction("callback", &callback))
+		{
+			printf("Host to script calls failed: %s\r\n", nullcGetLastError());
+			continue;
+		}
+
+		const unsigned callCount = 1000000;
+
+		// Results of calls through a function pointer are checked against calls by function name
+		long long expected = 0;
+
+		double runStart = myGetPreciseTime();
+		for(unsigned i = 0; i < callCount; i++)
+		{
+			if(!nullcRunFunction("callback", int(i)))
+			{
+				printf("Host to script calls failed: %s\r\n", nullcGetLastError());
+				break;
+			}
+
+			expected += nullcGetResultInt();
+		}
+		double runTime = myGetPreciseTime() - runStart;
+
+		printf("%s run function: %.1f ns per call (%lld)\r\n", testTarget[t] == NULLC_X86 ? "X86" : (testTarget[t] == NULLC_LLVM ? "LLVM" : "REGVM"), runTime * 1000000.0 / callCount, expected);
+
+		// Compare calls with full execution environment setup to calls inside a call session
+		for(unsigned session = 0; session < 2; session++)
+		{
+			if(session && !nullcBeginCallSession())
+				break;
+
+			testsCount[t]++;
+
+			long long sum = 0;
+
+			double tStart = myGetPreciseTime();
+			for(unsigned i = 0; i < callCount; i++)
+			{
+				nullcCallFunction(callback, int(i));
+				sum += nullcGetResultInt();
+			}
+			double time = myGetPreciseTime() - tStart;
+
+			printf("%s %s: %.1f ns per call (%lld)\r\n", testTarget[t] == NULLC_X86 ? "X86" : (testTarget[t] == NULLC_LLVM ? "LLVM" : "REGVM"), session ? "call session" : "separate calls", time * 1000000.0 / callCount, sum);
+
+			if(sum == expected)
+				testsPassed[t]++;
+			else
+				printf("%s %s: result %lld doesn't match nullcRunFunction result %lld\r\n", testTarget[t] == NULLC_X86 ? "X86" : (testTarget[t] == NULLC_LLVM ? "LLVM" : "REGVM"), session ? "call session" : "separate calls", sum, expected);
+		}
+
+		nullcEndCallSession();
+	}
+
+	// Pointer stores are followed by a write barrier that has to be skipped cheaply while generational and incremental collection are disabled
+	const char	*testWriteBarrierPointerStores = "class Node{ Node ref next; } Node ref[] arr = new Node ref[1023]; Node ref n = new Node; for(int k = 0; k < 50000; k++) for(int i = 0; i < 1023; i++) arr[i] = n; return 1;";
+	const char	*testWriteBarrierIntegerStores = "int[] arr = new int[1023]; int n = 5; for(int k = 0; k < 50000; k++) for(int i = 0; i < 1023; i++) arr[i] = n; return 1;";
+
+	printf("Write barrier overhead\r\n");
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+
+		testsCount[t]++;
+
+		double tStart = myGetPreciseTime();
+		bool passed = Tests::RunCodeSimple(testWriteBarrierPointerStores, testTarget[t], "1", "Write barrier pointer stores", false, "");
+		double pointerTime = myGetPreciseTime() - tStart;
+
+		tStart = myGetPreciseTime();
+		passed &= Tests::RunCodeSimple(testWriteBarrierIntegerStores, testTarget[t], "1", "Write barrier integer stores", false, "");
+		double integerTime = myGetPreciseTime() - tStart;
+
+		printf("%s pointer stores %f, integer stores %f\r\n", testTarget[t] == NULLC_X86 ? "X86" : (testTarget[t] == NULLC_LLVM ? "LLVM" : "REGVM"), pointerTime, integerTime);
+
+		if(passed && pointerTime < integerTime * 1.25)
+			testsPassed[t]++;
+	}
+
+	const char	*testBatchSpeed = "int collatz(int x){ int steps = 0; for(int i = 0; i < 1000; i++){ long n = x + i; while(n != 1){ n = n % 2 == 0 ? n / 2 : n * 3 + 1; steps++; } } return steps; }";
+
+	printf("Batch calls\r\n");
+	for(int t = 0; t < TEST_TARGET_COUNT; t++)
+	{
+		if(!Tests::testExecutor[t])
+			continue;
+
+		testsCount[t]++;
+
+		nullcSetExecutor(testTarget[t]);
+
+		if(!nullcBuild(testBatchSpeed) || !nullcRun())
+		{
+			printf("Batch calls failed: %s\r\n", nullcGetLastError());
+			continue;
+		}
+
+		const unsigned inputCount = 4096;
+
+		int *inputs = new int[inputCount];
+		int *results = new int[inputCount];
+
+		for(unsigned i = 0; i < inputCount; i++)
+			inputs[i] = int(i + 1);
+
+		double tStart = myGetPreciseTime();
+		bool passed = nullcRunBatch("collatz", inputs, results, inputCount) != 0;
+		double batchTime = myGetPreciseTime() - tStart;
+
+		// Batch results have to match separate calls by function name
+		tStart = myGetPreciseTime();
+		for(unsigned i = 0; i < inputCount && passed; i++)
+		{
+			if(!nullcRunFunction("collatz", inputs[i]))
+				passed = false;
+			else if(nullcGetResultInt() != results[i])
+			{
+				printf("Batch call %d result %d doesn't match nullcRunFunction result %d\r\n", i, results[i], nullcGetResultInt());
+				passed = false;
+			}
+		}
+		double separateTime = myGetPreciseTime() - tStart;
+
+		if(!passed)
+			printf("Batch calls failed: %s\r\n", nullcGetLastError());
+
+		printf("%s batch: %f, separate calls: %f (%d)\r\n", testTarget[t] == NULLC_X86 ? "X86" : (testTarget[t] == NULLC_LLVM ? "LLVM" : "REGVM"), batchTime, separateTime, results[inputCount - 1]);
+
+		if(passed)
+			testsPassed[t]++;
+
+		delete[] inputs;
+		delete[] results;
+	}
+
 #endif
 
 #ifdef SPEED_TEST_EXTRA
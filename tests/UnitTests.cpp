@@ -260,6 +260,7 @@ int RunTests(bool verbose, const char* (*fileLoadFunc)(const char*, unsigned*),
 
 	nullcInitTypeinfoModule();
 	nullcInitDynamicModule();
+	nullcInitMemoryModule();
 
 	RunInterfaceTests();
 	RunUtilityTests();